@@ -40,6 +40,7 @@ Package::open(const std::filesystem::path& path)
     }
 
     stack.clear();
+    nodes_linker.thaw();
 
     Path& top = hierarchy.alloc();
     ID top_id = hierarchy.get_id(top);
@@ -91,6 +92,10 @@ Package::open(const std::filesystem::path& path)
             }
         }
     }
+
+    // The hierarchy is read at each frame: the links are frozen until the
+    // next package.
+    nodes_linker.freeze();
 }
 
 void
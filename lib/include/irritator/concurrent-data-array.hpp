@@ -0,0 +1,502 @@
+// Copyright (c) 2019 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef ORG_VLEPROJECT_IRRITATOR_CONCURRENT_DATA_ARRAY_HPP
+#define ORG_VLEPROJECT_IRRITATOR_CONCURRENT_DATA_ARRAY_HPP
+
+#include <irritator/data-array.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <cassert>
+#include <cstdint>
+
+namespace irr {
+
+/**
+ * @brief A fixed size data_array where several threads alloc, free and
+ * get items at the same time without lock.
+ * @details
+ * - the free list is a stack of indices whose head is tagged with a
+ *   counter (no ABA problem), the never used entries are reserved by
+ *   blocks with a compare-and-swap on @c max_used
+ * - a @c cache by thread keeps some free indices: alloc and free touch the
+ *   shared heads once for @c cache_size items
+ * - each entry keeps its own key, incremented at each alloc: an identifier
+ *   of a freed item is rejected by @c try_to_get until the key wraps
+ *
+ * The identifiers are atomics stored apart from the items. An alloc
+ * constructs the item then publishes its identifier, a free retracts the
+ * identifier then destroys the item: a @c try_to_get concurrent with an
+ * alloc returns a constructed item or nullptr. Using an item while another
+ * thread frees it is not protected, the caller must order the two.
+ *
+ * A free entry stores the index of the next entry in its identifier (the
+ * index plus one): the identifiers of the items are the only ones with
+ * their own index.
+ *
+ * @tparam T The type of object the concurrent_data_array holds.
+ * @tparam Identifier The type of the identifiers (@c ID or @c WID).
+ * @tparam Split The split of the identifiers in index and key, the
+ * capacity is at most @c Split::max_size().
+ */
+template<typename T,
+         typename Identifier,
+         typename Split = default_id_split<Identifier>>
+class concurrent_data_array
+{
+    static_assert(std::is_nothrow_destructible<T>::value,
+                  "concurrent_data_array needs a nothrow destructor");
+    static_assert(std::is_same<typename Split::identifier_type,
+                               Identifier>::value,
+                  "concurrent_data_array needs a split of its identifier "
+                  "type");
+
+public:
+    using identifier_type = Identifier;
+    using value_type = T;
+    using split_type = Split;
+
+    /// The number of indices moved at once between a cache and the array.
+    static constexpr int cache_size = 32;
+
+    /**
+     * @brief The free indices of a thread.
+     * @details A cache is used by one thread at a time. Its indices return
+     * to the array with @c flush() or its destructor.
+     */
+    class cache
+    {
+    public:
+        explicit cache(concurrent_data_array& array) noexcept
+          : m_array(&array)
+        {}
+
+        cache(const cache&) = delete;
+        cache& operator=(const cache&) = delete;
+
+        ~cache() noexcept
+        {
+            flush();
+        }
+
+        void flush() noexcept
+        {
+            if (m_number > 0)
+                m_array->push(m_indices, m_number);
+
+            m_number = 0;
+        }
+
+    private:
+        friend concurrent_data_array;
+
+        concurrent_data_array* m_array;
+        int m_indices[2 * cache_size];
+        int m_number = 0;
+    };
+
+    concurrent_data_array() noexcept = default;
+
+    concurrent_data_array(const concurrent_data_array&) = delete;
+    concurrent_data_array& operator=(const concurrent_data_array&) = delete;
+
+    ~concurrent_data_array() noexcept
+    {
+        clear();
+    }
+
+    /**
+     * @brief Allocates the entries, not thread safe.
+     *
+     * @return false if capacity_ is not in [0..Split::max_size()].
+     */
+    bool init(int capacity_)
+    {
+        clear();
+
+        if (capacity_ < 0 || capacity_ > Split::max_size())
+            return false;
+
+        m_items = static_cast<T*>(::operator new(
+          sizeof(T) * capacity_, std::align_val_t(alignof(T))));
+        m_ids = new std::atomic<Identifier>[capacity_];
+        m_next = new std::atomic<int>[capacity_];
+
+        for (int i = 0; i != capacity_; ++i) {
+            m_ids[i].store(Split::make_id(0u, i + 1),
+                           std::memory_order_relaxed);
+            m_next[i].store(-1, std::memory_order_relaxed);
+        }
+
+        m_capacity = capacity_;
+        m_max_used.store(0);
+        m_free_head.store(0);
+
+        return true;
+    }
+
+    /**
+     * @brief Destroys the items and frees the entries, not thread safe.
+     */
+    void clear() noexcept
+    {
+        if (m_items) {
+            const auto used = m_max_used.load();
+            for (int i = 0; i != used; ++i)
+                if (is_item(i, m_ids[i].load(std::memory_order_relaxed)))
+                    m_items[i].~T();
+
+            ::operator delete(m_items, std::align_val_t(alignof(T)));
+        }
+
+        delete[] m_ids;
+        delete[] m_next;
+
+        m_items = nullptr;
+        m_ids = nullptr;
+        m_next = nullptr;
+        m_capacity = 0;
+        m_max_used.store(0);
+        m_free_head.store(0);
+    }
+
+    /**
+     * @brief Constructs an item, thread safe. If the constructor of @c T
+     * throws, the index goes back to the free list.
+     *
+     * @return nullptr if the array is full.
+     */
+    template<typename... Args>
+    T* alloc(Args&&... args)
+    {
+        int index;
+
+        if (pop(&index, 1) == 0 && reserve(&index, 1) == 0)
+            return nullptr;
+
+        index_guard guard([this, &index]() noexcept { push(&index, 1); });
+        auto* t = construct(index, std::forward<Args>(args)...);
+        guard.dismiss();
+
+        return t;
+    }
+
+    /**
+     * @brief Constructs an item with an index of the @c cache of the
+     * thread, thread safe. If the constructor of @c T throws, the index
+     * goes back to the cache.
+     *
+     * @return nullptr if the array is full.
+     */
+    template<typename... Args>
+    T* alloc(cache& c, Args&&... args)
+    {
+        assert(c.m_array == this);
+
+        if (c.m_number == 0) {
+            c.m_number = pop(c.m_indices, cache_size);
+            if (c.m_number == 0) {
+                c.m_number = reserve(c.m_indices, cache_size);
+                if (c.m_number == 0)
+                    return nullptr;
+            }
+        }
+
+        const auto index = c.m_indices[--c.m_number];
+
+        index_guard guard([&c]() noexcept { ++c.m_number; });
+        auto* t = construct(index, std::forward<Args>(args)...);
+        guard.dismiss();
+
+        return t;
+    }
+
+    /**
+     * @brief Destroys the item, thread safe.
+     *
+     * @return false if @c id is not the identifier of an item (already
+     * freed by this thread or another one).
+     */
+    bool free(Identifier id) noexcept
+    {
+        int index;
+
+        if (!retract(id, index))
+            return false;
+
+        push(&index, 1);
+
+        return true;
+    }
+
+    /**
+     * @brief Destroys the item and keeps its index in the @c cache of the
+     * thread, thread safe.
+     *
+     * @return false if @c id is not the identifier of an item.
+     */
+    bool free(cache& c, Identifier id) noexcept
+    {
+        assert(c.m_array == this);
+
+        int index;
+
+        if (!retract(id, index))
+            return false;
+
+        c.m_indices[c.m_number++] = index;
+        if (c.m_number == 2 * cache_size) {
+            push(c.m_indices + cache_size, cache_size);
+            c.m_number = cache_size;
+        }
+
+        return true;
+    }
+
+    Identifier get_id(const T& t) const noexcept
+    {
+        return m_ids[&t - m_items].load(std::memory_order_acquire);
+    }
+
+    T& get(Identifier id) noexcept
+    {
+        return m_items[Split::get_index(id)];
+    }
+
+    const T& get(Identifier id) const noexcept
+    {
+        return m_items[Split::get_index(id)];
+    }
+
+    /**
+     * @brief Get a T from an ID, thread safe.
+     *
+     * @return nullptr if @c id is not the identifier of an item.
+     */
+    T* try_to_get(Identifier id) noexcept
+    {
+        if (Split::valid(id)) {
+            const auto index = Split::get_index(id);
+            if (index < m_capacity &&
+                m_ids[index].load(std::memory_order_acquire) == id)
+                return &m_items[index];
+        }
+
+        return nullptr;
+    }
+
+    /**
+     * @brief Return next item, the first if @c t is nullptr. The items
+     * allocated or freed during the iteration may be visited or not.
+     */
+    bool next(T*& t) noexcept
+    {
+        const auto used = m_max_used.load(std::memory_order_acquire);
+        int index = t ? static_cast<int>(t - m_items) + 1 : 0;
+
+        for (; index < used; ++index) {
+            if (is_item(index,
+                        m_ids[index].load(std::memory_order_acquire))) {
+                t = &m_items[index];
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /// The number of items, in O(max_used): use it when the threads are
+    /// done.
+    int size() const noexcept
+    {
+        const auto used = m_max_used.load();
+        int ret = 0;
+
+        for (int i = 0; i != used; ++i)
+            if (is_item(i, m_ids[i].load(std::memory_order_relaxed)))
+                ++ret;
+
+        return ret;
+    }
+
+    int capacity() const noexcept
+    {
+        return m_capacity;
+    }
+
+    int max_used() const noexcept
+    {
+        return m_max_used.load();
+    }
+
+private:
+    static bool is_item(int index, Identifier id) noexcept
+    {
+        return Split::valid(id) && Split::get_index(id) == index;
+    }
+
+    // The free list head: the tag in the high 32 bits, the index plus one
+    // in the low 32 bits (zero for an empty list).
+    static std::uint64_t make_head(std::uint64_t head, int index) noexcept
+    {
+        return ((head >> 32) + 1) << 32 |
+               static_cast<std::uint32_t>(index + 1);
+    }
+
+    static int head_index(std::uint64_t head) noexcept
+    {
+        return static_cast<int>(head & 0xffffffffu) - 1;
+    }
+
+    // Calls the function at the end of the scope unless dismissed: gives
+    // back the index of an alloc when the constructor of T throws.
+    template<typename Function>
+    class index_guard
+    {
+        Function m_function;
+        bool m_dismissed = false;
+
+    public:
+        explicit index_guard(Function function) noexcept
+          : m_function(function)
+        {}
+
+        index_guard(const index_guard&) = delete;
+        index_guard& operator=(const index_guard&) = delete;
+
+        ~index_guard() noexcept
+        {
+            if (!m_dismissed)
+                m_function();
+        }
+
+        void dismiss() noexcept
+        {
+            m_dismissed = true;
+        }
+    };
+
+    template<typename... Args>
+    T* construct(int index, Args&&... args)
+    {
+        auto* t = new (&m_items[index]) T(std::forward<Args>(args)...);
+
+        // Only the thread which popped the index writes its identifier.
+        const auto key = Split::make_next_key(
+          Split::get_key(m_ids[index].load(std::memory_order_relaxed)));
+        m_ids[index].store(Split::make_id(key, index),
+                           std::memory_order_release);
+
+        return t;
+    }
+
+    // Replaces the identifier of the item with a free entry identifier
+    // then destroys the item. Only one thread succeeds for an identifier.
+    bool retract(Identifier id, int& index) noexcept
+    {
+        if (!Split::valid(id))
+            return false;
+
+        index = Split::get_index(id);
+        if (index >= m_capacity)
+            return false;
+
+        auto expected = id;
+        if (!m_ids[index].compare_exchange_strong(
+              expected,
+              Split::make_id(Split::get_key(id), index + 1),
+              std::memory_order_acq_rel,
+              std::memory_order_relaxed))
+            return false;
+
+        m_items[index].~T();
+
+        return true;
+    }
+
+    // Pops at most @c wanted indices from the free list with one
+    // compare-and-swap. The tag of the head changes at each push and pop:
+    // when the compare-and-swap succeeds, the links read are still the
+    // links of the list.
+    int pop(int* indices, int wanted) noexcept
+    {
+        auto head = m_free_head.load(std::memory_order_acquire);
+
+        for (;;) {
+            int index = head_index(head);
+            int number = 0;
+
+            while (index >= 0 && number < wanted) {
+                indices[number++] = index;
+                index = m_next[index].load(std::memory_order_relaxed);
+            }
+
+            if (number == 0)
+                return 0;
+
+            if (m_free_head.compare_exchange_weak(head,
+                                                  make_head(head, index),
+                                                  std::memory_order_acquire,
+                                                  std::memory_order_acquire))
+                return number;
+        }
+    }
+
+    // Pushes the indices on the free list with one compare-and-swap.
+    void push(const int* indices, int number) noexcept
+    {
+        assert(number > 0);
+
+        for (int i = 0; i + 1 < number; ++i)
+            m_next[indices[i]].store(indices[i + 1],
+                                     std::memory_order_relaxed);
+
+        auto head = m_free_head.load(std::memory_order_relaxed);
+
+        do {
+            m_next[indices[number - 1]].store(head_index(head),
+                                              std::memory_order_relaxed);
+        } while (!m_free_head.compare_exchange_weak(
+          head,
+          make_head(head, indices[0]),
+          std::memory_order_release,
+          std::memory_order_relaxed));
+    }
+
+    // Reserves at most @c wanted never used entries.
+    int reserve(int* indices, int wanted) noexcept
+    {
+        auto used = m_max_used.load(std::memory_order_relaxed);
+        int number;
+
+        do {
+            number = std::min(wanted, m_capacity - used);
+            if (number <= 0)
+                return 0;
+        } while (!m_max_used.compare_exchange_weak(
+          used, used + number, std::memory_order_relaxed));
+
+        for (int i = 0; i != number; ++i)
+            indices[i] = used + i;
+
+        return number;
+    }
+
+    T* m_items = nullptr;                     // items vector.
+    std::atomic<Identifier>* m_ids = nullptr; // identifiers vector.
+    std::atomic<int>* m_next = nullptr;       // links of the free list.
+    int m_capacity = 0;
+
+    alignas(64) std::atomic<int> m_max_used{ 0 };
+    alignas(64) std::atomic<std::uint64_t> m_free_head{ 0 };
+};
+
+} // namespace irr
+
+#endif // ORG_VLEPROJECT_IRRITATOR_CONCURRENT_DATA_ARRAY_HPP
@@ -0,0 +1,112 @@
+// Copyright (c) 2019 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef ORG_VLEPROJECT_IRRITATOR_CONSERVATIVE_HPP
+#define ORG_VLEPROJECT_IRRITATOR_CONSERVATIVE_HPP
+
+#include <irritator/simulation.hpp>
+#include <irritator/thread-pool.hpp>
+
+#include <memory>
+#include <vector>
+
+#include <cstdint>
+
+namespace irr {
+
+struct ConservativeStatistics
+{
+    std::uint64_t epochs = 0;        // synchronizations of the partitions
+    std::uint64_t lockstep_bags = 0; // bags at the time of an epoch
+    std::uint64_t window_bags = 0;   // bags inside the lookahead windows
+    std::uint64_t messages = 0;      // messages between partitions
+};
+
+// Defined in conservative.cpp.
+struct conservative_partition;
+
+/**
+ * @brief A conservative parallel engine for a @c FlatSimulation.
+ * @details The simulators are dispatched on partitions, one thread per
+ * partition, and the partitions never roll back. The simulation advances
+ * by epochs separated by spin barriers:
+ * - all partitions run together the bag of the lowest time T of the
+ *   simulation: outputs are exchanged, then the transitions are done,
+ * - each partition publishes the lowest time of its next output to another
+ *   partition: the minimum of its next internal event and of T plus its
+ *   lookahead (the minimum of @c AtomicDynamics::lookahead of the
+ *   simulators connected to another partition),
+ * - each partition runs its bags lower than the lowest time published by
+ *   the other partitions: no message can arrive before.
+ *
+ * No null message is exchanged: the lower bound of each partition is read
+ * by the others after a barrier. Messages between partitions go through a
+ * lock-free queue for each pair of connected partitions and are limited to
+ * @c payload reals, the application aborts on a longer vector. The bags are
+ * built in the same order as the sequential engine: the results are the same
+ * whatever the number of partitions.
+ *
+ * With a zero lookahead, the engine runs one bag by epoch.
+ */
+struct Conservative
+{
+    static constexpr int payload = 4;
+
+    FlatSimulation* flat = nullptr;
+    float start = 0.f;
+    float end = 0.f;
+
+    /// The partition of each simulator, indexed by @c model_index(ID).
+    std::vector<int> owner;
+    std::vector<std::unique_ptr<conservative_partition>> partitions;
+    spin_barrier barrier;
+
+    Conservative() noexcept;
+    ~Conservative() noexcept;
+
+    Conservative(const Conservative&) = delete;
+    Conservative& operator=(const Conservative&) = delete;
+
+    /**
+     * @brief Dispatch the simulators on @c partition_number partitions by
+     * contiguous blocks and initialize them at the @c start time.
+     *
+     * @param queue_capacity The capacity, a power of two, of the queue of
+     * messages between two partitions.
+     *
+     * @return false if a simulator does not have dynamics or if a
+     * parameter is invalid.
+     */
+    bool initialize(FlatSimulation& flat,
+                    int partition_number,
+                    float start,
+                    float end,
+                    int queue_capacity = 1024);
+
+    /**
+     * @brief Same as above with a user partition: @c owner[model_index(id)]
+     * is the partition of the simulator @c id.
+     */
+    bool initialize(FlatSimulation& flat,
+                    const std::vector<int>& owner,
+                    int partition_number,
+                    float start,
+                    float end,
+                    int queue_capacity = 1024);
+
+    /**
+     * @brief Run the simulation until the @c end time, the calling thread
+     * runs the first partition.
+     */
+    void run();
+
+    /**
+     * @brief Sum of the statistics of the partitions.
+     */
+    ConservativeStatistics statistics() const noexcept;
+};
+
+} // namespace irr
+
+#endif // ORG_VLEPROJECT_IRRITATOR_CONSERVATIVE_HPP
@@ -6,14 +6,23 @@
 #define ORG_VLEPROJECT_IRRITATOR_DATA_ARRAY_HPP
 
 #include <algorithm>
+#include <iterator>
+#include <memory_resource>
+#include <new>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <cassert>
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace irr {
 
 using ID = std::uint32_t;
@@ -22,64 +31,123 @@ using WID = std::uint64_t;
 template<typename Identifier>
 struct data_list;
 
+/**
+ * @brief The split of an identifier in an index, the low @c IndexBits
+ * bits, and a key, the high bits.
+ * @details The key is a generation number in [1..max_key()] used to detect
+ * references to freed items, an identifier with a zero key is invalid.
+ * More index bits give larger arrays, more key bits delay the reuse of an
+ * identifier after a free.
+ *
+ * @tparam Identifier An unsigned integer (@c ID or @c WID).
+ * @tparam IndexBits The number of bits of the index.
+ */
+template<typename Identifier, int IndexBits>
+struct id_split
+{
+    static_assert(std::is_unsigned<Identifier>::value,
+                  "id_split needs an unsigned identifier");
+    static_assert(IndexBits > 0 &&
+                    IndexBits < static_cast<int>(sizeof(Identifier) * 8),
+                  "id_split needs index and key bits");
+
+    using identifier_type = Identifier;
+
+    static constexpr int index_bits = IndexBits;
+    static constexpr int key_bits =
+      static_cast<int>(sizeof(Identifier) * 8) - IndexBits;
+    static constexpr Identifier index_mask =
+      (static_cast<Identifier>(1) << IndexBits) - 1;
+
+    static constexpr int get_index(Identifier id) noexcept
+    {
+        return static_cast<int>(id & index_mask);
+    }
+
+    static constexpr unsigned get_key(Identifier id) noexcept
+    {
+        return static_cast<unsigned>(id >> IndexBits);
+    }
+
+    static constexpr unsigned max_key() noexcept
+    {
+        return key_bits >= 32 ? UINT32_MAX : (1u << key_bits) - 1u;
+    }
+
+    /// The maximum number of items: indices are stored in @c int.
+    static constexpr int max_size() noexcept
+    {
+        return index_bits >= 31 ? INT32_MAX : (1 << index_bits) - 1;
+    }
+
+    static constexpr bool valid(Identifier id) noexcept
+    {
+        return get_key(id) > 0;
+    }
+
+    static constexpr Identifier make_id(unsigned key, int index) noexcept
+    {
+        return static_cast<Identifier>(key) << IndexBits |
+               static_cast<Identifier>(index);
+    }
+
+    static constexpr unsigned make_next_key(unsigned key) noexcept
+    {
+        return key == max_key() ? 1u : key + 1;
+    }
+};
+
+/**
+ * @brief The split used by the free functions below and by default in
+ * @c data_array: 16 bits of index for @c ID, 32 bits for @c WID.
+ */
+template<typename Identifier>
+struct default_id_split;
+
+template<>
+struct default_id_split<ID> : id_split<ID, 16>
+{};
+
+template<>
+struct default_id_split<WID> : id_split<WID, 32>
+{};
+
 constexpr int
 get_index(WID id) noexcept
 {
-    return static_cast<int>(id & 0x00000000ffffffff);
+    return default_id_split<WID>::get_index(id);
 }
 
 constexpr unsigned
 get_key(WID id) noexcept
 {
-    return static_cast<unsigned>((id & 0xffffffff00000000) >> 32);
+    return default_id_split<WID>::get_key(id);
 }
 
 constexpr int
 get_index(ID id) noexcept
 {
-    return static_cast<int>(id & 0x0000ffff);
+    return default_id_split<ID>::get_index(id);
 }
 
 constexpr unsigned
 get_key(ID id) noexcept
 {
-    return id & 0xffff0000;
+    return default_id_split<ID>::get_key(id);
 }
 
 template<typename T>
 constexpr unsigned
-get_max_key() noexcept;
-
-template<>
-constexpr unsigned
-get_max_key<WID>() noexcept
+get_max_key() noexcept
 {
-    return static_cast<unsigned>(0xffffffff00000000 >> 32);
-}
-
-template<>
-constexpr unsigned
-get_max_key<ID>() noexcept
-{
-    return static_cast<unsigned>(0xffff0000 >> 16);
+    return default_id_split<T>::max_key();
 }
 
 template<typename T>
 constexpr int
-size() noexcept;
-
-template<>
-constexpr int
-size<WID>() noexcept
-{
-    return INT32_MAX;
-}
-
-template<>
-constexpr int
-size<ID>() noexcept
+size() noexcept
 {
-    return UINT16_MAX;
+    return default_id_split<T>::max_size();
 }
 
 template<typename Identifier>
@@ -91,42 +159,68 @@ valid(Identifier id) noexcept
 
 template<typename T>
 constexpr T
-make_id(unsigned key, int index) noexcept;
-
-template<>
-constexpr WID
-make_id<WID>(unsigned key, int index) noexcept
+make_id(unsigned key, int index) noexcept
 {
-    WID id = key;
-    id <<= 32;
-    return id | index;
-}
-
-template<>
-constexpr ID
-make_id<ID>(unsigned key, int index) noexcept
-{
-    return (key << 16 | index);
+    return default_id_split<T>::make_id(key, index);
 }
 
 template<typename T>
 constexpr unsigned
-make_next_key(unsigned key) noexcept;
-
-template<>
-constexpr unsigned
-make_next_key<WID>(unsigned key) noexcept
+make_next_key(unsigned key) noexcept
 {
-    return key == get_max_key<WID>() ? 1u : key + 1;
+    return default_id_split<T>::make_next_key(key);
 }
 
-template<>
-constexpr unsigned
-make_next_key<ID>(unsigned key) noexcept
+/**
+ * @brief The index of the lowest set bit of a non zero word (tzcnt/bsf).
+ */
+inline int
+find_first_set(std::uint64_t word) noexcept
 {
-    return key == get_max_key<ID>() ? 1u : key + 1;
+    assert(word != 0);
+
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#else
+    int index = 0;
+    while (!(word & 1u)) {
+        word >>= 1;
+        ++index;
+    }
+    return index;
+#endif
 }
 
+/**
+ * @brief The identifiers of the items of a @c data_array before and after
+ * a @c compact(), by index before the compaction.
+ * @details Use it as a function to rewrite the identifiers stored outside
+ * of the @c data_array.
+ */
+template<typename Identifier, typename Split = default_id_split<Identifier>>
+struct id_remap
+{
+    std::vector<Identifier> old_ids; // 0 for an entry of the free list.
+    std::vector<Identifier> new_ids;
+
+    /// Returns the identifier after the compaction, 0 if @c id was not the
+    /// identifier of an item.
+    Identifier operator()(Identifier id) const noexcept
+    {
+        const auto index = Split::get_index(id);
+
+        if (Split::valid(id) && index < static_cast<int>(old_ids.size()) &&
+            old_ids[index] == id)
+            return new_ids[index];
+
+        return 0;
+    }
+};
+
 template<typename T>
 struct array
 {
@@ -137,28 +231,73 @@ struct array
 
     value_type* items = nullptr;
     int size = 0;
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource();
 
-    array(int capacity)
-      : items(new value_type[capacity])
-      , size(capacity)
+    array() noexcept = default;
+
+    explicit array(std::pmr::memory_resource* resource_) noexcept
+      : resource(resource_)
     {}
 
+    array(int capacity)
+    {
+        init(capacity);
+    }
+
+    array(int capacity, std::pmr::memory_resource* resource_)
+      : resource(resource_)
+    {
+        init(capacity);
+    }
+
+    array(const array&) = delete;
+    array& operator=(const array&) = delete;
+
     bool init(int size_) noexcept
     {
         if (size_ < 0)
             return false;
 
-        if (items)
-            delete[] items;
+        release();
 
+        items = static_cast<value_type*>(
+          resource->allocate(sizeof(value_type) * size_, alignof(value_type)));
         size = size_;
-        items = new value_type[size_];
+
+        for (int i = 0; i != size_; ++i)
+            new (&items[i]) value_type;
+
+        return true;
+    }
+
+    /**
+     * @brief Reallocates @c size_ items, the first items are moved into
+     * the new items and the others are default constructed.
+     */
+    bool resize(int size_) noexcept
+    {
+        if (size_ < 0)
+            return false;
+
+        auto* new_items = static_cast<value_type*>(
+          resource->allocate(sizeof(value_type) * size_, alignof(value_type)));
+
+        const auto kept = std::min(size, size_);
+        for (int i = 0; i != kept; ++i)
+            new (&new_items[i]) value_type(std::move(items[i]));
+        for (int i = kept; i != size_; ++i)
+            new (&new_items[i]) value_type;
+
+        release();
+        items = new_items;
+        size = size_;
+
+        return true;
     }
 
     ~array() noexcept
     {
-        if (items)
-            delete[] items;
+        release();
     }
 
     value_type& operator[](int i) noexcept
@@ -174,6 +313,153 @@ struct array
 
         return items[i];
     }
+
+private:
+    void release() noexcept
+    {
+        if (!items)
+            return;
+
+        if (!std::is_trivially_destructible<value_type>::value)
+            for (int i = 0; i != size; ++i)
+                items[i].~value_type();
+
+        resource->deallocate(
+          items, sizeof(value_type) * size, alignof(value_type));
+        items = nullptr;
+        size = 0;
+    }
+};
+
+/**
+ * @brief The layouts of the items and the identifiers of a @c data_array.
+ * @details @c interleaved_ids stores each identifier after its item, one
+ * cache line gives both. @c separated_ids stores the identifiers in their
+ * own dense array: try_to_get and the validity checks read 4 or 8 bytes
+ * by entry whatever the size of the items.
+ */
+struct interleaved_ids
+{};
+
+struct separated_ids
+{};
+
+/**
+ * @brief The memory of a @c data_array: raw storage where alloc()
+ * constructs the items and free() destroys them, and the identifiers,
+ * zero until an item is allocated.
+ */
+template<typename T, typename Identifier, typename Layout>
+struct data_array_storage;
+
+template<typename T, typename Identifier>
+struct data_array_storage<T, Identifier, interleaved_ids>
+{
+    struct item
+    {
+        T item;
+        Identifier id;
+    };
+
+    item* items = nullptr; // items vector.
+
+    void allocate(std::pmr::memory_resource* resource, int capacity)
+    {
+        items = static_cast<item*>(
+          resource->allocate(sizeof(item) * capacity, alignof(item)));
+
+        for (int i = 0; i != capacity; ++i)
+            items[i].id = 0;
+    }
+
+    void deallocate(std::pmr::memory_resource* resource,
+                    int capacity) noexcept
+    {
+        if (items)
+            resource->deallocate(
+              items, sizeof(item) * capacity, alignof(item));
+
+        items = nullptr;
+    }
+
+    T& value(int index) noexcept
+    {
+        return items[index].item;
+    }
+
+    const T& value(int index) const noexcept
+    {
+        return items[index].item;
+    }
+
+    Identifier& id(int index) noexcept
+    {
+        return items[index].id;
+    }
+
+    Identifier id(int index) const noexcept
+    {
+        return items[index].id;
+    }
+
+    Identifier id_of(const T& t) const noexcept
+    {
+        return reinterpret_cast<const item*>(&t)->id;
+    }
+};
+
+template<typename T, typename Identifier>
+struct data_array_storage<T, Identifier, separated_ids>
+{
+    T* items = nullptr;        // items vector.
+    Identifier* ids = nullptr; // identifiers vector.
+
+    void allocate(std::pmr::memory_resource* resource, int capacity)
+    {
+        items = static_cast<T*>(
+          resource->allocate(sizeof(T) * capacity, alignof(T)));
+        ids = static_cast<Identifier*>(resource->allocate(
+          sizeof(Identifier) * capacity, alignof(Identifier)));
+        std::fill_n(ids, capacity, Identifier(0));
+    }
+
+    void deallocate(std::pmr::memory_resource* resource,
+                    int capacity) noexcept
+    {
+        if (items) {
+            resource->deallocate(items, sizeof(T) * capacity, alignof(T));
+            resource->deallocate(
+              ids, sizeof(Identifier) * capacity, alignof(Identifier));
+        }
+
+        items = nullptr;
+        ids = nullptr;
+    }
+
+    T& value(int index) noexcept
+    {
+        return items[index];
+    }
+
+    const T& value(int index) const noexcept
+    {
+        return items[index];
+    }
+
+    Identifier& id(int index) noexcept
+    {
+        return ids[index];
+    }
+
+    Identifier id(int index) const noexcept
+    {
+        return ids[index];
+    }
+
+    Identifier id_of(const T& t) const noexcept
+    {
+        return ids[&t - items];
+    }
 };
 
 /**
@@ -184,11 +470,22 @@ struct array
  * - stable indices
  * - weak references
  * - zero overhead derefs
+ * - an occupancy bitset: next() and the range-based for skip 64 free
+ *   entries with a word test and find the next item with a tzcnt
+ * - the memory comes from a @c std::pmr::memory_resource, for example a
+ *   @c page_memory_resource for huge pages and NUMA placement
  *
  * @tparam T The type of object the data_array holds.
+ * @tparam Identifier The type of the identifiers (@c ID or @c WID).
+ * @tparam Split The split of the identifiers in index and key, the
+ * capacity is at most @c Split::max_size().
+ * @tparam Layout @c interleaved_ids or @c separated_ids.
  */
-template<typename T, typename Identifier>
-struct data_array
+template<typename T,
+         typename Identifier,
+         typename Split = default_id_split<Identifier>,
+         typename Layout = interleaved_ids>
+struct data_array : data_array_storage<T, Identifier, Layout>
 {
     static_assert(std::is_default_constructible<T>::value,
                   "data_array needs a default constructor");
@@ -197,21 +494,83 @@ struct data_array
     static_assert(std::is_nothrow_destructible<T>::value,
                   "data_array needs a nothrow destructor");
 
+    static_assert(std::is_same<typename Split::identifier_type,
+                               Identifier>::value,
+                  "data_array needs a split of its identifier type");
+
     using identifier_type = Identifier;
     using value_type = T;
+    using split_type = Split;
+    using layout_type = Layout;
+    using storage_type = data_array_storage<T, Identifier, Layout>;
 
-    struct item
+    /// Iterates over the items not on the free list.
+    class iterator
     {
-        T item;
-        Identifier id;
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        iterator(data_array* array_, int index_) noexcept
+          : array(array_)
+          , index(index_)
+        {}
+
+        T& operator*() const noexcept
+        {
+            return array->value(index);
+        }
+
+        T* operator->() const noexcept
+        {
+            return &array->value(index);
+        }
+
+        iterator& operator++() noexcept
+        {
+            index = array->next_index(index + 1);
+            return *this;
+        }
+
+        iterator operator++(int) noexcept
+        {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        bool operator==(const iterator& other) const noexcept
+        {
+            return index == other.index;
+        }
+
+        bool operator!=(const iterator& other) const noexcept
+        {
+            return index != other.index;
+        }
+
+    private:
+        data_array* array;
+        int index;
     };
 
     data_array() = default;
+
+    /// The items, the identifiers and the occupancy bitset are allocated
+    /// in @c resource_.
+    explicit data_array(std::pmr::memory_resource* resource_) noexcept
+      : resource(resource_)
+    {}
+
     ~data_array();
 
-    /** Allocate a vector of items (max 65536 items).
+    /** Allocate a vector of items (max Split::max_size() items).
      *
-     * @return true if success, false if capacity is not in [0..65536[.
+     * @return true if success, false if capacity is not in
+     * [0..Split::max_size()].
      */
     bool init(int capacity_);
 
@@ -221,17 +580,29 @@ struct data_array
     void clear();
 
     /* alloc (memclear* and/or construct*, *optional) an item from
-       freeList or items[max_used++], sets id to (next_key++ << 16) | index
+       freeList or items[max_used++], sets id to
+       Split::make_id(next_key++, index). The array must not be full(),
+       the application aborts otherwise.
      */
     T& alloc() noexcept;
 
     /* alloc and construct an item from freeList or items[max_used++], sets id
-       to (next_key++ << 16) | index
+       to Split::make_id(next_key++, index). The array must not be full(),
+       the application aborts otherwise.
      */
     template<typename... Args>
     T& alloc(Args&&... args) noexcept;
 
-    // puts entry on free list (uses id to store next)
+    /**
+     * @brief Like @c alloc() but returns nullptr if the array is full.
+     */
+    template<typename... Args>
+    T* try_alloc(Args&&... args) noexcept
+    {
+        return full() ? nullptr : &alloc(std::forward<Args>(args)...);
+    }
+
+    // puts entry on free list (uses id to store next + 1 with a zero key)
     void free(T&) noexcept;
 
     void free(Identifier id);
@@ -239,8 +610,8 @@ struct data_array
     // accessor to the id part if Item
     Identifier get_id(const T&);
 
-    T& get(Identifier id);             // return item[id & 0xFFFF];
-    const T& get(Identifier id) const; // return item[id & 0xFFFF];
+    T& get(Identifier id);             // return item[index of id];
+    const T& get(Identifier id) const; // return item[index of id];
 
     /**
      * @brief Get a T from an ID.
@@ -252,7 +623,7 @@ struct data_array
     T* try_to_get(Identifier id);
 
     /**
-     * @brief Return next item where id & 0xFFFF0000 != 0 (ie items not on
+     * @brief Return next item where the key of id != 0 (ie items not on
      * free list).
      *
      * @param  [description]
@@ -260,35 +631,73 @@ struct data_array
      */
     bool next(T*&);
 
+    /**
+     * @brief Return the index of the first item not on the free list in
+     * [index..max_used[ or max_used if there is none.
+     */
+    int next_index(int index) const noexcept
+    {
+        return next_index(index, max_used);
+    }
+
+    /**
+     * @brief Return the index of the first item not on the free list in
+     * [index..last[ or last if there is none, last <= max_used.
+     */
+    int next_index(int index, int last) const noexcept;
+
+    iterator begin() noexcept
+    {
+        return iterator(this, next_index(0));
+    }
+
+    iterator end() noexcept
+    {
+        return iterator(this, max_used);
+    }
+
+    /**
+     * @brief Moves the items to the front, in the order of their indices,
+     * and empties the free list: the iteration visits only the items.
+     * @details The items keep their keys and take their new index. The
+     * identifiers stored outside of the array must be rewritten with the
+     * returned remap.
+     */
+    id_remap<Identifier, Split> compact();
+
     bool full() const noexcept;
 
     int size() const noexcept;
 
-    item* items = nullptr;     // items vector.
-    int max_size = 0;          // total size
-    int max_used = 0;          // highest index ever allocated
-    int capacity = 0;          // num allocated items
-    unsigned int next_key = 1; // [1..2^16] (don't let == 0)
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+    std::uint64_t* occupancy = nullptr; // a bit by item not on free list
+    int max_size = 0;                   // total size
+    int max_used = 0;                   // highest index ever allocated
+    int capacity = 0;                   // num allocated items
+    unsigned int next_key = 1; // [1..Split::max_key()] (don't let == 0)
     int free_head = -1;        // index of first free entry
 };
 
-template<typename T, typename Identifier>
-data_array<T, Identifier>::~data_array()
+template<typename T, typename Identifier, typename Split, typename Layout>
+data_array<T, Identifier, Split, Layout>::~data_array()
 {
-    if (items)
-        delete[] items;
+    clear();
 }
 
-template<typename T, typename Identifier>
+template<typename T, typename Identifier, typename Split, typename Layout>
 bool
-data_array<T, Identifier>::init(int capacity_)
+data_array<T, Identifier, Split, Layout>::init(int capacity_)
 {
     clear();
 
-    if (capacity_ < 0 || capacity_ > irr::size<ID>())
+    if (capacity_ < 0 || capacity_ > Split::max_size())
         return false;
 
-    items = new item[capacity_ * sizeof(item)];
+    const auto words = (capacity_ + 63) / 64;
+    this->allocate(resource, capacity_);
+    occupancy = static_cast<std::uint64_t*>(resource->allocate(
+      sizeof(std::uint64_t) * words, alignof(std::uint64_t)));
+    std::fill_n(occupancy, words, std::uint64_t(0));
     max_size = 0;
     max_used = 0;
     capacity = capacity_;
@@ -298,38 +707,21 @@ data_array<T, Identifier>::init(int capacity_)
     return true;
 }
 
-template<typename T, typename Identifier>
-void
-Do_clear(typename data_array<T, Identifier>::item* items,
-         const int size,
-         std::true_type)
-{
-    std::memset(
-      items, 0, sizeof(typename data_array<T, Identifier>::item) * size);
-}
-
-template<typename T, typename Identifier>
+template<typename T, typename Identifier, typename Split, typename Layout>
 void
-Do_clear(typename data_array<T, Identifier>::item* items,
-         const int size,
-         std::false_type)
+data_array<T, Identifier, Split, Layout>::clear()
 {
-    for (int i = 0; i != size; ++i) {
-        if (valid(items[i].id)) {
-            items[i].item.~T();
-            items[i].id = 0;
-        }
-    }
-}
+    if (!std::is_trivially_destructible<T>::value && occupancy)
+        for (auto& elem : *this)
+            elem.~T();
 
-template<typename T, typename Identifier>
-void
-data_array<T, Identifier>::clear()
-{
-    Do_clear<T, Identifier>(items, max_size, std::is_trivial<T>());
+    if (occupancy)
+        resource->deallocate(occupancy,
+                             sizeof(std::uint64_t) * ((capacity + 63) / 64),
+                             alignof(std::uint64_t));
 
-    delete[] items;
-    items = nullptr;
+    this->deallocate(resource, capacity);
+    occupancy = nullptr;
     max_size = 0;
     max_used = 0;
     capacity = 0;
@@ -349,73 +741,77 @@ Do_alloc(T& t, std::false_type) noexcept
     new (&t) T();
 }
 
-template<typename T, typename Identifier>
+template<typename T, typename Identifier, typename Split, typename Layout>
 T&
-data_array<T, Identifier>::alloc() noexcept
+data_array<T, Identifier, Split, Layout>::alloc() noexcept
 {
+    assert(!full());
+    if (full())
+        std::abort();
+
     int new_index;
 
     if (free_head >= 0) {
         new_index = free_head;
-        if (valid(items[free_head].id))
-            free_head = -1;
-        else
-            free_head = get_index(items[free_head].id);
+        free_head = Split::get_index(this->id(free_head)) - 1;
     } else {
         new_index = max_used++;
     }
 
-    Do_alloc<T, Identifier>(items[new_index].item, std::is_trivial<T>());
+    Do_alloc<T, Identifier>(this->value(new_index), std::is_trivial<T>());
 
 #if 0
     printf("new index: %d next key: %u and ID: %lu\n",
            new_index,
            next_key,
            static_cast<long unsigned int>(
-             make_id<Identifier>(next_key, new_index)));
+             Split::make_id(next_key, new_index)));
 #endif
 
-    items[new_index].id = make_id<Identifier>(next_key, new_index);
-    next_key = make_next_key<Identifier>(next_key);
+    this->id(new_index) = Split::make_id(next_key, new_index);
+    next_key = Split::make_next_key(next_key);
+    occupancy[new_index >> 6] |= std::uint64_t(1) << (new_index & 63);
 
     ++max_size;
 
-    return items[new_index].item;
+    return this->value(new_index);
 }
 
-template<typename T, typename Identifier>
+template<typename T, typename Identifier, typename Split, typename Layout>
 template<typename... Args>
 T&
-data_array<T, Identifier>::alloc(Args&&... args) noexcept
+data_array<T, Identifier, Split, Layout>::alloc(Args&&... args) noexcept
 {
+    assert(!full());
+    if (full())
+        std::abort();
+
     int new_index;
 
     if (free_head >= 0) {
         new_index = free_head;
-        if (valid(items[free_head].id))
-            free_head = -1;
-        else
-            free_head = get_index(items[free_head].id);
+        free_head = Split::get_index(this->id(free_head)) - 1;
     } else {
         new_index = max_used++;
     }
 
-    new (&items[new_index].item) T(std::forward<Args>(args)...);
+    new (&this->value(new_index)) T(std::forward<Args>(args)...);
 
 #if 0
     printf("new index: %d next key: %u and ID: %lu\n",
            new_index,
            next_key,
            static_cast<long unsigned int>(
-             make_id<Identifier>(next_key, new_index)));
+             Split::make_id(next_key, new_index)));
 #endif
 
-    items[new_index].id = make_id<Identifier>(next_key, new_index);
-    next_key = make_next_key<Identifier>(next_key);
+    this->id(new_index) = Split::make_id(next_key, new_index);
+    next_key = Split::make_next_key(next_key);
+    occupancy[new_index >> 6] |= std::uint64_t(1) << (new_index & 63);
 
     ++max_size;
 
-    return items[new_index].item;
+    return this->value(new_index);
 }
 
 template<typename T, typename Identifier>
@@ -432,120 +828,445 @@ Do_free(T& t, std::false_type) noexcept
     t.~T();
 }
 
-template<typename T, typename Identifier>
+template<typename T, typename Identifier, typename Split, typename Layout>
 void
-data_array<T, Identifier>::free(T& t) noexcept
+data_array<T, Identifier, Split, Layout>::free(T& t) noexcept
 {
     auto id = get_id(t);
-    auto index = get_index(id);
+    auto index = Split::get_index(id);
 
-    assert(&items[index] == static_cast<void*>(&t));
-    assert(items[index].id == id);
-    assert(valid(id));
+    assert(&this->value(index) == &t);
+    assert(this->id(index) == id);
+    assert(Split::valid(id));
 
-    Do_free<T, Identifier>(items[index].item, std::is_trivial<T>());
+    Do_free<T, Identifier>(this->value(index), std::is_trivial<T>());
 
-    items[index].id = free_head;
+    this->id(index) = Split::make_id(0u, free_head + 1);
     free_head = index;
+    occupancy[index >> 6] &= ~(std::uint64_t(1) << (index & 63));
 
     --max_size;
 }
 
-template<typename T, typename Identifier>
+template<typename T, typename Identifier, typename Split, typename Layout>
 void
-data_array<T, Identifier>::free(Identifier id)
+data_array<T, Identifier, Split, Layout>::free(Identifier id)
 {
-    auto index = get_index(id);
+    auto index = Split::get_index(id);
 
-    assert(items[index].id == id);
-    assert(valid(id));
+    assert(this->id(index) == id);
+    assert(Split::valid(id));
 
-    Do_free<T, Identifier>(items[index].item, std::is_trivial<T>());
+    Do_free<T, Identifier>(this->value(index), std::is_trivial<T>());
 
-    items[index].id = free_head;
+    this->id(index) = Split::make_id(0u, free_head + 1);
     free_head = index;
+    occupancy[index >> 6] &= ~(std::uint64_t(1) << (index & 63));
 
     --max_size;
 }
 
-template<typename T, typename Identifier>
+template<typename T, typename Identifier, typename Split, typename Layout>
 T&
-data_array<T, Identifier>::get(Identifier id)
+data_array<T, Identifier, Split, Layout>::get(Identifier id)
 {
-    return items[get_index(id)].item;
+    return this->value(Split::get_index(id));
 }
 
-template<typename T, typename Identifier>
+template<typename T, typename Identifier, typename Split, typename Layout>
 const T&
-data_array<T, Identifier>::get(Identifier id) const
+data_array<T, Identifier, Split, Layout>::get(Identifier id) const
 {
-    return items[get_index(id)].item;
+    return this->value(Split::get_index(id));
 }
 
-template<typename T, typename Identifier>
+template<typename T, typename Identifier, typename Split, typename Layout>
 Identifier
-data_array<T, Identifier>::get_id(const T& t)
+data_array<T, Identifier, Split, Layout>::get_id(const T& t)
 {
-    auto* ptr = reinterpret_cast<const item*>(&t);
-    return ptr->id;
+    return this->id_of(t);
 }
 
-template<typename T, typename Identifier>
+template<typename T, typename Identifier, typename Split, typename Layout>
 T*
-data_array<T, Identifier>::try_to_get(Identifier id)
+data_array<T, Identifier, Split, Layout>::try_to_get(Identifier id)
 {
-    if (get_key(id)) {
-        auto index = get_index(id);
-        if (items[index].id == id)
-            return &items[index].item;
+    if (Split::get_key(id)) {
+        auto index = Split::get_index(id);
+        if (index < max_used && this->id(index) == id)
+            return &this->value(index);
     }
 
     return nullptr;
 }
 
-template<typename T, typename Identifier>
+template<typename T, typename Identifier, typename Split, typename Layout>
 bool
-data_array<T, Identifier>::next(T*& t)
+data_array<T, Identifier, Split, Layout>::next(T*& t)
 {
-    int index;
+    const int index = next_index(t ? Split::get_index(get_id(*t)) + 1 : 0);
 
-    if (t) {
-        auto id = get_id(*t);
-        index = get_index(id);
-        ++index;
+    if (index < max_used) {
+        t = &this->value(index);
+        return true;
+    }
 
-        for (; index < max_used; ++index) {
-            if (valid(items[index].id)) {
-                t = &items[index].item;
-                return true;
-            }
-        }
-    } else {
-        for (index = 0; index < max_used; ++index) {
-            if (valid(items[index].id)) {
-                t = &items[index].item;
-                return true;
-            }
+    return false;
+}
+
+template<typename T, typename Identifier, typename Split, typename Layout>
+int
+data_array<T, Identifier, Split, Layout>::next_index(int index, int last) const
+  noexcept
+{
+    assert(last <= max_used);
+
+    if (index >= last)
+        return last;
+
+    // The bits after max_used are never set: the first set bit found is
+    // an item.
+    const int last_word = (last + 63) >> 6;
+    int word = index >> 6;
+    auto bits = occupancy[word] & (~std::uint64_t(0) << (index & 63));
+
+    while (!bits) {
+        if (++word == last_word)
+            return last;
+
+        bits = occupancy[word];
+    }
+
+    const auto found = (word << 6) + find_first_set(bits);
+
+    return found < last ? found : last;
+}
+
+template<typename T, typename Identifier, typename Split, typename Layout>
+id_remap<Identifier, Split>
+data_array<T, Identifier, Split, Layout>::compact()
+{
+    id_remap<Identifier, Split> remap;
+    remap.old_ids.resize(max_used, 0);
+    remap.new_ids.resize(max_used, 0);
+
+    // The destination index is never greater than the source index: the
+    // entries before the source are already moved or free.
+    int used = 0;
+    for (int i = next_index(0); i < max_used; i = next_index(i + 1)) {
+        const auto old_id = this->id(i);
+        const auto new_id = Split::make_id(Split::get_key(old_id), used);
+
+        if (i != used) {
+            new (&this->value(used)) T(std::move(this->value(i)));
+            this->value(i).~T();
         }
+
+        this->id(used) = new_id;
+        remap.old_ids[i] = old_id;
+        remap.new_ids[i] = new_id;
+        ++used;
     }
 
-    return false;
+    for (int i = used; i != max_used; ++i)
+        this->id(i) = 0;
+
+    std::fill_n(occupancy, (max_used + 63) / 64, std::uint64_t(0));
+    for (int i = 0; i != used; ++i)
+        occupancy[i >> 6] |= std::uint64_t(1) << (i & 63);
+
+    max_used = used;
+    free_head = -1;
+
+    return remap;
 }
 
-template<typename T, typename Identifier>
+template<typename T, typename Identifier, typename Split, typename Layout>
 bool
-data_array<T, Identifier>::full() const noexcept
+data_array<T, Identifier, Split, Layout>::full() const noexcept
 {
     return free_head == -1 && max_used == capacity;
 }
 
-template<typename T, typename Identifier>
+template<typename T, typename Identifier, typename Split, typename Layout>
 int
-data_array<T, Identifier>::size() const noexcept
+data_array<T, Identifier, Split, Layout>::size() const noexcept
 {
     return max_size;
 }
 
+/**
+ * @brief A data_array that grows by pages of @c PageSize items.
+ * @details The items never move: pointers and identifiers stay valid while
+ * the array grows, only the small table of pages is reallocated.
+ * - O(1) alloc/free, a new page when the pages are full
+ * - O(1) get and try_to_get (a shift and a mask)
+ * - the items are constructed by alloc and destroyed by free
+ *
+ * @tparam T The type of object the paged_data_array holds.
+ * @tparam Identifier The type of the identifiers (@c ID or @c WID).
+ * @tparam Split The split of the identifiers in index and key, the number
+ * of items is at most @c Split::max_size().
+ * @tparam PageSize The number of items of a page, a power of two.
+ */
+template<typename T,
+         typename Identifier,
+         typename Split = default_id_split<Identifier>,
+         int PageSize = 1024>
+struct paged_data_array
+{
+    static_assert(std::is_nothrow_destructible<T>::value,
+                  "paged_data_array needs a nothrow destructor");
+    static_assert(std::is_same<typename Split::identifier_type,
+                               Identifier>::value,
+                  "paged_data_array needs a split of its identifier type");
+    static_assert(PageSize > 0 && (PageSize & (PageSize - 1)) == 0,
+                  "paged_data_array needs a power of two page size");
+
+    using identifier_type = Identifier;
+    using value_type = T;
+    using split_type = Split;
+
+    static constexpr int page_size = PageSize;
+
+    struct item
+    {
+        T item;
+        Identifier id;
+    };
+
+    paged_data_array() noexcept = default;
+
+    /// The pages are allocated in @c resource_.
+    explicit paged_data_array(std::pmr::memory_resource* resource_) noexcept
+      : resource(resource_)
+    {}
+
+    paged_data_array(const paged_data_array&) = delete;
+    paged_data_array& operator=(const paged_data_array&) = delete;
+
+    ~paged_data_array() noexcept
+    {
+        clear();
+    }
+
+    /**
+     * @brief Destroys the items and allocates the pages for @c capacity_
+     * items, more pages are allocated by alloc().
+     *
+     * @return false if capacity_ is not in [0..Split::max_size()].
+     */
+    bool init(int capacity_)
+    {
+        clear();
+
+        if (capacity_ < 0 || capacity_ > Split::max_size())
+            return false;
+
+        return reserve(capacity_);
+    }
+
+    /**
+     * @brief Allocates the pages for @c capacity_ items.
+     *
+     * @return false if capacity_ is greater than Split::max_size().
+     */
+    bool reserve(int capacity_)
+    {
+        if (capacity_ > Split::max_size())
+            return false;
+
+        while (capacity < capacity_)
+            add_page();
+
+        return true;
+    }
+
+    /**
+     * @brief Destroys the items and frees the pages.
+     */
+    void clear() noexcept
+    {
+        for (int i = 0; i != max_used; ++i) {
+            auto& elem = at(i);
+            if (Split::valid(elem.id))
+                elem.item.~T();
+        }
+
+        for (auto* page : pages)
+            resource->deallocate(page, sizeof(item) * PageSize, alignof(item));
+
+        pages.clear();
+        max_size = 0;
+        max_used = 0;
+        capacity = 0;
+        next_key = 1;
+        free_head = -1;
+    }
+
+    /**
+     * @brief Constructs an item from the free list or at the end of the
+     * pages, a page is added if needed. The array must not be full(), the
+     * application aborts otherwise.
+     */
+    template<typename... Args>
+    T& alloc(Args&&... args)
+    {
+        assert(!full());
+        if (full())
+            std::abort();
+
+        int new_index;
+
+        if (free_head >= 0) {
+            new_index = free_head;
+            free_head = Split::get_index(at(free_head).id) - 1;
+        } else {
+            if (max_used == capacity)
+                add_page();
+
+            new_index = max_used++;
+        }
+
+        auto& elem = at(new_index);
+        new (&elem.item) T(std::forward<Args>(args)...);
+        elem.id = Split::make_id(next_key, new_index);
+        next_key = Split::make_next_key(next_key);
+
+        ++max_size;
+
+        return elem.item;
+    }
+
+    /**
+     * @brief Like @c alloc() but returns nullptr if the array is full.
+     */
+    template<typename... Args>
+    T* try_alloc(Args&&... args)
+    {
+        return full() ? nullptr : &alloc(std::forward<Args>(args)...);
+    }
+
+    void free(T& t) noexcept
+    {
+        free(get_id(t));
+    }
+
+    void free(Identifier id) noexcept
+    {
+        const auto index = Split::get_index(id);
+        auto& elem = at(index);
+
+        assert(elem.id == id);
+        assert(Split::valid(id));
+
+        elem.item.~T();
+        elem.id = Split::make_id(0u, free_head + 1);
+        free_head = index;
+
+        --max_size;
+    }
+
+    Identifier get_id(const T& t) const noexcept
+    {
+        return reinterpret_cast<const item*>(&t)->id;
+    }
+
+    T& get(Identifier id) noexcept
+    {
+        return at(Split::get_index(id)).item;
+    }
+
+    const T& get(Identifier id) const noexcept
+    {
+        return at(Split::get_index(id)).item;
+    }
+
+    T* try_to_get(Identifier id) noexcept
+    {
+        if (Split::valid(id)) {
+            const auto index = Split::get_index(id);
+            if (index < max_used && at(index).id == id)
+                return &at(index).item;
+        }
+
+        return nullptr;
+    }
+
+    /**
+     * @brief Moves @c t to the next item not on the free list, the first
+     * one if @c t is nullptr.
+     *
+     * @return false if there is no more item.
+     */
+    bool next(T*& t) noexcept
+    {
+        auto index = t ? Split::get_index(get_id(*t)) + 1 : 0;
+
+        for (; index < max_used; ++index) {
+            auto& elem = at(index);
+            if (Split::valid(elem.id)) {
+                t = &elem.item;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /// Only true when Split::max_size() items are allocated.
+    bool full() const noexcept
+    {
+        return free_head == -1 && max_used == Split::max_size();
+    }
+
+    int size() const noexcept
+    {
+        return max_size;
+    }
+
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+    std::vector<item*> pages;  // pages of PageSize items.
+    int max_size = 0;          // number of allocated items
+    int max_used = 0;          // highest index ever allocated
+    int capacity = 0;          // number of items of the pages
+    unsigned int next_key = 1; // [1..Split::max_key()] (don't let == 0)
+    int free_head = -1;        // index of first free entry
+
+private:
+    static constexpr int page_shift() noexcept
+    {
+        int shift = 0;
+        while ((1 << shift) != PageSize)
+            ++shift;
+
+        return shift;
+    }
+
+    item& at(int index) noexcept
+    {
+        return pages[index >> page_shift()][index & (PageSize - 1)];
+    }
+
+    const item& at(int index) const noexcept
+    {
+        return pages[index >> page_shift()][index & (PageSize - 1)];
+    }
+
+    // The items of a new page are not constructed, only their id is
+    // cleared: alloc() constructs an item in place.
+    void add_page()
+    {
+        auto* page = static_cast<item*>(
+          resource->allocate(sizeof(item) * PageSize, alignof(item)));
+        for (int i = 0; i != PageSize; ++i)
+            page[i].id = 0;
+
+        pages.push_back(page);
+        capacity += PageSize;
+    }
+};
+
 } // irr
 
 #endif // ORG_VLEPROJECT_IRRITATOR_DATA_ARRAY_HPP
@@ -6,6 +6,12 @@
 #define ORG_VLEPROJECT_IRRITATOR_DATA_LIST_HPP
 
 #include <algorithm>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <new>
 #include <type_traits>
 #include <vector>
 
@@ -22,8 +28,19 @@ class id_list;
 template<typename Identifier>
 class data_list;
 
+template<typename Identifier>
+class unrolled_id_list;
+
+template<typename Identifier>
+class chunk_list;
+
+template<typename List>
+struct list_access;
+
 using ListID = id_list<std::uint32_t>;
 using ListWID = id_list<std::uint64_t>;
+using UnrolledListID = unrolled_id_list<std::uint32_t>;
+using UnrolledListWID = unrolled_id_list<std::uint64_t>;
 
 template<typename Identifier>
 class id_list_iterator
@@ -32,6 +49,7 @@ public:
     using this_type = id_list_iterator<Identifier>;
     using identifier_type = Identifier;
     using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = identifier_type;
     using difference_type = std::ptrdiff_t;
     using pointer = identifier_type*;
     using reference = identifier_type&;
@@ -219,61 +237,79 @@ public:
 private:
     int m_first = -1;
     int m_last = -1;
+    int m_size = 0;
 
     friend id_list_iterator<identifier_type>;
 
 public:
     id_list() noexcept = default;
 
-    id_list(int first, int last) noexcept
+    id_list(int first, int last, int size) noexcept
       : m_first(first)
       , m_last(last)
+      , m_size(size)
     {}
 
-    reference front(const data_list<identifier_type>& list) noexcept
+    reference front(data_list<identifier_type>& list) noexcept
     {
-        return list[m_first].id;
+        return list.items[m_first].id;
     }
 
     const_reference front(const data_list<identifier_type>& list) const
       noexcept
     {
-        return list[m_first].id;
+        return list.items[m_first].id;
     }
 
-    reference back(const data_list<identifier_type>& list) noexcept
+    reference back(data_list<identifier_type>& list) noexcept
     {
-        return list[m_last].id;
+        return list.items[m_last].id;
     }
 
     const_reference back(const data_list<identifier_type>& list) const noexcept
     {
-        return list[m_last].id;
+        return list.items[m_last].id;
     }
 
-    void push_front(data_list<identifier_type>& list,
+    /// @return false if the @c data_list is full, the list is unchanged.
+    bool push_front(data_list<identifier_type>& list,
                     Identifier value) noexcept
     {
+        const auto new_index = list.alloc(value);
+        if (new_index < 0)
+            return false;
+
         if (m_first >= 0) {
-            auto new_index = list.alloc(value);
-            list[new_index].next = m_first;
-            list[m_first].previous = new_index;
+            list.items[new_index].next = m_first;
+            list.items[m_first].previous = new_index;
             m_first = new_index;
         } else {
-            m_first = m_last = list.alloc(value);
+            m_first = m_last = new_index;
         }
+
+        ++m_size;
+
+        return true;
     }
 
-    void push_back(data_list<identifier_type>& list, Identifier value) noexcept
+    /// @return false if the @c data_list is full, the list is unchanged.
+    bool push_back(data_list<identifier_type>& list, Identifier value) noexcept
     {
+        const auto new_index = list.alloc(value);
+        if (new_index < 0)
+            return false;
+
         if (m_last >= 0) {
-            auto new_index = list.alloc(value);
             list.items[new_index].previous = m_last;
             list.items[m_last].next = new_index;
             m_last = new_index;
         } else {
-            m_last = m_first = list.alloc(value);
+            m_last = m_first = new_index;
         }
+
+        ++m_size;
+
+        return true;
     }
 
     void pop_front(data_list<identifier_type>& list) noexcept
@@ -293,23 +329,123 @@ public:
         return do_erase(list, it.m_current);
     }
 
-    int size(data_list<identifier_type>& list) const noexcept
+    /**
+     * @brief Moves the elements of @c other before @c pos in O(1), @c other
+     * is empty after. The two lists must use the same @c data_list.
+     */
+    void splice(data_list<identifier_type>& list,
+                iterator pos,
+                id_list& other) noexcept
+    {
+        if (&other == this || other.m_first == -1)
+            return;
+
+        link_before(list, pos, other.m_first, other.m_last, other.m_size);
+
+        other.m_first = -1;
+        other.m_last = -1;
+        other.m_size = 0;
+    }
+
+    /**
+     * @brief Moves the element @c it of @c other before @c pos in O(1).
+     * The two lists must use the same @c data_list.
+     */
+    void splice(data_list<identifier_type>& list,
+                iterator pos,
+                id_list& other,
+                iterator it) noexcept
+    {
+        const auto index = it.m_current;
+        assert(index >= 0);
+
+        if (pos.m_current == index)
+            return;
+
+        other.unlink(list, index);
+        link_before(list, pos, index, index, 1);
+    }
+
+    /**
+     * @brief Replaces the elements with the identifiers of [first, last[.
+     *
+     * @return false if the @c data_list is full, the list keeps the
+     * identifiers before the overflow.
+     */
+    template<typename InputIterator>
+    bool assign(data_list<identifier_type>& list,
+                InputIterator first,
+                InputIterator last) noexcept
+    {
+        clear(list);
+
+        for (; first != last; ++first)
+            if (!push_back(list, *first))
+                return false;
+
+        return true;
+    }
+
+    /**
+     * @brief Sorts the identifiers with @c comp, equal elements keep their
+     * order. The identifiers are sorted in a vector then written back
+     * along the chain: the links do not change.
+     *
+     * @code
+     * // Sorts the children by their type.
+     * node.children.sort(model.links, [&model](auto lhs, auto rhs) {
+     *     return model.nodes.get(lhs).type < model.nodes.get(rhs).type;
+     * });
+     * @endcode
+     */
+    template<typename Compare = std::less<identifier_type>>
+    void sort(data_list<identifier_type>& list, Compare comp = Compare{})
     {
-        int ret = 0;
+        std::vector<identifier_type> ids;
+        ids.reserve(m_size);
 
         for (auto i = m_first; i != -1; i = list.items[i].next)
-            ++ret;
+            ids.emplace_back(list.items[i].id);
+
+        std::stable_sort(std::begin(ids), std::end(ids), comp);
 
-        return ret;
+        auto it = std::begin(ids);
+        for (auto i = m_first; i != -1; i = list.items[i].next)
+            list.items[i].id = *it++;
     }
 
-    void clear(data_list<identifier_type>& list) noexcept
+    int size(const data_list<identifier_type>& /*list*/) const noexcept
+    {
+        return m_size;
+    }
+
+    int size() const noexcept
+    {
+        return m_size;
+    }
+
+    /**
+     * @brief Replaces each identifier @c id of the list with @c fct(id),
+     * for example with the @c id_remap of a @c data_array::compact().
+     */
+    template<typename Function>
+    void remap(data_list<identifier_type>& list, Function fct) noexcept
     {
         for (auto i = m_first; i != -1; i = list.items[i].next)
-            free(i);
+            list.items[i].id = fct(list.items[i].id);
+    }
+
+    void clear(data_list<identifier_type>& list) noexcept
+    {
+        for (auto i = m_first; i != -1;) {
+            const auto next = list.items[i].next;
+            list.free(i);
+            i = next;
+        }
 
         m_first = -1;
         m_last = -1;
+        m_size = 0;
     }
 
     template<typename Function>
@@ -339,7 +475,7 @@ public:
 
     iterator begin(data_list<identifier_type>& list) noexcept
     {
-        return iterator(list, this, m_first);
+        return iterator(list, this, first_current());
     }
 
     iterator end(data_list<identifier_type>& list) noexcept
@@ -349,7 +485,7 @@ public:
 
     const_iterator begin(const data_list<identifier_type>& list) const noexcept
     {
-        return const_iterator(list, this, m_first);
+        return const_iterator(list, this, first_current());
     }
 
     const_iterator end(const data_list<identifier_type>& list) const noexcept
@@ -360,7 +496,7 @@ public:
     const_iterator cbegin(const data_list<identifier_type>& list) const
       noexcept
     {
-        return const_iterator(list, this, m_first);
+        return const_iterator(list, this, first_current());
     }
 
     const_iterator cend(const data_list<identifier_type>& list) const noexcept
@@ -405,6 +541,12 @@ public:
     }
 
 private:
+    // The position of begin(): the end for an empty list.
+    int first_current() const noexcept
+    {
+        return m_first == -1 ? iterator::current_exceed_end : m_first;
+    }
+
     void do_pop_front(data_list<identifier_type>& list) noexcept
     {
         auto to_delete = m_first;
@@ -415,6 +557,7 @@ private:
             list.items[m_first].previous = -1;
         }
         list.free(to_delete);
+        --m_size;
     }
 
     void do_pop_back(data_list<identifier_type>& list) noexcept
@@ -427,6 +570,7 @@ private:
             list.items[m_last].next = -1;
         }
         list.free(to_delete);
+        --m_size;
     }
 
     iterator do_erase(data_list<identifier_type>& list, int index) noexcept
@@ -458,9 +602,63 @@ private:
         }
 
         list.free(index);
+        --m_size;
 
         return iterator(list, this, current == -1 ? m_first : current);
     }
+
+    // Removes the element @c index from the chain without freeing it.
+    void unlink(data_list<identifier_type>& list, int index) noexcept
+    {
+        const auto previous = list.items[index].previous;
+        const auto next = list.items[index].next;
+
+        if (previous != -1)
+            list.items[previous].next = next;
+        else
+            m_first = next;
+
+        if (next != -1)
+            list.items[next].previous = previous;
+        else
+            m_last = previous;
+
+        list.items[index].previous = -1;
+        list.items[index].next = -1;
+        --m_size;
+    }
+
+    // Links the chain [first, last] of @c number elements before @c pos.
+    void link_before(data_list<identifier_type>& list,
+                     iterator pos,
+                     int first,
+                     int last,
+                     int number) noexcept
+    {
+        auto before = pos.m_current;
+        if (before == iterator::current_exceed_first)
+            before = m_first;
+        else if (before == iterator::current_exceed_end)
+            before = -1;
+
+        const auto previous =
+          before == -1 ? m_last : list.items[before].previous;
+
+        list.items[first].previous = previous;
+        list.items[last].next = before;
+
+        if (previous != -1)
+            list.items[previous].next = first;
+        else
+            m_first = first;
+
+        if (before != -1)
+            list.items[before].previous = last;
+        else
+            m_last = last;
+
+        m_size += number;
+    }
 };
 
 // A convenient class to be used in ranged-base loop
@@ -494,10 +692,68 @@ public:
 };
 
 /**
- * @brief An optimized fixed size array for dynamics objects.
+ * @brief The memory statistics of a @c data_list or a @c chunk_list.
+ */
+struct list_stats
+{
+    int size;       // number of items used
+    int high_water; // largest number of items used since init()
+    int max_used;   // highest index ever allocated
+    int capacity;   // number of allocated items
+    int growths;    // number of reallocations by alloc()
+    int overflows;  // number of alloc() of a full list
+};
+
+namespace details {
+
+/// The smallest number of items added by a growth of a list.
+constexpr int list_growth = 256;
+
+// The capacity after a growth: 1.5 times the capacity, rounded up to a
+// multiple of list_growth, at most max_capacity.
+inline int
+grown_capacity(int capacity, int max_capacity) noexcept
+{
+    const auto wanted = static_cast<std::int64_t>(capacity) +
+                        std::max(capacity / 2, list_growth);
+    const auto rounded = (wanted + list_growth - 1) / list_growth * list_growth;
+
+    return static_cast<int>(
+      std::min(rounded, static_cast<std::int64_t>(max_capacity)));
+}
+
+// Moves the @c used first items in a new vector of @c new_capacity items.
+template<typename Item>
+Item*
+reallocate_items(std::pmr::memory_resource* resource,
+                 Item* items,
+                 int used,
+                 int capacity,
+                 int new_capacity)
+{
+    static_assert(std::is_trivially_copyable<Item>::value,
+                  "list items are moved by copy");
+
+    auto* ret = static_cast<Item*>(
+      resource->allocate(sizeof(Item) * new_capacity, alignof(Item)));
+
+    std::uninitialized_copy_n(items, used, ret);
+    for (int i = used; i != new_capacity; ++i)
+        new (&ret[i]) Item();
+
+    if (items)
+        resource->deallocate(items, sizeof(Item) * capacity, alignof(Item));
+
+    return ret;
+}
+
+} // namespace details
+
+/**
+ * @brief An optimized array for dynamics objects.
  * @details Handles everything from any trivial, pod or object.
  * - linear memory/iteration
- * - O(1) alloc/free
+ * - O(1) alloc/free, the items grow by 1.5 when the free list is empty
  * - stable indices
  * - weak references
  * - zero overhead derefs
@@ -522,6 +778,7 @@ public:
 
     friend id_list_iterator<identifier_type>;
     friend id_list<identifier_type>;
+    friend list_access<this_type>; // The Model snapshots.
 
 private:
     struct item
@@ -559,35 +816,82 @@ private:
 public:
     data_list() noexcept = default;
 
+    /// The items are allocated in @c resource_.
+    explicit data_list(std::pmr::memory_resource* resource_) noexcept
+      : resource(resource_)
+    {}
+
     ~data_list() noexcept
     {
-        delete[] items;
+        clear();
     }
 
-    bool init(int capacity_)
+    /**
+     * @brief Allocates @c capacity_ items, alloc() allocates more items
+     * up to @c max_capacity_.
+     *
+     * @return false if capacity_ is not in [0..max_capacity_].
+     */
+    bool init(int capacity_,
+              int max_capacity_ = std::numeric_limits<int>::max())
     {
-        if (capacity_ <= 0)
-            return false;
         clear();
 
-        items = new item[capacity_];
+        if (capacity_ < 0 || capacity_ > max_capacity_)
+            return false;
+
+        max_capacity = max_capacity_;
+
+        return reserve(capacity_);
+    }
+
+    /**
+     * @brief Allocates the items for @c capacity_ items. The references
+     * to the identifiers are invalidated, the indices are not.
+     *
+     * @return false if capacity_ is greater than the max capacity.
+     */
+    bool reserve(int capacity_)
+    {
+        if (capacity_ <= capacity)
+            return true;
+
+        if (capacity_ > max_capacity)
+            return false;
+
+        items = details::reallocate_items(
+          resource, items, max_used, capacity, capacity_);
         capacity = capacity_;
-        free_head = -1;
 
         return true;
     }
 
     void clear()
     {
-        delete[] items;
+        static_assert(std::is_trivially_destructible<item>::value,
+                      "data_list items are released without destructor");
+
+        if (items)
+            resource->deallocate(items, sizeof(item) * capacity, alignof(item));
+
         items = nullptr;
 
         max_size = 0;
         max_used = 0;
         capacity = 0;
         free_head = -1;
+        high_water = 0;
+        growths = 0;
+        overflows = 0;
     }
 
+    /**
+     * @brief Takes an item from the free list or at the end of the items,
+     * the items grow if needed.
+     *
+     * @return The index of the item or -1 if the list is full (see
+     * full()).
+     */
     int alloc(identifier_type id) noexcept
     {
         int new_index;
@@ -596,6 +900,11 @@ public:
             new_index = free_head;
             free_head = items[free_head].next;
         } else {
+            if (max_used == capacity && !grow()) {
+                ++overflows;
+                return -1;
+            }
+
             new_index = max_used++;
         }
 
@@ -604,6 +913,7 @@ public:
         items[new_index].next = -1;
 
         ++max_size;
+        high_water = std::max(high_water, max_size);
 
         return new_index;
     }
@@ -619,16 +929,769 @@ public:
         --max_size;
     }
 
-    bool full() const noexcept;
+    /// All the items are used and the max capacity is reached.
+    bool full() const noexcept
+    {
+        return free_head == -1 && max_used == max_capacity;
+    }
+
+    int size() const noexcept
+    {
+        return max_size;
+    }
 
-    int size() const noexcept;
+    list_stats stats() const noexcept
+    {
+        return list_stats{ max_size,  high_water, max_used,
+                           capacity,  growths,    overflows };
+    }
 
 private:
+    bool grow() noexcept
+    {
+        const auto new_capacity =
+          details::grown_capacity(capacity, max_capacity);
+
+        if (new_capacity <= capacity)
+            return false;
+
+        reserve(new_capacity);
+        ++growths;
+
+        return true;
+    }
+
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource();
     item* items = nullptr; // items vector.
     int max_size = 0;      // total size
     int max_used = 0;      // highest index ever allocated
     int capacity = 0;      // num allocated items
     int free_head = -1;    // index of first free entry
+    int max_capacity = std::numeric_limits<int>::max();
+    int high_water = 0; // largest max_size since init()
+    int growths = 0;    // number of reallocations by alloc()
+    int overflows = 0;  // number of alloc() of a full list
+};
+
+/**
+ * @brief A chunk of an @c unrolled_id_list: the identifiers fill a cache
+ * line with the link to the next chunk and the number of identifiers (14
+ * @c ID or 7 @c WID).
+ */
+template<typename Identifier>
+struct alignas(64) id_chunk
+{
+    static constexpr int capacity =
+      static_cast<int>((64 - 2 * sizeof(std::int32_t)) / sizeof(Identifier));
+
+    Identifier ids[capacity];
+    std::int32_t next = -1;
+    std::int32_t size = 0;
+};
+
+static_assert(sizeof(id_chunk<std::uint32_t>) == 64 &&
+                id_chunk<std::uint32_t>::capacity == 14,
+              "id_chunk<ID> must fill a cache line");
+static_assert(sizeof(id_chunk<std::uint64_t>) == 64 &&
+                id_chunk<std::uint64_t>::capacity == 7,
+              "id_chunk<WID> must fill a cache line");
+
+template<typename Identifier>
+class unrolled_id_list_iterator
+{
+public:
+    using this_type = unrolled_id_list_iterator<Identifier>;
+    using identifier_type = Identifier;
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = identifier_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = identifier_type*;
+    using reference = identifier_type&;
+
+private:
+    chunk_list<identifier_type>* m_list = nullptr;
+    int m_chunk = -1;    // -1 for the end.
+    int m_previous = -1; // the chunk before m_chunk, for erase.
+    int m_position = 0;
+
+public:
+    unrolled_id_list_iterator() noexcept = default;
+
+    unrolled_id_list_iterator(chunk_list<identifier_type>* list,
+                              int chunk,
+                              int previous,
+                              int position) noexcept
+      : m_list(list)
+      , m_chunk(chunk)
+      , m_previous(previous)
+      , m_position(position)
+    {}
+
+    this_type& operator++() noexcept
+    {
+        if (++m_position == m_list->items[m_chunk].size) {
+            m_previous = m_chunk;
+            m_chunk = m_list->items[m_chunk].next;
+            m_position = 0;
+        }
+
+        return *this;
+    }
+
+    this_type operator++(int) noexcept
+    {
+        auto copy = *this;
+        ++*this;
+        return copy;
+    }
+
+    reference operator*() const noexcept
+    {
+        return m_list->items[m_chunk].ids[m_position];
+    }
+
+    pointer operator->() const noexcept
+    {
+        return &m_list->items[m_chunk].ids[m_position];
+    }
+
+    friend bool operator==(const this_type& lhs, const this_type& rhs) noexcept
+    {
+        return lhs.m_chunk == rhs.m_chunk && lhs.m_position == rhs.m_position;
+    }
+
+    friend bool operator!=(const this_type& lhs, const this_type& rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+
+    friend class unrolled_id_list<identifier_type>;
+};
+
+/**
+ * @brief A list of identifiers stored by chunks of a cache line in a
+ * @c chunk_list. It has the API of @c id_list: a walk over n identifiers
+ * reads n / 14 (@c ID) cache lines instead of n.
+ * @details The chunks are linked in one direction: the iterators are
+ * forward iterators, they keep the previous chunk for @c erase. A chunk is
+ * never empty, the chunks in the middle of the list may be partially
+ * filled after @c erase, @c push_front or @c splice.
+ */
+template<typename Identifier>
+class unrolled_id_list
+{
+public:
+    using this_type = unrolled_id_list<Identifier>;
+    using identifier_type = Identifier;
+    using iterator = unrolled_id_list_iterator<identifier_type>;
+    using const_iterator = unrolled_id_list_iterator<identifier_type>;
+    using reference = identifier_type&;
+    using const_reference = identifier_type;
+    using chunk_type = id_chunk<identifier_type>;
+
+    /// A range for the range-based for loop.
+    class range
+    {
+        iterator m_first, m_last;
+
+    public:
+        range(iterator first, iterator last) noexcept
+          : m_first(first)
+          , m_last(last)
+        {}
+
+        iterator begin() const noexcept
+        {
+            return m_first;
+        }
+
+        iterator end() const noexcept
+        {
+            return m_last;
+        }
+    };
+
+private:
+    int m_first = -1;
+    int m_last = -1;
+    int m_size = 0;
+
+public:
+    unrolled_id_list() noexcept = default;
+
+    reference front(chunk_list<identifier_type>& list) noexcept
+    {
+        return list.items[m_first].ids[0];
+    }
+
+    const_reference front(const chunk_list<identifier_type>& list) const
+      noexcept
+    {
+        return list.items[m_first].ids[0];
+    }
+
+    reference back(chunk_list<identifier_type>& list) noexcept
+    {
+        auto& chunk = list.items[m_last];
+        return chunk.ids[chunk.size - 1];
+    }
+
+    const_reference back(const chunk_list<identifier_type>& list) const
+      noexcept
+    {
+        const auto& chunk = list.items[m_last];
+        return chunk.ids[chunk.size - 1];
+    }
+
+    /// @return false if the @c chunk_list is full, the list is unchanged.
+    bool push_back(chunk_list<identifier_type>& list,
+                   identifier_type value) noexcept
+    {
+        if (m_last < 0 || list.items[m_last].size == chunk_type::capacity) {
+            const auto index = list.alloc();
+            if (index < 0)
+                return false;
+
+            if (m_last >= 0)
+                list.items[m_last].next = index;
+            else
+                m_first = index;
+
+            m_last = index;
+        }
+
+        auto& chunk = list.items[m_last];
+        chunk.ids[chunk.size++] = value;
+        ++m_size;
+
+        return true;
+    }
+
+    /// @return false if the @c chunk_list is full, the list is unchanged.
+    bool push_front(chunk_list<identifier_type>& list,
+                    identifier_type value) noexcept
+    {
+        if (m_first < 0 || list.items[m_first].size == chunk_type::capacity) {
+            const auto index = list.alloc();
+            if (index < 0)
+                return false;
+
+            list.items[index].next = m_first;
+
+            if (m_first < 0)
+                m_last = index;
+
+            m_first = index;
+        }
+
+        auto& chunk = list.items[m_first];
+        std::copy_backward(
+          chunk.ids, chunk.ids + chunk.size, chunk.ids + chunk.size + 1);
+        chunk.ids[0] = value;
+        ++chunk.size;
+        ++m_size;
+
+        return true;
+    }
+
+    void pop_front(chunk_list<identifier_type>& list) noexcept
+    {
+        if (m_first >= 0)
+            erase(list, begin(list));
+    }
+
+    /**
+     * @brief Removes the identifier of @c it.
+     *
+     * @return An iterator to the identifier after @c it.
+     */
+    iterator erase(chunk_list<identifier_type>& list, iterator it) noexcept
+    {
+        auto& chunk = list.items[it.m_chunk];
+        const auto next = chunk.next;
+
+        std::copy(chunk.ids + it.m_position + 1,
+                  chunk.ids + chunk.size,
+                  chunk.ids + it.m_position);
+        --chunk.size;
+        --m_size;
+
+        if (chunk.size == 0) {
+            unlink(list, it.m_chunk, it.m_previous);
+            return iterator(&list, next, it.m_previous, 0);
+        }
+
+        if (it.m_position == chunk.size)
+            return iterator(&list, next, it.m_chunk, 0);
+
+        return it;
+    }
+
+    /**
+     * @brief Moves the identifiers of @c other at the end of the list in
+     * O(1), @c other is empty after. The two lists must use the same
+     * @c chunk_list.
+     */
+    void splice(chunk_list<identifier_type>& list, this_type& other) noexcept
+    {
+        if (&other == this || other.m_first < 0)
+            return;
+
+        if (m_last >= 0)
+            list.items[m_last].next = other.m_first;
+        else
+            m_first = other.m_first;
+
+        m_last = other.m_last;
+        m_size += other.m_size;
+
+        other.m_first = -1;
+        other.m_last = -1;
+        other.m_size = 0;
+    }
+
+    /**
+     * @brief Replaces the identifiers with the ones of [first, last[, the
+     * chunks are filled.
+     *
+     * @return false if the @c chunk_list is full, the list keeps the
+     * identifiers before the overflow.
+     */
+    template<typename InputIterator>
+    bool assign(chunk_list<identifier_type>& list,
+                InputIterator first,
+                InputIterator last) noexcept
+    {
+        clear(list);
+
+        for (; first != last; ++first)
+            if (!push_back(list, *first))
+                return false;
+
+        return true;
+    }
+
+    /**
+     * @brief Sorts the identifiers with @c comp, equal elements keep their
+     * order. The chunks do not change.
+     */
+    template<typename Compare = std::less<identifier_type>>
+    void sort(chunk_list<identifier_type>& list, Compare comp = Compare{})
+    {
+        std::vector<identifier_type> ids(std::begin(list_range(list)),
+                                         std::end(list_range(list)));
+
+        std::stable_sort(std::begin(ids), std::end(ids), comp);
+        std::copy(std::begin(ids), std::end(ids), begin(list));
+    }
+
+    /**
+     * @brief Replaces each identifier @c id of the list with @c fct(id).
+     */
+    template<typename Function>
+    void remap(chunk_list<identifier_type>& list, Function fct) noexcept
+    {
+        for (auto i = m_first; i != -1; i = list.items[i].next) {
+            auto& chunk = list.items[i];
+            for (int j = 0; j != chunk.size; ++j)
+                chunk.ids[j] = fct(chunk.ids[j]);
+        }
+    }
+
+    void clear(chunk_list<identifier_type>& list) noexcept
+    {
+        for (auto i = m_first; i != -1;) {
+            const auto next = list.items[i].next;
+            list.free(i);
+            i = next;
+        }
+
+        m_first = -1;
+        m_last = -1;
+        m_size = 0;
+    }
+
+    /**
+     * @brief Removes the identifiers @c id where @c fct(id) is true, in
+     * one pass: the kept identifiers are packed at the front of the chunks
+     * and the chunks left empty are freed.
+     */
+    template<typename Function>
+    void clear(chunk_list<identifier_type>& list, Function fct) noexcept
+    {
+        if (m_first < 0)
+            return;
+
+        int write_chunk = m_first;
+        int write_position = 0;
+        int kept = 0;
+
+        for (auto i = m_first; i != -1; i = list.items[i].next) {
+            auto& chunk = list.items[i];
+            for (int j = 0; j != chunk.size; ++j) {
+                if (fct(chunk.ids[j]))
+                    continue;
+
+                if (write_position == chunk_type::capacity) {
+                    list.items[write_chunk].size = write_position;
+                    write_chunk = list.items[write_chunk].next;
+                    write_position = 0;
+                }
+
+                list.items[write_chunk].ids[write_position++] = chunk.ids[j];
+                ++kept;
+            }
+        }
+
+        if (kept == 0) {
+            clear(list);
+            return;
+        }
+
+        auto& last = list.items[write_chunk];
+        const auto next = last.next;
+        last.size = write_position;
+        last.next = -1;
+        m_last = write_chunk;
+        m_size = kept;
+
+        for (auto i = next; i != -1;) {
+            const auto following = list.items[i].next;
+            list.free(i);
+            i = following;
+        }
+    }
+
+    range operator()(chunk_list<identifier_type>& list) noexcept
+    {
+        return list_range(list);
+    }
+
+    range operator()(const chunk_list<identifier_type>& list) const noexcept
+    {
+        return list_range(const_cast<chunk_list<identifier_type>&>(list));
+    }
+
+    bool empty() const noexcept
+    {
+        return m_first == -1;
+    }
+
+    int size(const chunk_list<identifier_type>& /*list*/) const noexcept
+    {
+        return m_size;
+    }
+
+    int size() const noexcept
+    {
+        return m_size;
+    }
+
+    iterator begin(chunk_list<identifier_type>& list) noexcept
+    {
+        return iterator(&list, m_first, -1, 0);
+    }
+
+    iterator end(chunk_list<identifier_type>& list) noexcept
+    {
+        return iterator(&list, -1, m_last, 0);
+    }
+
+private:
+    range list_range(chunk_list<identifier_type>& list) const noexcept
+    {
+        return range(iterator(&list, m_first, -1, 0),
+                     iterator(&list, -1, m_last, 0));
+    }
+
+    // Removes the empty chunk @c index which follows @c previous.
+    void unlink(chunk_list<identifier_type>& list,
+                int index,
+                int previous) noexcept
+    {
+        const auto next = list.items[index].next;
+
+        if (previous >= 0)
+            list.items[previous].next = next;
+        else
+            m_first = next;
+
+        if (m_last == index)
+            m_last = previous;
+
+        list.free(index);
+    }
+};
+
+/**
+ * @brief The chunks of the @c unrolled_id_list, a growable array with a
+ * free list like @c data_list.
+ */
+template<typename Identifier>
+class chunk_list
+{
+public:
+    using this_type = chunk_list<Identifier>;
+    using identifier_type = Identifier;
+    using chunk_type = id_chunk<identifier_type>;
+
+    friend unrolled_id_list_iterator<identifier_type>;
+    friend unrolled_id_list<identifier_type>;
+    friend list_access<this_type>; // The Model snapshots.
+
+    chunk_list() noexcept = default;
+
+    /// The chunks are allocated in @c resource_.
+    explicit chunk_list(std::pmr::memory_resource* resource_) noexcept
+      : resource(resource_)
+    {}
+
+    chunk_list(const chunk_list&) = delete;
+    chunk_list& operator=(const chunk_list&) = delete;
+
+    ~chunk_list() noexcept
+    {
+        clear();
+    }
+
+    /**
+     * @brief Allocates @c capacity_ chunks, alloc() allocates more chunks
+     * up to @c max_capacity_.
+     *
+     * @return false if capacity_ is not in [0..max_capacity_].
+     */
+    bool init(int capacity_,
+              int max_capacity_ = std::numeric_limits<int>::max())
+    {
+        clear();
+
+        if (capacity_ < 0 || capacity_ > max_capacity_)
+            return false;
+
+        max_capacity = max_capacity_;
+
+        return reserve(capacity_);
+    }
+
+    /**
+     * @brief Allocates @c capacity_ chunks. The references to the
+     * identifiers are invalidated, the indices are not.
+     *
+     * @return false if capacity_ is greater than the max capacity.
+     */
+    bool reserve(int capacity_)
+    {
+        if (capacity_ <= capacity)
+            return true;
+
+        if (capacity_ > max_capacity)
+            return false;
+
+        items = details::reallocate_items(
+          resource, items, max_used, capacity, capacity_);
+        capacity = capacity_;
+
+        return true;
+    }
+
+    void clear() noexcept
+    {
+        if (items)
+            resource->deallocate(items, sizeof(item) * capacity, alignof(item));
+
+        items = nullptr;
+        max_size = 0;
+        max_used = 0;
+        capacity = 0;
+        free_head = -1;
+        high_water = 0;
+        growths = 0;
+        overflows = 0;
+    }
+
+    /// The number of chunks used by the lists.
+    int size() const noexcept
+    {
+        return max_size;
+    }
+
+    /// All the chunks are used and the max capacity is reached.
+    bool full() const noexcept
+    {
+        return free_head == -1 && max_used == max_capacity;
+    }
+
+    list_stats stats() const noexcept
+    {
+        return list_stats{ max_size,  high_water, max_used,
+                           capacity,  growths,    overflows };
+    }
+
+private:
+    int alloc() noexcept
+    {
+        int new_index;
+
+        if (free_head >= 0) {
+            new_index = free_head;
+            free_head = items[free_head].next;
+        } else {
+            if (max_used == capacity && !grow()) {
+                ++overflows;
+                return -1;
+            }
+
+            new_index = max_used++;
+        }
+
+        items[new_index].next = -1;
+        items[new_index].size = 0;
+
+        ++max_size;
+        high_water = std::max(high_water, max_size);
+
+        return new_index;
+    }
+
+    void free(int index) noexcept
+    {
+        items[index].size = 0;
+        items[index].next = free_head;
+
+        free_head = index;
+
+        --max_size;
+    }
+
+    bool grow() noexcept
+    {
+        const auto new_capacity =
+          details::grown_capacity(capacity, max_capacity);
+
+        if (new_capacity <= capacity)
+            return false;
+
+        reserve(new_capacity);
+        ++growths;
+
+        return true;
+    }
+
+    using item = chunk_type;
+
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+    item* items = nullptr; // chunks vector.
+    int max_size = 0;      // number of chunks of the lists
+    int max_used = 0;      // highest index ever allocated
+    int capacity = 0;      // num allocated chunks
+    int free_head = -1;    // index of first free chunk
+    int max_capacity = std::numeric_limits<int>::max();
+    int high_water = 0; // largest max_size since init()
+    int growths = 0;    // number of reallocations by alloc()
+    int overflows = 0;  // number of alloc() of a full list
+};
+
+/**
+ * @brief A view of a contiguous sequence, the subset of @c std::span used
+ * by the library (C++17).
+ */
+template<typename T>
+class span
+{
+public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using iterator = T*;
+
+    constexpr span() noexcept = default;
+
+    constexpr span(T* data, int size) noexcept
+      : m_data(data)
+      , m_size(size)
+    {}
+
+    constexpr T* data() const noexcept
+    {
+        return m_data;
+    }
+
+    constexpr int size() const noexcept
+    {
+        return m_size;
+    }
+
+    constexpr bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    constexpr T& operator[](int i) const noexcept
+    {
+        assert(i >= 0 && i < m_size);
+
+        return m_data[i];
+    }
+
+    constexpr iterator begin() const noexcept
+    {
+        return m_data;
+    }
+
+    constexpr iterator end() const noexcept
+    {
+        return m_data + m_size;
+    }
+
+private:
+    T* m_data = nullptr;
+    int m_size = 0;
+};
+
+/**
+ * @brief Lists of identifiers in compressed sparse row format: the list
+ * of the row @c i is [ids[offsets[i]], ids[offsets[i + 1]][. The lists
+ * are immutable, a walk over the rows is a sequential scan.
+ */
+template<typename Identifier>
+struct id_csr
+{
+    using identifier_type = Identifier;
+
+    std::vector<int> offsets{ 0 };
+    std::vector<identifier_type> ids;
+
+    void clear() noexcept
+    {
+        offsets.assign(1, 0);
+        ids.clear();
+    }
+
+    int rows() const noexcept
+    {
+        return static_cast<int>(offsets.size()) - 1;
+    }
+
+    /// Appends a row with the identifiers of [first, last[.
+    template<typename InputIterator>
+    void push_back(InputIterator first, InputIterator last)
+    {
+        ids.insert(ids.end(), first, last);
+        offsets.emplace_back(static_cast<int>(ids.size()));
+    }
+
+    /// Appends an empty row.
+    void push_back()
+    {
+        offsets.emplace_back(static_cast<int>(ids.size()));
+    }
+
+    span<const identifier_type> operator[](int row) const noexcept
+    {
+        assert(row >= 0 && row < rows());
+
+        return span<const identifier_type>(ids.data() + offsets[row],
+                                           offsets[row + 1] - offsets[row]);
+    }
 };
 
 } // irr
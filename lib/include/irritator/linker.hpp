@@ -5,9 +5,18 @@
 #ifndef ORG_VLEPROJECT_IRRITATOR_LINKER_HPP
 #define ORG_VLEPROJECT_IRRITATOR_LINKER_HPP
 
+#include <irritator/data-array.hpp>
+#include <irritator/data-list.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <utility>
 #include <vector>
 
 #include <cassert>
+#include <cstdint>
 
 namespace irr {
 
@@ -26,7 +35,7 @@ namespace irr {
  */
 template<typename Identifier,
          typename Referenced,
-         typename Allocator = std::allocator<Identifier>>
+         typename Allocator = std::allocator<Referenced>>
 class linker
 {
 public:
@@ -43,6 +52,10 @@ public:
 
     linker() = default;
 
+    explicit linker(const Allocator& allocator)
+      : items(allocator)
+    {}
+
     void init(int capacity)
     {
         assert(capacity > 0);
@@ -92,10 +105,321 @@ public:
 
         items[irr::get_index(id)] = { 0 };
     }
+
+    /**
+     * @brief Moves the entries to the new indices of the identifiers after
+     * a @c data_array::compact(), the entries of freed identifiers are
+     * destroyed.
+     */
+    void remap_identifiers(const id_remap<identifier_type>& remap) noexcept
+    {
+        const auto number =
+          std::min(size(), static_cast<int>(remap.old_ids.size()));
+
+        // The new index is never greater than the old index: the entries
+        // before the old index are already moved or destroyed.
+        for (int i = 0; i != number; ++i) {
+            if (!irr::valid(remap.old_ids[i])) {
+                items[i] = { 0 };
+                continue;
+            }
+
+            const auto index = irr::get_index(remap.new_ids[i]);
+            if (index != i) {
+                items[index] = items[i];
+                items[i] = { 0 };
+            }
+        }
+    }
+
+    /**
+     * @brief Replaces each referenced identifier @c id with @c fct(id), for
+     * example with the @c id_remap of a @c data_array::compact().
+     */
+    template<typename Function>
+    void remap_references(Function fct) noexcept
+    {
+        for (auto& item : items)
+            if (irr::valid(item))
+                item = fct(item);
+    }
 };
 
-template<typename T, typename Identifier>
-struct data_array;
+/**
+ * @brief A @c linker for large or sparse identifier spaces: the entries are
+ * stored in an open addressing hash table keyed by the index of the
+ * identifier.
+ * @details The memory depends on the number of entries and not on the
+ * largest index. The table uses Robin Hood probing with backward shift
+ * deletion and keeps at most 7/8 of its slots used: a lookup reads a few
+ * contiguous slots, a missing entry is detected as soon as a slot is
+ * closer to its home than the probe.
+ *
+ * Like the @c linker, an entry is destroyed by @c destroy and a missing
+ * entry reads as the null identifier. A reference returned by
+ * @c operator[] is invalidated by the next insertion or @c destroy.
+ *
+ * @code
+ * // A few bindings in the 2^32 indices of the WID.
+ * irr::sparse_linker<irr::WID, irr::ID> bindings;
+ * bindings.emplace(model_id, observer_id);
+ * if (auto* obs = bindings.try_to_get(&observers, model_id))
+ *     ...
+ * @endcode
+ */
+template<typename Identifier,
+         typename Referenced,
+         typename Allocator = std::allocator<Referenced>>
+class sparse_linker
+{
+public:
+    using identifier_type = Identifier;
+    using referenced_type = Referenced;
+
+private:
+    struct slot
+    {
+        referenced_type value = { 0 };
+        std::uint32_t index = 0;
+        std::uint32_t distance = 0; // probe length plus one, 0 if empty.
+    };
+
+    using slot_allocator = typename std::allocator_traits<
+      Allocator>::template rebind_alloc<slot>;
+
+    std::vector<slot, slot_allocator> slots;
+    int m_size = 0;
+    int shift = 64;
+
+    static std::uint32_t index_of(const identifier_type id) noexcept
+    {
+        return static_cast<std::uint32_t>(irr::get_index(id));
+    }
+
+    // Fibonacci hashing: the high bits of the product are the home slot.
+    std::size_t home(std::uint32_t index) const noexcept
+    {
+        return static_cast<std::size_t>(
+          (static_cast<std::uint64_t>(index) * 0x9e3779b97f4a7c15u) >> shift);
+    }
+
+    int find(std::uint32_t index) const noexcept
+    {
+        if (slots.empty())
+            return -1;
+
+        const auto mask = slots.size() - 1;
+        auto pos = home(index);
+
+        for (std::uint32_t distance = 1;; ++distance) {
+            const auto& s = slots[pos];
+            if (s.distance < distance)
+                return -1;
+
+            if (s.distance == distance && s.index == index)
+                return static_cast<int>(pos);
+
+            pos = (pos + 1) & mask;
+        }
+    }
+
+    // Inserts a missing entry, returns its slot.
+    int insert(std::uint32_t index, referenced_type value)
+    {
+        if (static_cast<std::size_t>(m_size + 1) * 8 > slots.size() * 7)
+            rehash(slots.empty() ? 16 : slots.size() * 2);
+
+        const auto mask = slots.size() - 1;
+        auto pos = home(index);
+        slot current{ value, index, 1 };
+        int ret = -1;
+
+        for (;; ++current.distance) {
+            auto& s = slots[pos];
+
+            if (s.distance == 0) {
+                s = current;
+                ++m_size;
+                return ret < 0 ? static_cast<int>(pos) : ret;
+            }
+
+            // Robin Hood: the entry closer to its home gives its slot.
+            if (s.distance < current.distance) {
+                std::swap(s, current);
+                if (ret < 0)
+                    ret = static_cast<int>(pos);
+            }
+
+            pos = (pos + 1) & mask;
+        }
+    }
+
+    // Removes the entry of the slot and shifts back the next entries of
+    // the cluster.
+    void erase(std::size_t pos) noexcept
+    {
+        const auto mask = slots.size() - 1;
+        auto next = (pos + 1) & mask;
+
+        while (slots[next].distance > 1) {
+            slots[pos] = slots[next];
+            --slots[pos].distance;
+            pos = next;
+            next = (next + 1) & mask;
+        }
+
+        slots[pos] = slot{};
+        --m_size;
+    }
+
+    void rehash(std::size_t capacity)
+    {
+        std::vector<slot, slot_allocator> old(capacity, slots.get_allocator());
+        old.swap(slots);
+
+        shift = 64;
+        for (auto c = capacity; c > 1; c >>= 1)
+            --shift;
+
+        m_size = 0;
+        for (const auto& s : old)
+            if (s.distance)
+                insert(s.index, s.value);
+    }
+
+public:
+    sparse_linker() = default;
+
+    explicit sparse_linker(const Allocator& allocator)
+      : slots(slot_allocator(allocator))
+    {}
+
+    /// Allocates the slots of @c capacity entries, the table grows beyond.
+    void init(int capacity)
+    {
+        assert(capacity > 0);
+
+        std::size_t slot_number = 16;
+        while (slot_number * 7 < static_cast<std::size_t>(capacity) * 8)
+            slot_number *= 2;
+
+        slots.clear();
+        m_size = 0;
+        rehash(slot_number);
+    }
+
+    void clear() noexcept
+    {
+        std::fill(std::begin(slots), std::end(slots), slot{});
+        m_size = 0;
+    }
+
+    /// The number of entries.
+    int size() const noexcept
+    {
+        return m_size;
+    }
+
+    /// The number of slots.
+    int capacity() const noexcept
+    {
+        return static_cast<int>(slots.size());
+    }
+
+    void emplace(const identifier_type id, const referenced_type value)
+    {
+        assert(irr::valid(id));
+
+        const auto index = index_of(id);
+        const auto pos = find(index);
+
+        if (pos >= 0)
+            slots[pos].value = value;
+        else
+            insert(index, value);
+    }
+
+    template<typename DataArray>
+    typename DataArray::value_type* try_to_get(DataArray* array,
+                                               identifier_type id) const
+      noexcept
+    {
+        assert(irr::valid(id));
+
+        const auto pos = find(index_of(id));
+
+        return pos >= 0 ? array->try_to_get(slots[pos].value) : nullptr;
+    }
+
+    referenced_type operator[](const identifier_type id) const noexcept
+    {
+        assert(irr::valid(id));
+
+        const auto pos = find(index_of(id));
+
+        return pos >= 0 ? slots[pos].value : referenced_type{ 0 };
+    }
+
+    /// Inserts a null entry if @c id has no entry.
+    referenced_type& operator[](const identifier_type id)
+    {
+        assert(irr::valid(id));
+
+        const auto index = index_of(id);
+        auto pos = find(index);
+        if (pos < 0)
+            pos = insert(index, referenced_type{ 0 });
+
+        return slots[pos].value;
+    }
+
+    void destroy(const identifier_type id) noexcept
+    {
+        assert(irr::valid(id));
+
+        const auto pos = find(index_of(id));
+        if (pos >= 0)
+            erase(static_cast<std::size_t>(pos));
+    }
+
+    /**
+     * @brief Moves the entries to the new indices of the identifiers after
+     * a @c data_array::compact(), the entries of freed identifiers are
+     * destroyed.
+     */
+    void remap_identifiers(const id_remap<identifier_type>& remap)
+    {
+        std::vector<slot, slot_allocator> old(slots.get_allocator());
+        old.swap(slots);
+        slots.resize(old.size());
+        m_size = 0;
+
+        const auto number = remap.old_ids.size();
+
+        for (const auto& s : old) {
+            if (!s.distance)
+                continue;
+
+            if (s.index >= number) {
+                insert(s.index, s.value);
+            } else if (irr::valid(remap.old_ids[s.index])) {
+                insert(index_of(remap.new_ids[s.index]), s.value);
+            }
+        }
+    }
+
+    /**
+     * @brief Replaces each referenced identifier @c id with @c fct(id), for
+     * example with the @c id_remap of a @c data_array::compact().
+     */
+    template<typename Function>
+    void remap_references(Function fct) noexcept
+    {
+        for (auto& s : slots)
+            if (s.distance && irr::valid(s.value))
+                s.value = fct(s.value);
+    }
+};
 
 template<typename Referenced>
 struct multi_linker_node
@@ -111,6 +435,29 @@ struct multi_linker_node
     int next = { -1 }; // Next element is the (flat) linked list.
 };
 
+/**
+ * @brief Links an identifier to several referenced identifiers.
+ * @details The links of an identifier are a linked list in a flat
+ * container with a free list: @c emplace and @c destroy are O(1) by link.
+ * The links to a freed referenced item are skipped by the views and stay
+ * in the container until @c erase, @c destroy or @c compact.
+ *
+ * - @c compact rebuilds the flat container sorted by identifier, the links
+ *   of an identifier are contiguous and the free list is empty
+ * - @c freeze stores the links in compressed sparse rows: the container is
+ *   read-only and @c get_range returns the links of an identifier in O(1)
+ *   until @c thaw
+ *
+ * @code
+ * irr::multi_linker<irr::ID, irr::ID> children;
+ * children.init(1024);
+ * children.emplace(parent, child);
+ * children.compact(nodes); // removes the links to freed nodes.
+ * children.freeze();
+ * for (auto id : children.get_range(parent))
+ *     ...
+ * @endcode
+ */
 template<typename Identifier,
          typename Referenced,
          typename IdentifierAllocator = std::allocator<int>,
@@ -122,17 +469,45 @@ public:
       multi_linker<Identifier, Referenced, IdentifierAllocator, NodeAllocator>;
     using identifier_type = Identifier;
     using referenced_type = Referenced;
+    using node_type = multi_linker_node<referenced_type>;
+    using referenced_allocator = typename std::allocator_traits<
+      NodeAllocator>::template rebind_alloc<referenced_type>;
 
 private:
-    /// Map ID to head in the linked list.
+    /// Map ID to head in the linked list, -1 for an empty list.
     std::vector<int, IdentifierAllocator> map;
 
     /// The (flat) linked list in contiguous container.
-    std::vector<multi_linker_node<referenced_type>, NodeAllocator> list;
+    std::vector<node_type, NodeAllocator> list;
+
+    /// The frozen rows: the links of the identifier of index @c i are
+    /// @c ids[offsets[i]] to @c ids[offsets[i + 1] - 1].
+    std::vector<int, IdentifierAllocator> offsets;
+    std::vector<referenced_type, referenced_allocator> ids;
 
     /// The free linked list.
     int free_head = -1;
 
+    /// Number of nodes in the free list.
+    int free_number = 0;
+
+    bool is_frozen = false;
+
+    // The element after @c elem in the row ending at @c last (frozen) or in
+    // the linked list.
+    int next_of(int elem, int last) const noexcept
+    {
+        if (is_frozen)
+            return elem + 1 < last ? elem + 1 : -1;
+
+        return list[elem].next;
+    }
+
+    referenced_type referenced_of(int elem) const noexcept
+    {
+        return is_frozen ? ids[elem] : list[elem].id;
+    }
+
     template<typename DataArray>
     class view
     {
@@ -151,6 +526,15 @@ private:
             this_type* list = nullptr;
             DataArray* dataarray = nullptr;
             int elem = -1;
+            int last = -1;
+
+            // Skips the links to freed items, the container is unchanged.
+            void skip() noexcept
+            {
+                while (elem >= 0 &&
+                       !dataarray->try_to_get(list->referenced_of(elem)))
+                    elem = list->next_of(elem, last);
+            }
 
         public:
             iterator() noexcept = default;
@@ -159,32 +543,27 @@ private:
 
             iterator(this_type& list_,
                      DataArray& dataarray_,
-                     int elem_) noexcept
+                     int elem_,
+                     int last_) noexcept
               : list(&list_)
               , dataarray(&dataarray_)
               , elem(elem_)
+              , last(last_)
             {
                 // Build a valid first iterator
-                while (elem >= 0) {
-                    if (dataarray->try_to_get(list->list[elem].id))
-                        break;
-
-                    int to_delete = elem;
-                    elem = list->list[elem].next;
-
-                    list->list[to_delete].next = list->free_head;
-                    list->free_head = to_delete;
-                }
+                skip();
             }
 
             iterator(iterator&& other) noexcept
               : list(other.list)
               , dataarray(other.dataarray)
               , elem(other.elem)
+              , last(other.last)
             {
                 other.list = nullptr;
                 other.dataarray = nullptr;
                 other.elem = -1;
+                other.last = -1;
             }
 
             iterator& operator=(iterator&& other) noexcept
@@ -193,9 +572,11 @@ private:
                     list = other.list;
                     dataarray = other.dataarray;
                     elem = other.elem;
+                    last = other.last;
                     other.list = nullptr;
                     other.dataarray = nullptr;
                     other.elem = { -1 };
+                    other.last = { -1 };
                 }
 
                 return *this;
@@ -204,24 +585,13 @@ private:
             /**
              * @brief Advance the ID to the next valid ID in the linked list.
              *
-             * @details If a element is invalid, this element is removed from
-             * the list.
+             * @details The links to freed items are skipped.
              */
             void advance() noexcept
             {
                 if (list && elem >= 0) {
-                    int next = list->list[elem].next;
-                    while (next >= 0) {
-                        if (dataarray->try_to_get(list->list[next].id)) {
-                            elem = next;
-                            return;
-                        } else {
-                            list->list[elem].next = list->list[next].next;
-                            list->list[next].next = list->free_head;
-                            list->free_head = next;
-                            next = list->list[elem].next;
-                        }
-                    }
+                    elem = list->next_of(elem, last);
+                    skip();
                 }
             }
 
@@ -240,24 +610,22 @@ private:
 
             pointer operator->() const noexcept
             {
-                return dataarray->try_to_get(list->list[elem].id);
+                return dataarray->try_to_get(list->referenced_of(elem));
             }
 
             reference operator*() const noexcept
             {
-                auto* ptr = dataarray->try_to_get(list->list[elem].id);
+                auto* ptr = dataarray->try_to_get(list->referenced_of(elem));
                 assert(ptr);
                 return *ptr;
             }
 
             friend void swap(iterator& lhs, iterator& rhs) noexcept
             {
-                auto items_ = lhs.items;
-                auto id_ = lhs.id;
-                lhs.items = rhs.items;
-                lhs.id = rhs.id;
-                rhs.items = items_;
-                rhs.id = id_;
+                std::swap(lhs.list, rhs.list);
+                std::swap(lhs.dataarray, rhs.dataarray);
+                std::swap(lhs.elem, rhs.elem);
+                std::swap(lhs.last, rhs.last);
             }
 
             friend bool operator==(const iterator& lhs,
@@ -278,76 +646,195 @@ private:
         this_type& list;
         DataArray& dataarray;
         int elem = -1;
+        int last = -1;
 
     public:
-        view(this_type& list_, DataArray& dataarray_, Identifier elem_) noexcept
+        view(this_type& list_,
+             DataArray& dataarray_,
+             int elem_,
+             int last_) noexcept
           : list(list_)
           , dataarray(dataarray_)
           , elem(elem_)
+          , last(last_)
         {}
 
         iterator begin()
         {
-            return iterator(list, dataarray, elem);
+            return iterator(list, dataarray, elem, last);
         }
 
         iterator end()
         {
-            return iterator(list, dataarray, -1);
+            return iterator(list, dataarray, -1, last);
         }
     };
 
+    // Rebuilds the list with the links which satisfy @c keep, sorted by
+    // identifier index, in the order of the linked lists.
+    template<typename Predicate>
+    void rebuild(Predicate keep)
+    {
+        std::vector<node_type, NodeAllocator> nodes(list.get_allocator());
+        nodes.reserve(list.size() - free_number);
+
+        for (auto& head : map) {
+            auto elem = head;
+            head = -1;
+
+            for (; elem >= 0; elem = list[elem].next) {
+                if (!keep(list[elem].id))
+                    continue;
+
+                const auto pos = static_cast<int>(nodes.size());
+                if (head < 0)
+                    head = pos;
+                else
+                    nodes.back().next = pos;
+
+                nodes.emplace_back(list[elem].id, -1);
+            }
+        }
+
+        list.swap(nodes);
+        free_head = -1;
+        free_number = 0;
+    }
+
 public:
     multi_linker() noexcept = default;
 
+    multi_linker(const IdentifierAllocator& identifier_allocator,
+                 const NodeAllocator& node_allocator)
+      : map(identifier_allocator)
+      , list(node_allocator)
+      , offsets(identifier_allocator)
+      , ids(referenced_allocator(node_allocator))
+    {}
+
     void init(int capacity)
     {
         assert(capacity > 0);
 
-        map.resize(capacity, 0);
+        clear();
+        map.assign(capacity, -1);
 
         // The linked list starts at an empty state and grow automatically
         // except if at least one element is deleted before.
         list.reserve(capacity);
-
-        free_head = -1;
     }
 
     void clear()
     {
-        std::fill(std::begin(map), std::end(map), 0);
+        std::fill(std::begin(map), std::end(map), -1);
         list.clear();
+        offsets.clear();
+        ids.clear();
         free_head = -1;
+        free_number = 0;
+        is_frozen = false;
+    }
+
+    /// The number of links, with the links to freed items.
+    int size() const noexcept
+    {
+        return is_frozen ? static_cast<int>(ids.size())
+                         : static_cast<int>(list.size()) - free_number;
+    }
+
+    bool frozen() const noexcept
+    {
+        return is_frozen;
     }
 
     template<typename DataArray>
     view<DataArray> get_view(identifier_type id, DataArray& dataarray) noexcept
     {
-        return view(*this, dataarray, id);
+        assert(irr::valid(id));
+
+        const auto index = irr::get_index(id);
+
+        if (is_frozen) {
+            const auto first = offsets[index];
+            const auto last = offsets[index + 1];
+
+            return view<DataArray>(
+              *this, dataarray, first < last ? first : -1, last);
+        }
+
+        return view<DataArray>(*this, dataarray, map[index], -1);
+    }
+
+    /**
+     * @brief The links of @c id, with the links to freed items, in a frozen
+     * multi_linker.
+     */
+    span<const referenced_type> get_range(identifier_type id) const noexcept
+    {
+        assert(is_frozen);
+        assert(irr::valid(id));
+
+        const auto index = irr::get_index(id);
+
+        return span<const referenced_type>(
+          ids.data() + offsets[index], offsets[index + 1] - offsets[index]);
     }
 
     void emplace(Identifier ID, Referenced value) noexcept
     {
+        assert(!is_frozen);
         assert(irr::valid(ID));
 
         auto index = irr::get_index(ID);
+        assert(index < static_cast<decltype(index)>(map.size()));
 
         int new_pos;
         if (free_head < 0) {
-            list.emplace_back(value, -1);
             new_pos = static_cast<int>(list.size());
+            list.emplace_back(value, -1);
         } else {
             list[free_head].id = value;
             new_pos = free_head;
             free_head = list[free_head].next;
+            --free_number;
         }
 
         list[new_pos].next = map[index];
         map[index] = new_pos;
     }
 
+    /**
+     * @brief Removes the first link from @c ID to @c value.
+     *
+     * @return false if the link does not exist.
+     */
+    bool erase(Identifier ID, Referenced value) noexcept
+    {
+        assert(!is_frozen);
+        assert(irr::valid(ID));
+
+        auto* prev = &map[irr::get_index(ID)];
+
+        for (auto elem = *prev; elem >= 0; elem = list[elem].next) {
+            if (list[elem].id == value) {
+                *prev = list[elem].next;
+                list[elem].id = { 0 };
+                list[elem].next = free_head;
+                free_head = elem;
+                ++free_number;
+
+                return true;
+            }
+
+            prev = &list[elem].next;
+        }
+
+        return false;
+    }
+
     void destroy(Identifier ID)
     {
+        assert(!is_frozen);
         assert(irr::valid(ID));
 
         auto index = irr::get_index(ID);
@@ -356,15 +843,135 @@ public:
 
         while (id >= 0) {
             auto to_delete = id;
-            index = list[id].next;
+            id = list[id].next;
 
-            list[to_delete].id = -1;
+            list[to_delete].id = { 0 };
             list[to_delete].next = free_head;
             free_head = to_delete;
+            ++free_number;
         }
     }
+
+    /**
+     * @brief Rebuilds the flat list sorted by identifier, the links of an
+     * identifier are contiguous, and frees the unused nodes.
+     */
+    void compact()
+    {
+        assert(!is_frozen);
+
+        rebuild([](const referenced_type&) { return true; });
+        list.shrink_to_fit();
+    }
+
+    /**
+     * @brief Like @c compact() but removes the links to the freed items of
+     * @c dataarray too.
+     */
+    template<typename DataArray>
+    void compact(DataArray& dataarray)
+    {
+        assert(!is_frozen);
+
+        rebuild([&dataarray](const referenced_type& id) {
+            return dataarray.try_to_get(id) != nullptr;
+        });
+        list.shrink_to_fit();
+    }
+
+    /**
+     * @brief Moves the links in compressed sparse rows: @c get_range is
+     * available and @c emplace, @c erase and @c destroy are not until
+     * @c thaw().
+     */
+    void freeze()
+    {
+        if (is_frozen)
+            return;
+
+        offsets.clear();
+        offsets.reserve(map.size() + 1);
+        offsets.emplace_back(0);
+
+        ids.clear();
+        ids.reserve(list.size() - free_number);
+
+        for (const auto head : map) {
+            for (auto elem = head; elem >= 0; elem = list[elem].next)
+                ids.emplace_back(list[elem].id);
+
+            offsets.emplace_back(static_cast<int>(ids.size()));
+        }
+
+        list.clear();
+        list.shrink_to_fit();
+        std::fill(std::begin(map), std::end(map), -1);
+        free_head = -1;
+        free_number = 0;
+        is_frozen = true;
+    }
+
+    /**
+     * @brief Moves the compressed sparse rows back in the linked lists, as
+     * after a @c compact().
+     */
+    void thaw()
+    {
+        if (!is_frozen)
+            return;
+
+        list.clear();
+        list.reserve(ids.size());
+
+        for (int row = 0, e = static_cast<int>(map.size()); row != e; ++row) {
+            const auto first = offsets[row];
+            const auto last = offsets[row + 1];
+
+            map[row] = first < last ? first : -1;
+            for (int i = first; i != last; ++i)
+                list.emplace_back(ids[i], i + 1 < last ? i + 1 : -1);
+        }
+
+        offsets.clear();
+        offsets.shrink_to_fit();
+        ids.clear();
+        ids.shrink_to_fit();
+        is_frozen = false;
+    }
 };
 
+namespace pmr {
+
+/**
+ * @brief The linkers with their memory in a @c std::pmr::memory_resource.
+ *
+ * @code
+ * irr::page_memory_resource resource;
+ * irr::pmr::linker<irr::ID, irr::ID> map(&resource);
+ * map.init(1 << 20);
+ * @endcode
+ */
+template<typename Identifier, typename Referenced>
+using linker =
+  irr::linker<Identifier,
+              Referenced,
+              std::pmr::polymorphic_allocator<Referenced>>;
+
+template<typename Identifier, typename Referenced>
+using sparse_linker =
+  irr::sparse_linker<Identifier,
+                     Referenced,
+                     std::pmr::polymorphic_allocator<Referenced>>;
+
+template<typename Identifier, typename Referenced>
+using multi_linker = irr::multi_linker<
+  Identifier,
+  Referenced,
+  std::pmr::polymorphic_allocator<int>,
+  std::pmr::polymorphic_allocator<multi_linker_node<Referenced>>>;
+
+} // namespace pmr
+
 } // namespace irr
 
 #endif // ORG_VLEPROJECT_IRRITATOR_LINKER_HPP
@@ -0,0 +1,125 @@
+// Copyright (c) 2019 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef ORG_VLEPROJECT_IRRITATOR_MEMORY_RESOURCE_HPP
+#define ORG_VLEPROJECT_IRRITATOR_MEMORY_RESOURCE_HPP
+
+#include <irritator/thread-pool.hpp>
+
+#include <atomic>
+#include <memory_resource>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace irr {
+
+/// The size of a huge page of x86-64 and aarch64 Linux.
+constexpr std::size_t huge_page_size = std::size_t(2) << 20;
+
+enum class huge_pages
+{
+    none,        // pages of the system (4 KiB)
+    transparent, // madvise(MADV_HUGEPAGE), the kernel merges the pages
+    explicit_2mb // mmap(MAP_HUGETLB), pages reserved by vm.nr_hugepages
+};
+
+enum class numa_policy
+{
+    first_touch, // a page is placed on the node of the first thread to
+                 // write it
+    bind,        // mbind(MPOL_BIND) on the nodes
+    interleave   // mbind(MPOL_INTERLEAVE) page by page over the nodes
+};
+
+/**
+ * @brief A memory resource which maps the large blocks from the kernel
+ * with huge pages and a NUMA placement.
+ * @details The blocks of at least @c threshold bytes are mapped with
+ * @c mmap, the others come from the upstream resource. A mapped block
+ * starts on a huge page boundary and its length is rounded up to the huge
+ * page size.
+ *
+ * - an explicit huge page mapping which fails (no reserved pages) falls
+ *   back to transparent huge pages, see @c fallbacks()
+ * - the @c bind and @c interleave policies are hints: a failure of
+ *   @c mbind (a kernel without NUMA) keeps the default placement
+ * - with @c first_touch and a @c thread_pool, the pages of a new block are
+ *   written by the workers of the pool: a @c parallel_for over the items
+ *   of the block gives to each worker the range it has touched. The pool
+ *   must be used by the thread which allocates only.
+ *
+ * On other systems than Linux, all the blocks come from the upstream
+ * resource.
+ *
+ * @code
+ * irr::page_memory_resource resource(irr::huge_pages::transparent);
+ * irr::data_array<model, irr::ID> models(&resource);
+ * models.init(1 << 20);
+ * @endcode
+ */
+class page_memory_resource : public std::pmr::memory_resource
+{
+public:
+    explicit page_memory_resource(
+      huge_pages pages = huge_pages::transparent,
+      numa_policy policy = numa_policy::first_touch,
+      std::uint64_t nodes = 1u,
+      thread_pool* pool = nullptr,
+      std::size_t threshold = huge_page_size,
+      std::pmr::memory_resource* upstream =
+        std::pmr::get_default_resource()) noexcept;
+
+    page_memory_resource(const page_memory_resource&) = delete;
+    page_memory_resource& operator=(const page_memory_resource&) = delete;
+
+    /// The number of bytes of the mapped blocks.
+    std::size_t mapped() const noexcept
+    {
+        return m_mapped.load(std::memory_order_relaxed);
+    }
+
+    /// The number of explicit huge page mappings replaced by transparent
+    /// huge pages.
+    int fallbacks() const noexcept
+    {
+        return m_fallbacks.load(std::memory_order_relaxed);
+    }
+
+    std::size_t threshold() const noexcept
+    {
+        return m_threshold;
+    }
+
+    std::pmr::memory_resource* upstream() const noexcept
+    {
+        return m_upstream;
+    }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+    void do_deallocate(void* p,
+                       std::size_t bytes,
+                       std::size_t alignment) override;
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const
+      noexcept override;
+
+    bool is_mapped(std::size_t bytes, std::size_t alignment) const noexcept;
+
+    std::pmr::memory_resource* m_upstream;
+    thread_pool* m_pool;
+    std::size_t m_threshold;
+    std::uint64_t m_nodes; // a bit by NUMA node.
+    huge_pages m_pages;
+    numa_policy m_policy;
+
+    std::atomic<std::size_t> m_mapped{ 0 };
+    std::atomic<int> m_fallbacks{ 0 };
+};
+
+} // namespace irr
+
+#endif // ORG_VLEPROJECT_IRRITATOR_MEMORY_RESOURCE_HPP
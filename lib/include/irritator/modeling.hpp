@@ -109,7 +109,7 @@ struct View
         memory
     };
 
-    ListID conditions;
+    UnrolledListID conditions;
     std::int8_t options = view_option::output;
     view_type type = view_type::csv_file;
     string<2 + 4> name;
@@ -129,11 +129,11 @@ struct Node
     int output_slots_number = 0;
 
     ID dynamics = 0;
-    ListID conditions;
+    UnrolledListID conditions;
     ListID observables;
 
-    ListID children;
-    ListID connections;
+    UnrolledListID children;
+    UnrolledListID connections;
 
     model_type type = model_type::atomic;
 };
@@ -167,27 +167,95 @@ struct Context
     message_type log_priority = Context::message_type::info;
 };
 
-using Conditions = data_array<Condition, ID>;
+/**
+ * @brief The split of the identifiers of the arrays of a @c Model and of
+ * the simulators: 24 bits of index (16,777,215 items) and 8 bits of key.
+ * @details The free functions (@c get_index, @c make_id...) use the
+ * default split: use @c model_index() with these identifiers.
+ */
+using model_id_split = id_split<ID, 24>;
+
+/// The index of an identifier of a @c Model array or of a simulator.
+constexpr int
+model_index(ID id) noexcept
+{
+    return model_id_split::get_index(id);
+}
+
+using Conditions = data_array<Condition, ID, model_id_split>;
 
-using Integer32s = data_array<int32_t, ID>;
-using Integer64s = data_array<int64_t, ID>;
-using Real32s = data_array<float, ID>;
-using Real64s = data_array<double, ID>;
-using Strings = data_array<std::string, ID>;
+using Integer32s = data_array<int32_t, ID, model_id_split>;
+using Integer64s = data_array<int64_t, ID, model_id_split>;
+using Real32s = data_array<float, ID, model_id_split>;
+using Real64s = data_array<double, ID, model_id_split>;
+using Strings = data_array<std::string, ID, model_id_split>;
 
-using Nodes = data_array<Node, ID>;
-using Connections = data_array<Connection, ID>;
-using Slots = data_array<Slot, ID>;
-using Views = data_array<View, ID>;
-using Dynamics = data_array<Dynamic, ID>;
-using Classes = data_array<Class, ID>;
+using Nodes = data_array<Node, ID, model_id_split, separated_ids>;
+using Connections = data_array<Connection, ID, model_id_split>;
+using Slots = data_array<Slot, ID, model_id_split>;
+using Views = data_array<View, ID, model_id_split>;
+using Dynamics = data_array<Dynamic, ID, model_id_split>;
+using Classes = data_array<Class, ID, model_id_split>;
 
 enum class status
 {
     json_read_success,
     json_open_error,
     json_parse_error,
-    json_stack_not_empty_error
+    json_stack_not_empty_error,
+    simulation_flat_success,
+    simulation_flat_not_enough_memory,
+    simulation_flat_bad_connection,
+    snapshot_read_success,
+    snapshot_write_success,
+    snapshot_open_error,
+    snapshot_bad_format,
+    snapshot_bad_version,
+    snapshot_read_error,
+    snapshot_write_error,
+    snapshot_model_frozen
+};
+
+/**
+ * @brief The identifiers of the arrays of a @c Model before and after a
+ * @c Model::compact().
+ */
+struct ModelRemap
+{
+    id_remap<ID, model_id_split> conditions;
+    id_remap<ID, model_id_split> connections;
+    id_remap<ID, model_id_split> slots;
+    id_remap<ID, model_id_split> views;
+    id_remap<ID, model_id_split> nodes;
+    id_remap<ID, model_id_split> classes;
+
+    id_remap<ID, model_id_split> integer32s;
+    id_remap<ID, model_id_split> integer64s;
+    id_remap<ID, model_id_split> real32s;
+    id_remap<ID, model_id_split> real64s;
+    id_remap<ID, model_id_split> strings;
+};
+
+/**
+ * @brief The lists of the nodes and the views of a frozen @c Model, a row
+ * by index of node or view.
+ */
+struct FrozenLists
+{
+    id_csr<ID> node_conditions;
+    id_csr<ID> node_observables;
+    id_csr<ID> node_children;
+    id_csr<ID> node_connections;
+    id_csr<ID> view_conditions;
+
+    void clear() noexcept
+    {
+        node_conditions.clear();
+        node_observables.clear();
+        node_children.clear();
+        node_connections.clear();
+        view_conditions.clear();
+    }
 };
 
 struct Model
@@ -196,6 +264,90 @@ struct Model
 
     status read(Context& context, const std::filesystem::path& file_name);
 
+    /**
+     * @brief Writes the arrays of the Model in a binary snapshot.
+     * @details The snapshot stores the memory of each array as is: a
+     * header, a table of sections then one section by array aligned on 64
+     * bytes. Reading a snapshot is a read of each section straight into
+     * the memory of the arrays, without parsing. A snapshot is read by
+     * the same version of the library on the same architecture only.
+     *
+     * @return @c status::snapshot_model_frozen for a frozen Model, thaw()
+     * it first.
+     */
+    status write_snapshot(const std::filesystem::path& file_name) const;
+
+    /**
+     * @brief Replaces the arrays of the Model with the arrays of a
+     * snapshot written by @c write_snapshot().
+     * @details A bad header leaves the Model unchanged. A failure in a
+     * section empties the Model, its arrays keep their capacity.
+     */
+    status read_snapshot(const std::filesystem::path& file_name);
+
+    /**
+     * @brief Compacts the arrays of the Model after many free and
+     * rewrites the identifiers stored in the Model: parents, children,
+     * connections, conditions, observables, classes and values of the
+     * conditions.
+     *
+     * @return The remaps to rewrite the identifiers stored outside of the
+     * Model (for example in a @c linker). A frozen Model is thawed then
+     * frozen again.
+     */
+    ModelRemap compact();
+
+    /**
+     * @brief Moves the lists of the nodes and the views into compressed
+     * sparse rows: the passes which only read the Model (flattening,
+     * validation, routing) scan contiguous arrays of identifiers.
+     * @details The lists of a frozen Model are empty, use the @c *_of
+     * accessors. The nodes, the views and their lists must not change
+     * until thaw().
+     */
+    void freeze();
+
+    /**
+     * @brief Moves the compressed sparse rows back into the lists of the
+     * nodes and the views before an edition of the Model.
+     */
+    void thaw();
+
+    bool frozen() const noexcept
+    {
+        return is_frozen;
+    }
+
+    /// The conditions of the node of a frozen Model.
+    span<const ID> conditions_of(const Node& node) const noexcept
+    {
+        return frozen_lists.node_conditions[model_index(nodes.id_of(node))];
+    }
+
+    /// The observables of the node of a frozen Model.
+    span<const ID> observables_of(const Node& node) const noexcept
+    {
+        return frozen_lists.node_observables[model_index(nodes.id_of(node))];
+    }
+
+    /// The children of the node of a frozen Model.
+    span<const ID> children_of(const Node& node) const noexcept
+    {
+        return frozen_lists.node_children[model_index(nodes.id_of(node))];
+    }
+
+    /// The connections of the node of a frozen Model.
+    span<const ID> connections_of(const Node& node) const noexcept
+    {
+        return frozen_lists.node_connections[model_index(nodes.id_of(node))];
+    }
+
+    /// The conditions of the view of a frozen Model.
+    span<const ID> conditions_of(const View& view) const noexcept
+    {
+        return frozen_lists.view_conditions[model_index(views.id_of(view))];
+    }
+
     string<32> name;
     string<32> author;
     int version_major;
@@ -211,12 +363,16 @@ struct Model
 
     data_list<ID> links;
     data_list<WID> wlinks;
+    chunk_list<ID> chunks; // the chunks of the UnrolledListID.
 
     Integer32s integer32s;
     Integer64s integer64s;
     Real32s real32s;
     Real64s real64s;
     Strings strings;
+
+    FrozenLists frozen_lists;
+    bool is_frozen = false;
 };
 
 struct VLE
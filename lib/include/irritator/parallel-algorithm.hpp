@@ -0,0 +1,171 @@
+// Copyright (c) 2019 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef ORG_VLEPROJECT_IRRITATOR_PARALLEL_ALGORITHM_HPP
+#define ORG_VLEPROJECT_IRRITATOR_PARALLEL_ALGORITHM_HPP
+
+#include <irritator/data-array.hpp>
+#include <irritator/thread-pool.hpp>
+
+#include <utility>
+#include <vector>
+
+namespace irr {
+
+/**
+ * @brief The default number of entries of a chunk of the parallel
+ * algorithms.
+ * @details The range [0, max_used[ of a @c data_array is cut into chunks
+ * of @c grain entries, the chunks are run on the workers of a
+ * @c thread_pool. The results of the chunks are combined in the order of
+ * the chunks: for a given grain, the results do not depend on the number
+ * of workers nor on the scheduling.
+ */
+constexpr int parallel_grain = 1024;
+
+namespace details {
+
+inline int
+chunk_number(int length, int grain) noexcept
+{
+    return (length + grain - 1) / grain;
+}
+
+// Calls @c fct(index) for each item of [first, last[ in index order.
+template<typename DataArray, typename Function>
+void
+for_each_index(const DataArray& array, int first, int last, Function&& fct)
+{
+    for (int i = array.next_index(first, last); i < last;
+         i = array.next_index(i + 1, last))
+        fct(i);
+}
+
+} // namespace details
+
+/**
+ * @brief Calls @c fct(item) for each item of the @c data_array. The
+ * function must not alloc or free items of the array.
+ */
+template<typename DataArray, typename Function>
+void
+parallel_for_each(thread_pool& pool,
+                  DataArray& array,
+                  Function&& fct,
+                  int grain = parallel_grain)
+{
+    const auto last = array.max_used;
+
+    pool.parallel_for_range(0, last, grain, [&](int begin, int end) {
+        details::for_each_index(
+          array, begin, end, [&](int i) { fct(array.value(i)); });
+    });
+}
+
+/**
+ * @brief Returns the reduction with @c reduce of @c init and of
+ * @c transform(item) for each item of the @c data_array.
+ * @details Each chunk reduces its items in index order, then the results
+ * of the chunks are reduced in chunk order with @c init as first value:
+ * with a non associative @c reduce (a sum of floating point values), the
+ * result is the same whatever the number of workers.
+ */
+template<typename DataArray,
+         typename Value,
+         typename Reduce,
+         typename Transform>
+Value
+parallel_transform_reduce(thread_pool& pool,
+                          DataArray& array,
+                          Value init,
+                          Reduce&& reduce,
+                          Transform&& transform,
+                          int grain = parallel_grain)
+{
+    const auto last = array.max_used;
+    const auto chunks = details::chunk_number(last, grain);
+
+    // A struct by chunk: a std::vector<bool> of the results would pack the
+    // chunks in the bits of a same word written by several workers.
+    struct partial
+    {
+        Value value;
+        bool used;
+    };
+
+    std::vector<partial> partials(chunks, partial{ init, false });
+
+    pool.parallel_for(0, chunks, [&](int chunk) {
+        const auto begin = chunk * grain;
+        const auto end = begin + grain < last ? begin + grain : last;
+        auto& result = partials[chunk];
+
+        details::for_each_index(array, begin, end, [&](int i) {
+            if (result.used) {
+                result.value =
+                  reduce(std::move(result.value), transform(array.value(i)));
+            } else {
+                result.value = transform(array.value(i));
+                result.used = true;
+            }
+        });
+    });
+
+    for (auto& result : partials)
+        if (result.used)
+            init = reduce(std::move(init), std::move(result.value));
+
+    return init;
+}
+
+/**
+ * @brief Copies the items of the @c data_array which satisfy @c pred at the
+ * end of @c out_true and the others at the end of @c out_false, in index
+ * order.
+ *
+ * @return The number of items copied in @c out_true.
+ */
+template<typename DataArray, typename Output, typename Predicate>
+int
+parallel_partition_copy(thread_pool& pool,
+                        DataArray& array,
+                        Output& out_true,
+                        Output& out_false,
+                        Predicate&& pred,
+                        int grain = parallel_grain)
+{
+    const auto last = array.max_used;
+    const auto chunks = details::chunk_number(last, grain);
+
+    std::vector<Output> trues(chunks);
+    std::vector<Output> falses(chunks);
+
+    pool.parallel_for(0, chunks, [&](int chunk) {
+        const auto begin = chunk * grain;
+        const auto end = begin + grain < last ? begin + grain : last;
+
+        details::for_each_index(array, begin, end, [&](int i) {
+            const auto& item = array.value(i);
+            if (pred(item))
+                trues[chunk].push_back(item);
+            else
+                falses[chunk].push_back(item);
+        });
+    });
+
+    int number = 0;
+    for (int chunk = 0; chunk != chunks; ++chunk) {
+        number += static_cast<int>(trues[chunk].size());
+        out_true.insert(
+          out_true.end(), trues[chunk].begin(), trues[chunk].end());
+        out_false.insert(
+          out_false.end(), falses[chunk].begin(), falses[chunk].end());
+    }
+
+    return number;
+}
+
+} // namespace irr
+
+#endif // ORG_VLEPROJECT_IRRITATOR_PARALLEL_ALGORITHM_HPP
@@ -0,0 +1,837 @@
+// Copyright (c) 2019 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef ORG_VLEPROJECT_IRRITATOR_SCHEDULER_HPP
+#define ORG_VLEPROJECT_IRRITATOR_SCHEDULER_HPP
+
+#include <irritator/data-array.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+namespace irr {
+
+/**
+ * @brief An indexed d-ary min-heap of identifiers ordered by time.
+ * @details The heap stores at most one entry per identifier. A position
+ * table indexed by @c Split::get_index(id) gives the place of an
+ * identifier in the heap so that update and erase work in place without
+ * any search.
+ * - O(log n) insert, erase and update
+ * - O(1) access to the minimum
+ *
+ * @code
+ * irr::heap<float> h;
+ * h.init(simulators.capacity);
+ * h.insert(simulators.get_id(sim), sim.tn);
+ * ...
+ * std::vector<irr::ID> imminent;
+ * h.pop(imminent); // all identifiers with tn == h.tn().
+ * @endcode
+ *
+ * @tparam Time The type of the time.
+ * @tparam Identifier The type of the identifier (@c ID or @c WID).
+ * @tparam Split The split of the identifiers of the indexed array.
+ * @tparam Arity The number of children per node in the heap.
+ */
+template<typename Time,
+         typename Identifier = ID,
+         typename Split = default_id_split<Identifier>,
+         int Arity = 4>
+class heap
+{
+    static_assert(Arity >= 2, "heap needs at least two children per node");
+
+public:
+    using time_type = Time;
+    using identifier_type = Identifier;
+
+private:
+    struct node
+    {
+        time_type tn;
+        identifier_type id;
+    };
+
+    std::vector<node> m_nodes;    // The d-ary heap.
+    std::vector<int> m_positions; // Heap position of each ID index or -1.
+
+public:
+    heap() = default;
+
+    /**
+     * @brief Reserve memory for identifiers with index in [0, capacity[.
+     *
+     * @return false if capacity is negative.
+     */
+    bool init(int capacity)
+    {
+        if (capacity < 0)
+            return false;
+
+        m_nodes.clear();
+        m_nodes.reserve(capacity);
+        m_positions.assign(capacity, -1);
+
+        return true;
+    }
+
+    void clear() noexcept
+    {
+        for (const auto& elem : m_nodes)
+            m_positions[Split::get_index(elem.id)] = -1;
+
+        m_nodes.clear();
+    }
+
+    void insert(identifier_type id, time_type tn) noexcept
+    {
+        const auto index = Split::get_index(id);
+        assert(index >= 0 && index < static_cast<int>(m_positions.size()));
+        assert(m_positions[index] == -1);
+
+        const auto position = static_cast<int>(m_nodes.size());
+        m_nodes.push_back(node{ tn, id });
+        m_positions[index] = position;
+
+        sift_up(position);
+    }
+
+    /**
+     * @brief Move an already inserted identifier to its new time.
+     */
+    void update(identifier_type id, time_type tn) noexcept
+    {
+        const auto position = m_positions[Split::get_index(id)];
+        assert(position >= 0);
+        assert(m_nodes[position].id == id);
+
+        const auto old = m_nodes[position].tn;
+        m_nodes[position].tn = tn;
+
+        if (tn < old)
+            sift_up(position);
+        else if (old < tn)
+            sift_down(position);
+    }
+
+    /**
+     * @brief Insert the identifier if not already in the heap, update its
+     * time otherwise.
+     */
+    void insert_or_update(identifier_type id, time_type tn) noexcept
+    {
+        if (is_in_tree(id))
+            update(id, tn);
+        else
+            insert(id, tn);
+    }
+
+    void erase(identifier_type id) noexcept
+    {
+        const auto position = m_positions[Split::get_index(id)];
+        assert(position >= 0);
+        assert(m_nodes[position].id == id);
+
+        remove(position);
+    }
+
+    bool is_in_tree(identifier_type id) const noexcept
+    {
+        const auto index = Split::get_index(id);
+
+        return index >= 0 && index < static_cast<int>(m_positions.size()) &&
+               m_positions[index] >= 0 &&
+               m_nodes[m_positions[index]].id == id;
+    }
+
+    time_type tn(identifier_type id) const noexcept
+    {
+        assert(is_in_tree(id));
+
+        return m_nodes[m_positions[Split::get_index(id)]].tn;
+    }
+
+    /**
+     * @brief Time of the minimum or infinity if the heap is empty.
+     */
+    time_type tn() const noexcept
+    {
+        return m_nodes.empty() ? std::numeric_limits<time_type>::infinity()
+                               : m_nodes.front().tn;
+    }
+
+    identifier_type top() const noexcept
+    {
+        assert(!m_nodes.empty());
+
+        return m_nodes.front().id;
+    }
+
+    identifier_type pop() noexcept
+    {
+        assert(!m_nodes.empty());
+
+        const auto id = m_nodes.front().id;
+        remove(0);
+
+        return id;
+    }
+
+    /**
+     * @brief Remove all identifiers with the minimum time and append them
+     * into the container.
+     */
+    template<typename Container>
+    void pop(Container& imminent)
+    {
+        if (m_nodes.empty())
+            return;
+
+        const auto t = m_nodes.front().tn;
+
+        do {
+            imminent.push_back(pop());
+        } while (!m_nodes.empty() && m_nodes.front().tn == t);
+    }
+
+    int size() const noexcept
+    {
+        return static_cast<int>(m_nodes.size());
+    }
+
+    bool empty() const noexcept
+    {
+        return m_nodes.empty();
+    }
+
+private:
+    void remove(int position) noexcept
+    {
+        m_positions[Split::get_index(m_nodes[position].id)] = -1;
+
+        const auto last = static_cast<int>(m_nodes.size()) - 1;
+        if (position != last) {
+            const auto old = m_nodes[position].tn;
+            m_nodes[position] = m_nodes[last];
+            m_positions[Split::get_index(m_nodes[position].id)] = position;
+            m_nodes.pop_back();
+
+            if (m_nodes[position].tn < old)
+                sift_up(position);
+            else
+                sift_down(position);
+        } else {
+            m_nodes.pop_back();
+        }
+    }
+
+    void sift_up(int position) noexcept
+    {
+        const auto moving = m_nodes[position];
+
+        while (position > 0) {
+            const auto parent = (position - 1) / Arity;
+            if (!(moving.tn < m_nodes[parent].tn))
+                break;
+
+            m_nodes[position] = m_nodes[parent];
+            m_positions[Split::get_index(m_nodes[position].id)] = position;
+            position = parent;
+        }
+
+        m_nodes[position] = moving;
+        m_positions[Split::get_index(moving.id)] = position;
+    }
+
+    void sift_down(int position) noexcept
+    {
+        const auto moving = m_nodes[position];
+        const auto size = static_cast<int>(m_nodes.size());
+
+        for (;;) {
+            const auto first = position * Arity + 1;
+            if (first >= size)
+                break;
+
+            const auto last = first + Arity < size ? first + Arity : size;
+            auto child = first;
+            for (auto i = first + 1; i < last; ++i)
+                if (m_nodes[i].tn < m_nodes[child].tn)
+                    child = i;
+
+            if (!(m_nodes[child].tn < moving.tn))
+                break;
+
+            m_nodes[position] = m_nodes[child];
+            m_positions[Split::get_index(m_nodes[position].id)] = position;
+            position = child;
+        }
+
+        m_nodes[position] = moving;
+        m_positions[Split::get_index(moving.id)] = position;
+    }
+};
+
+/**
+ * @brief A calendar queue of identifiers ordered by time.
+ * @details Identifiers are hashed into an array of buckets (the days of a
+ * year) by their time. Each bucket is a sorted list and the search for the
+ * minimum walks the days of the current year. The number of buckets follows
+ * the number of finite entries and the width of a day is estimated from the
+ * observed distribution of times at each resize. Entries with an infinite
+ * time are stored aside in an unsorted list.
+ * - O(1) amortized insert, erase, update and pop when the times are spread
+ * - same API as @c irr::heap
+ *
+ * @tparam Time The type of the time.
+ * @tparam Identifier The type of the identifier (@c ID or @c WID).
+ * @tparam Split The split of the identifiers of the indexed array.
+ */
+template<typename Time,
+         typename Identifier = ID,
+         typename Split = default_id_split<Identifier>>
+class calendar
+{
+public:
+    using time_type = Time;
+    using identifier_type = Identifier;
+
+private:
+    static constexpr int not_in_queue = -1;
+    static constexpr int infinity_bucket = -2;
+    static constexpr int minimum_buckets = 2;
+    static constexpr int sample_size = 256;
+
+    struct entry
+    {
+        time_type tn;
+        identifier_type id;
+        int previous = -1;
+        int next = -1;
+        int bucket = not_in_queue;
+    };
+
+    std::vector<entry> m_entries; // Indexed by Split::get_index(id).
+    std::vector<int> m_buckets;   // Head of the sorted list of each day.
+    std::vector<time_type> m_sample;
+
+    double m_width = 1.0;      // Length of a day.
+    int m_mask = 0;            // Number of buckets - 1.
+    int m_size = 0;            // Number of finite entries.
+    int m_infinity_head = -1;  // Unsorted list of infinite entries.
+    int m_infinity_size = 0;   // Number of infinite entries.
+    bool m_resize = true;      // Disable resize while resizing.
+
+    mutable std::int64_t m_day = 0; // Lower bound of the day of every entry.
+    mutable int m_min = -1;         // Cached index of the minimum or -1.
+
+public:
+    calendar() = default;
+
+    /**
+     * @brief Reserve memory for identifiers with index in [0, capacity[.
+     *
+     * @return false if capacity is negative.
+     */
+    bool init(int capacity)
+    {
+        if (capacity < 0)
+            return false;
+
+        m_entries.assign(capacity, entry{});
+        m_buckets.assign(minimum_buckets, -1);
+        m_sample.reserve(sample_size);
+        m_width = 1.0;
+        m_mask = minimum_buckets - 1;
+        m_size = 0;
+        m_infinity_head = -1;
+        m_infinity_size = 0;
+        m_day = 0;
+        m_min = -1;
+
+        return true;
+    }
+
+    void clear() noexcept
+    {
+        for (auto& elem : m_entries)
+            elem.bucket = not_in_queue;
+
+        std::fill(std::begin(m_buckets), std::end(m_buckets), -1);
+        m_size = 0;
+        m_infinity_head = -1;
+        m_infinity_size = 0;
+        m_day = 0;
+        m_min = -1;
+    }
+
+    void insert(identifier_type id, time_type tn) noexcept
+    {
+        const auto index = Split::get_index(id);
+        assert(index >= 0 && index < static_cast<int>(m_entries.size()));
+        assert(m_entries[index].bucket == not_in_queue);
+
+        m_entries[index].id = id;
+        m_entries[index].tn = tn;
+        link(index);
+
+        if (m_resize && m_size > 2 * (m_mask + 1))
+            resize((m_mask + 1) * 2);
+    }
+
+    /**
+     * @brief Move an already inserted identifier to its new time.
+     */
+    void update(identifier_type id, time_type tn) noexcept
+    {
+        const auto index = Split::get_index(id);
+        assert(is_in_tree(id));
+
+        unlink(index);
+        m_entries[index].tn = tn;
+        link(index);
+    }
+
+    /**
+     * @brief Insert the identifier if not already in the calendar, update
+     * its time otherwise.
+     */
+    void insert_or_update(identifier_type id, time_type tn) noexcept
+    {
+        if (is_in_tree(id))
+            update(id, tn);
+        else
+            insert(id, tn);
+    }
+
+    void erase(identifier_type id) noexcept
+    {
+        assert(is_in_tree(id));
+
+        remove(Split::get_index(id));
+    }
+
+    bool is_in_tree(identifier_type id) const noexcept
+    {
+        const auto index = Split::get_index(id);
+
+        return index >= 0 && index < static_cast<int>(m_entries.size()) &&
+               m_entries[index].bucket != not_in_queue &&
+               m_entries[index].id == id;
+    }
+
+    time_type tn(identifier_type id) const noexcept
+    {
+        assert(is_in_tree(id));
+
+        return m_entries[Split::get_index(id)].tn;
+    }
+
+    /**
+     * @brief Time of the minimum or infinity if the calendar is empty.
+     */
+    time_type tn() const noexcept
+    {
+        const auto min = find_min();
+
+        return min < 0 ? std::numeric_limits<time_type>::infinity()
+                       : m_entries[min].tn;
+    }
+
+    identifier_type top() const noexcept
+    {
+        const auto min = find_min();
+        assert(min >= 0);
+
+        return m_entries[min].id;
+    }
+
+    identifier_type pop() noexcept
+    {
+        const auto min = find_min();
+        assert(min >= 0);
+
+        const auto id = m_entries[min].id;
+        remove(min);
+
+        return id;
+    }
+
+    /**
+     * @brief Remove all identifiers with the minimum time and append them
+     * into the container.
+     */
+    template<typename Container>
+    void pop(Container& imminent)
+    {
+        if (empty())
+            return;
+
+        const auto t = tn();
+
+        do {
+            imminent.push_back(pop());
+        } while (!empty() && tn() == t);
+    }
+
+    int size() const noexcept
+    {
+        return m_size + m_infinity_size;
+    }
+
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    int buckets() const noexcept
+    {
+        return m_mask + 1;
+    }
+
+    double width() const noexcept
+    {
+        return m_width;
+    }
+
+private:
+    static bool is_infinity(time_type t) noexcept
+    {
+        return t == std::numeric_limits<time_type>::infinity();
+    }
+
+    std::int64_t day(time_type t) const noexcept
+    {
+        return static_cast<std::int64_t>(
+          std::floor(static_cast<double>(t) / m_width));
+    }
+
+    void remove(int index) noexcept
+    {
+        unlink(index);
+        m_entries[index].bucket = not_in_queue;
+
+        if (m_resize && m_mask + 1 > minimum_buckets &&
+            m_size < (m_mask + 1) / 2)
+            resize((m_mask + 1) / 2);
+    }
+
+    void link(int index) noexcept
+    {
+        auto& elem = m_entries[index];
+
+        if (is_infinity(elem.tn)) {
+            elem.bucket = infinity_bucket;
+            elem.previous = -1;
+            elem.next = m_infinity_head;
+            if (m_infinity_head >= 0)
+                m_entries[m_infinity_head].previous = index;
+            m_infinity_head = index;
+            ++m_infinity_size;
+            return;
+        }
+
+        const auto d = day(elem.tn);
+        if (m_size == 0 || d < m_day)
+            m_day = d;
+
+        elem.bucket = static_cast<int>(d & m_mask);
+
+        // Insert after the last element with a time lower or equal to keep
+        // the FIFO order of equal times.
+        int previous = -1;
+        int next = m_buckets[elem.bucket];
+        while (next >= 0 && !(elem.tn < m_entries[next].tn)) {
+            previous = next;
+            next = m_entries[next].next;
+        }
+
+        elem.previous = previous;
+        elem.next = next;
+
+        if (previous >= 0)
+            m_entries[previous].next = index;
+        else
+            m_buckets[elem.bucket] = index;
+
+        if (next >= 0)
+            m_entries[next].previous = index;
+
+        ++m_size;
+
+        if (m_min >= 0 && elem.tn < m_entries[m_min].tn)
+            m_min = index;
+    }
+
+    void unlink(int index) noexcept
+    {
+        auto& elem = m_entries[index];
+        assert(elem.bucket != not_in_queue);
+
+        if (elem.previous >= 0)
+            m_entries[elem.previous].next = elem.next;
+        else if (elem.bucket == infinity_bucket)
+            m_infinity_head = elem.next;
+        else
+            m_buckets[elem.bucket] = elem.next;
+
+        if (elem.next >= 0)
+            m_entries[elem.next].previous = elem.previous;
+
+        if (elem.bucket == infinity_bucket)
+            --m_infinity_size;
+        else
+            --m_size;
+
+        elem.previous = -1;
+        elem.next = -1;
+
+        if (m_min == index)
+            m_min = -1;
+    }
+
+    int find_min() const noexcept
+    {
+        if (m_min >= 0)
+            return m_min;
+
+        if (m_size == 0)
+            return m_min = m_infinity_head;
+
+        // Walk the days of the current year. The head of each bucket is
+        // the minimum of its bucket, it is the global minimum if it belongs
+        // to the current day.
+        const auto buckets = m_mask + 1;
+        for (int i = 0; i != buckets; ++i, ++m_day) {
+            const auto head = m_buckets[static_cast<int>(m_day & m_mask)];
+            if (head >= 0 && day(m_entries[head].tn) == m_day)
+                return m_min = head;
+        }
+
+        // No event in a whole year: direct search of the minimum.
+        int min = -1;
+        for (auto head : m_buckets)
+            if (head >= 0 &&
+                (min < 0 || m_entries[head].tn < m_entries[min].tn))
+                min = head;
+
+        m_day = day(m_entries[min].tn);
+        return m_min = min;
+    }
+
+    /**
+     * @brief Estimate the width of a day from the times of at most
+     * sample_size finite entries: three times the mean separation between
+     * consecutive events, ignoring the separations larger than twice the
+     * mean.
+     */
+    void estimate_width()
+    {
+        m_sample.clear();
+
+        const int stride = m_size / sample_size + 1;
+        int seen = 0;
+        for (const auto& elem : m_entries) {
+            if (elem.bucket < 0)
+                continue;
+
+            if (seen++ % stride == 0)
+                m_sample.push_back(elem.tn);
+        }
+
+        if (m_sample.size() < 2)
+            return;
+
+        std::sort(std::begin(m_sample), std::end(m_sample));
+
+        const auto count = static_cast<int>(m_sample.size());
+        double sum = 0.0;
+        for (int i = 1; i != count; ++i)
+            sum += static_cast<double>(m_sample[i] - m_sample[i - 1]);
+
+        const double mean = sum / (count - 1);
+        double filtered = 0.0;
+        int filtered_count = 0;
+        for (int i = 1; i != count; ++i) {
+            const auto sep =
+              static_cast<double>(m_sample[i] - m_sample[i - 1]);
+            if (sep <= 2.0 * mean) {
+                filtered += sep;
+                ++filtered_count;
+            }
+        }
+
+        if (filtered <= 0.0)
+            return;
+
+        // The sample keeps one entry every stride entries: scale the
+        // separation to the whole population.
+        const double separation =
+          (filtered / filtered_count) * count / static_cast<double>(m_size);
+
+        if (separation > 0.0 && std::isfinite(separation))
+            m_width = 3.0 * separation;
+    }
+
+    void resize(int new_buckets)
+    {
+        m_resize = false;
+
+        estimate_width();
+
+        std::fill(std::begin(m_buckets), std::end(m_buckets), -1);
+        m_buckets.resize(new_buckets, -1);
+        m_mask = new_buckets - 1;
+        m_size = 0;
+        m_min = -1;
+
+        const auto capacity = static_cast<int>(m_entries.size());
+        for (int i = 0; i != capacity; ++i) {
+            if (m_entries[i].bucket >= 0) {
+                m_entries[i].bucket = not_in_queue;
+                link(i);
+            }
+        }
+
+        m_resize = true;
+    }
+};
+
+enum class scheduler_type : std::int8_t
+{
+    heap,
+    calendar
+};
+
+#ifdef IRRITATOR_CALENDAR_SCHEDULER
+constexpr scheduler_type default_scheduler_type = scheduler_type::calendar;
+#else
+constexpr scheduler_type default_scheduler_type = scheduler_type::heap;
+#endif
+
+/**
+ * @brief The scheduler of simulators selects at run time between the heap
+ * and the calendar queue backends.
+ * @details The default backend is the heap or the calendar queue if the
+ * library is built with the @c WITH_CALENDAR_SCHEDULER option.
+ */
+template<typename Time,
+         typename Identifier = ID,
+         typename Split = default_id_split<Identifier>>
+class scheduler
+{
+public:
+    using time_type = Time;
+    using identifier_type = Identifier;
+
+private:
+    heap<time_type, identifier_type, Split> m_heap;
+    calendar<time_type, identifier_type, Split> m_calendar;
+    scheduler_type m_type = default_scheduler_type;
+
+    template<typename Function>
+    auto visit(Function&& fct)
+    {
+        return m_type == scheduler_type::heap ? fct(m_heap) : fct(m_calendar);
+    }
+
+    template<typename Function>
+    auto visit(Function&& fct) const
+    {
+        return m_type == scheduler_type::heap ? fct(m_heap) : fct(m_calendar);
+    }
+
+public:
+    scheduler() = default;
+
+    bool init(int capacity, scheduler_type type = default_scheduler_type)
+    {
+        m_type = type;
+        m_heap = heap<time_type, identifier_type, Split>();
+        m_calendar = calendar<time_type, identifier_type, Split>();
+
+        return visit([capacity](auto& s) { return s.init(capacity); });
+    }
+
+    scheduler_type type() const noexcept
+    {
+        return m_type;
+    }
+
+    void clear() noexcept
+    {
+        visit([](auto& s) { s.clear(); });
+    }
+
+    void insert(identifier_type id, time_type tn) noexcept
+    {
+        visit([id, tn](auto& s) { s.insert(id, tn); });
+    }
+
+    void update(identifier_type id, time_type tn) noexcept
+    {
+        visit([id, tn](auto& s) { s.update(id, tn); });
+    }
+
+    void insert_or_update(identifier_type id, time_type tn) noexcept
+    {
+        visit([id, tn](auto& s) { s.insert_or_update(id, tn); });
+    }
+
+    void erase(identifier_type id) noexcept
+    {
+        visit([id](auto& s) { s.erase(id); });
+    }
+
+    bool is_in_tree(identifier_type id) const noexcept
+    {
+        return visit([id](const auto& s) { return s.is_in_tree(id); });
+    }
+
+    time_type tn(identifier_type id) const noexcept
+    {
+        return visit([id](const auto& s) { return s.tn(id); });
+    }
+
+    time_type tn() const noexcept
+    {
+        return visit([](const auto& s) { return s.tn(); });
+    }
+
+    identifier_type top() const noexcept
+    {
+        return visit([](const auto& s) { return s.top(); });
+    }
+
+    identifier_type pop() noexcept
+    {
+        return visit([](auto& s) { return s.pop(); });
+    }
+
+    template<typename Container>
+    void pop(Container& imminent)
+    {
+        visit([&imminent](auto& s) { s.pop(imminent); });
+    }
+
+    int size() const noexcept
+    {
+        return visit([](const auto& s) { return s.size(); });
+    }
+
+    bool empty() const noexcept
+    {
+        return visit([](const auto& s) { return s.empty(); });
+    }
+};
+
+} // namespace irr
+
+#endif // ORG_VLEPROJECT_IRRITATOR_SCHEDULER_HPP
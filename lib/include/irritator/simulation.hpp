@@ -7,7 +7,19 @@
 
 #include <irritator/data-array.hpp>
 #include <irritator/export.hpp>
+#include <irritator/modeling.hpp>
+#include <irritator/scheduler.hpp>
 #include <irritator/string.hpp>
+#include <irritator/thread-pool.hpp>
+#include <irritator/time.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include <cmath>
+#include <cstring>
 
 namespace irr {
 
@@ -181,6 +193,11 @@ struct Value
     value_type type = value_type::none;
 };
 
+/**
+ * @brief The values of the messages of a bag, a column by type.
+ * @details The columns are emptied by clear() at each bag and doubled when
+ * a bag emits more values than the capacity given to init().
+ */
 struct Values
 {
     array<int32_t> integer32;
@@ -197,6 +214,18 @@ struct Values
     int next_vec2_32 = 0;
     int next_vec3_32 = 0;
 
+    Values() noexcept = default;
+
+    /// The columns are allocated in @c resource by init().
+    explicit Values(std::pmr::memory_resource* resource) noexcept
+      : integer32(resource)
+      , integer64(resource)
+      , real32(resource)
+      , real64(resource)
+      , vec2_32(resource)
+      , vec3_32(resource)
+    {}
+
     Values(int capacity)
       : integer32(capacity)
       , integer64(capacity)
@@ -208,10 +237,21 @@ struct Values
         assert(capacity > 0);
     }
 
+    bool init(int capacity)
+    {
+        if (capacity <= 0)
+            return false;
+
+        clear();
+
+        return integer32.init(capacity) && integer64.init(capacity) &&
+               real32.init(capacity) && real64.init(capacity) &&
+               vec2_32.init(capacity) && vec3_32.init(capacity);
+    }
+
     Value alloc_integer32(int32_t value) noexcept
     {
-        const auto next = next_integer32++;
-        assert(next < INT32_MAX);
+        const auto next = reserve(integer32, next_integer32, 1);
 
         integer32[next] = value;
         return Value{ next, 1, Value::value_type::integer32 };
@@ -219,8 +259,7 @@ struct Values
 
     Value alloc_integer64(int64_t value) noexcept
     {
-        const auto next = next_integer64++;
-        assert(next < INT32_MAX);
+        const auto next = reserve(integer64, next_integer64, 1);
 
         integer64[next] = value;
         return Value{ next, 1, Value::value_type::integer64 };
@@ -228,8 +267,7 @@ struct Values
 
     Value alloc_real32(float value) noexcept
     {
-        const auto next = next_real32++;
-        assert(next < INT32_MAX);
+        const auto next = reserve(real32, next_real32, 1);
 
         real32[next] = value;
         return Value{ next, 1, Value::value_type::real32 };
@@ -237,8 +275,7 @@ struct Values
 
     Value alloc_real64(double value) noexcept
     {
-        const auto next = next_real64++;
-        assert(next < INT32_MAX);
+        const auto next = reserve(real64, next_real64, 1);
 
         real64[next] = value;
         return Value{ next, 1, Value::value_type::real64 };
@@ -246,8 +283,7 @@ struct Values
 
     Value alloc_vec2_32(vec2 value) noexcept
     {
-        const auto next = next_vec2_32++;
-        assert(next < INT32_MAX);
+        const auto next = reserve(vec2_32, next_vec2_32, 1);
 
         vec2_32[next] = value;
         return Value{ next, 1, Value::value_type::vec2_32 };
@@ -255,8 +291,7 @@ struct Values
 
     Value alloc_vec3_32(vec3 value) noexcept
     {
-        const auto next = next_vec3_32++;
-        assert(next < INT32_MAX);
+        const auto next = reserve(vec3_32, next_vec3_32, 1);
 
         vec3_32[next] = value;
         return Value{ next, 1, Value::value_type::vec3_32 };
@@ -264,66 +299,48 @@ struct Values
 
     Value alloc_integer32(int32_t value, int16_t length) noexcept
     {
-        const auto next = next_integer32;
-        assert(length > 0);
-        assert(INT32_MAX - next > length);
+        const auto next = reserve(integer32, next_integer32, length);
 
-        next_integer32 += length;
         integer32[next] = value;
         return Value{ next, length, Value::value_type::integer32 };
     }
 
     Value alloc_integer64(int64_t value, int16_t length) noexcept
     {
-        const auto next = next_integer64;
-        assert(length > 0);
-        assert(INT32_MAX - next > length);
+        const auto next = reserve(integer64, next_integer64, length);
 
-        next_integer64 += length;
         integer64[next] = value;
         return Value{ next, length, Value::value_type::integer64 };
     }
 
     Value alloc_real32(float value, int16_t length) noexcept
     {
-        const auto next = next_real32;
-        assert(length > 0);
-        assert(INT32_MAX - next > length);
+        const auto next = reserve(real32, next_real32, length);
 
-        next_real32 += length;
         real32[next] = value;
         return Value{ next, length, Value::value_type::real32 };
     }
 
     Value alloc_real64(double value, int16_t length) noexcept
     {
-        const auto next = next_real64;
-        assert(length > 0);
-        assert(INT32_MAX - next > length);
+        const auto next = reserve(real64, next_real64, length);
 
-        next_real64 += length;
         real64[next] = value;
         return Value{ next, length, Value::value_type::real64 };
     }
 
     Value alloc_vec2_32(vec2 value, int16_t length) noexcept
     {
-        const auto next = next_vec2_32;
-        assert(length > 0);
-        assert(INT32_MAX - next > length);
+        const auto next = reserve(vec2_32, next_vec2_32, length);
 
-        next_vec2_32 += length;
         vec2_32[next] = value;
         return Value{ next, length, Value::value_type::vec2_32 };
     }
 
     Value alloc_vec3_32(vec3 value, int16_t length) noexcept
     {
-        const auto next = next_vec3_32;
-        assert(length > 0);
-        assert(INT32_MAX - next > length);
+        const auto next = reserve(vec3_32, next_vec3_32, length);
 
-        next_vec3_32 += length;
         vec3_32[next] = value;
         return Value{ next, length, Value::value_type::vec3_32 };
     }
@@ -358,28 +375,1621 @@ struct Values
             return nullptr;
         }
     }
+
+private:
+    // Reserves @c length items at the end of the column, the column is
+    // doubled if needed: a bag may emit any number of values. The indices
+    // stay valid, the pointers to the items do not.
+    template<typename T>
+    static int reserve(array<T>& column, int& next, int length) noexcept
+    {
+        assert(length > 0);
+        assert(INT32_MAX - next > length);
+
+        const auto index = next;
+
+        if (column.size - index < length) {
+            const auto doubled =
+              column.size < INT32_MAX / 2 ? column.size * 2 : INT32_MAX;
+            column.resize(std::max(doubled, index + length));
+        }
+
+        next += length;
+        return index;
+    }
+};
+
+/**
+ * @brief A message sent by the simulator @c source on its output @c slot.
+ */
+struct OutputMessage
+{
+    ID source;
+    int slot;
+    Value value;
+};
+
+/**
+ * @brief A message received by the simulator @c destination on its input
+ * @c slot.
+ */
+struct InputMessage
+{
+    ID destination;
+    ID source;
+    int slot;
+    Value value;
+};
+
+/**
+ * @brief The messages received by a simulator at the current time, ordered
+ * by source simulator.
+ */
+class Bag
+{
+    const InputMessage* m_first;
+    const InputMessage* m_last;
+    const Values* m_values;
+
+public:
+    Bag(const InputMessage* first,
+        const InputMessage* last,
+        const Values& values) noexcept
+      : m_first(first)
+      , m_last(last)
+      , m_values(&values)
+    {}
+
+    const InputMessage* begin() const noexcept
+    {
+        return m_first;
+    }
+
+    const InputMessage* end() const noexcept
+    {
+        return m_last;
+    }
+
+    int size() const noexcept
+    {
+        return static_cast<int>(m_last - m_first);
+    }
+
+    bool empty() const noexcept
+    {
+        return m_first == m_last;
+    }
+
+    /**
+     * @brief Get the @c i-th real of the message.
+     */
+    double real64(const InputMessage& msg, int i = 0) const noexcept
+    {
+        assert(msg.value.type == Value::value_type::real64);
+        assert(i >= 0 && i < msg.value.size);
+
+        return m_values->real64[msg.value.index + i];
+    }
+};
+
+/**
+ * @brief Stores the messages sent by a simulator during its output
+ * function.
+ */
+class Outputs
+{
+    Values* m_values;
+    std::vector<OutputMessage>* m_messages;
+    ID m_source;
+
+public:
+    Outputs(Values& values,
+            std::vector<OutputMessage>& messages,
+            ID source) noexcept
+      : m_values(&values)
+      , m_messages(&messages)
+      , m_source(source)
+    {}
+
+    void emit(int slot, double value)
+    {
+        m_messages->push_back(
+          OutputMessage{ m_source, slot, m_values->alloc_real64(value) });
+    }
+
+    void emit(int slot, const double* values, int size)
+    {
+        assert(size > 0 && size <= INT16_MAX);
+
+        auto value = m_values->alloc_real64(values[0], size);
+        for (int i = 1; i < size; ++i)
+            m_values->real64[value.index + i] = values[i];
+
+        m_messages->push_back(OutputMessage{ m_source, slot, value });
+    }
+};
+
+/**
+ * @brief The behaviour of an atomic model in the parallel DEVS formalism.
+ * @details The transition functions return the time advance, the duration
+ * until the next internal event (infinity for a passive model). The
+ * transitions of the simulators of a same bag are called in parallel with
+ * @c FlatSimulation::run(thread_pool&) and must only update the state of
+ * their own object. The times are @c double whatever the time type of the
+ * engine.
+ */
+class AtomicDynamics
+{
+public:
+    virtual ~AtomicDynamics() noexcept = default;
+
+    virtual double initialize(double t) noexcept = 0;
+
+    virtual void lambda(Outputs& outputs) noexcept = 0;
+
+    virtual double internal(double t) noexcept = 0;
+
+    virtual double external(double t, double e, const Bag& bag) noexcept = 0;
+
+    /**
+     * @brief The default confluent transition is the internal transition
+     * followed by the external transition with a zero elapsed time.
+     */
+    virtual double confluent(double t, const Bag& bag) noexcept
+    {
+        internal(t);
+        return external(t, 0.0, bag);
+    }
+
+    /**
+     * @brief The size in bytes of the state copied by @c save.
+     * @details Optimistic engines save the state of a simulator before
+     * each of its transitions and restore it when the transition is
+     * rolled back. The default is a stateless model.
+     */
+    virtual int state_size() const noexcept
+    {
+        return 0;
+    }
+
+    virtual void save(void* /*buffer*/) const noexcept
+    {}
+
+    virtual void restore(const void* /*buffer*/) noexcept
+    {}
+
+    /**
+     * @brief A lower bound of the time advances returned by the transition
+     * functions, except by an external transition that keeps the time of
+     * the next internal event.
+     * @details Conservative engines run in parallel the bags of a partition
+     * closer than the lookahead of the other partitions. The default,
+     * zero, synchronizes all partitions at each bag.
+     */
+    virtual double lookahead() const noexcept
+    {
+        return 0.0;
+    }
+};
+
+/**
+ * @brief The type of the dynamics of a simulator: an @c AtomicDynamics
+ * provided by the user (virtual calls) or one of the built-in dynamics
+ * (static dispatch).
+ */
+enum class dynamics_type : std::int8_t
+{
+    external,
+    constant,
+    time_generator,
+    step_generator,
+    counter,
+    adder,
+    multiplier,
+    integrator,
+    qss2_integrator,
+    qss3_integrator,
+    cross_detector,
+    queue
+};
+
+/**
+ * @brief Common functions of the built-in dynamics.
+ * @details The built-in dynamics are trivially copyable: their snapshot
+ * for the optimistic engines is a copy of the object.
+ */
+template<typename Dynamics>
+struct builtin_dynamics
+{
+    static constexpr double infinity = std::numeric_limits<double>::infinity();
+
+    double confluent(double t, const Bag& bag) noexcept
+    {
+        auto& self = static_cast<Dynamics&>(*this);
+
+        self.internal(t);
+        return self.external(t, 0.0, bag);
+    }
+
+    int state_size() const noexcept
+    {
+        return static_cast<int>(sizeof(Dynamics));
+    }
+
+    void save(void* buffer) const noexcept
+    {
+        static_assert(std::is_trivially_copyable<Dynamics>::value,
+                      "built-in dynamics must be trivially copyable");
+
+        std::memcpy(
+          buffer, static_cast<const Dynamics*>(this), sizeof(Dynamics));
+    }
+
+    void restore(const void* buffer) noexcept
+    {
+        std::memcpy(static_cast<Dynamics*>(this), buffer, sizeof(Dynamics));
+    }
+
+    double lookahead() const noexcept
+    {
+        return 0.0;
+    }
 };
 
-struct Simulator
+/**
+ * @brief Sends @c value once, @c offset after the start. The received
+ * messages are ignored.
+ */
+struct constant : builtin_dynamics<constant>
+{
+    static constexpr dynamics_type type = dynamics_type::constant;
+
+    double value = 0.0;
+    double offset = 0.0;
+    double sigma = 0.0;
+
+    double initialize(double /*t*/) noexcept
+    {
+        sigma = offset;
+        return sigma;
+    }
+
+    void lambda(Outputs& outputs) noexcept
+    {
+        outputs.emit(0, value);
+    }
+
+    double internal(double /*t*/) noexcept
+    {
+        sigma = infinity;
+        return sigma;
+    }
+
+    double external(double /*t*/, double e, const Bag& /*bag*/) noexcept
+    {
+        sigma -= e;
+        return sigma;
+    }
+
+    double lookahead() const noexcept
+    {
+        return infinity;
+    }
+};
+
+/**
+ * @brief Sends the current time every @c period, the first time @c offset
+ * after the start. The received messages are ignored.
+ */
+struct time_generator : builtin_dynamics<time_generator>
+{
+    static constexpr dynamics_type type = dynamics_type::time_generator;
+
+    double period = 1.0;
+    double offset = 0.0;
+    double next = 0.0;
+    double sigma = 0.0;
+
+    double initialize(double t) noexcept
+    {
+        next = t + offset;
+        sigma = offset;
+        return sigma;
+    }
+
+    void lambda(Outputs& outputs) noexcept
+    {
+        outputs.emit(0, next);
+    }
+
+    double internal(double t) noexcept
+    {
+        next = t + period;
+        sigma = period;
+        return sigma;
+    }
+
+    // The received messages do not move the next tick.
+    double external(double /*t*/, double e, const Bag& /*bag*/) noexcept
+    {
+        sigma -= e;
+        return sigma;
+    }
+
+    double lookahead() const noexcept
+    {
+        return period;
+    }
+};
+
+/**
+ * @brief Sends @c before at the start then @c after at the time
+ * @c step_time. The received messages are ignored.
+ */
+struct step_generator : builtin_dynamics<step_generator>
+{
+    static constexpr dynamics_type type = dynamics_type::step_generator;
+
+    double before = 0.0;
+    double after = 1.0;
+    double step_time = 1.0;
+    double sigma = 0.0;
+    int phase = 0;
+
+    double initialize(double /*t*/) noexcept
+    {
+        phase = 0;
+        sigma = 0.0;
+        return sigma;
+    }
+
+    void lambda(Outputs& outputs) noexcept
+    {
+        outputs.emit(0, phase == 0 ? before : after);
+    }
+
+    double internal(double t) noexcept
+    {
+        if (phase++ == 0)
+            sigma = step_time > t ? step_time - t : 0.0;
+        else
+            sigma = infinity;
+
+        return sigma;
+    }
+
+    double external(double /*t*/, double e, const Bag& /*bag*/) noexcept
+    {
+        sigma -= e;
+        return sigma;
+    }
+};
+
+/**
+ * @brief Counts the received messages.
+ */
+struct counter : builtin_dynamics<counter>
+{
+    static constexpr dynamics_type type = dynamics_type::counter;
+
+    std::int64_t number = 0;
+
+    double initialize(double /*t*/) noexcept
+    {
+        number = 0;
+        return infinity;
+    }
+
+    void lambda(Outputs& /*outputs*/) noexcept
+    {}
+
+    double internal(double /*t*/) noexcept
+    {
+        return infinity;
+    }
+
+    double external(double /*t*/, double /*e*/, const Bag& bag) noexcept
+    {
+        number += bag.size();
+        return infinity;
+    }
+
+    double lookahead() const noexcept
+    {
+        return infinity;
+    }
+};
+
+/**
+ * @brief Sends the weighted sum of the last values received on its
+ * @c size input slots each time one of them changes.
+ */
+struct adder : builtin_dynamics<adder>
+{
+    static constexpr dynamics_type type = dynamics_type::adder;
+    static constexpr int max_size = 4;
+
+    double coeffs[max_size] = { 1.0, 1.0, 1.0, 1.0 };
+    double values[max_size] = { 0.0, 0.0, 0.0, 0.0 };
+    int size = 2;
+
+    double initialize(double /*t*/) noexcept
+    {
+        return infinity;
+    }
+
+    void lambda(Outputs& outputs) noexcept
+    {
+        double sum = 0.0;
+        for (int i = 0; i != size; ++i)
+            sum += coeffs[i] * values[i];
+
+        outputs.emit(0, sum);
+    }
+
+    double internal(double /*t*/) noexcept
+    {
+        return infinity;
+    }
+
+    double external(double /*t*/, double /*e*/, const Bag& bag) noexcept
+    {
+        for (const auto& msg : bag) {
+            assert(msg.slot >= 0 && msg.slot < size);
+            values[msg.slot] = bag.real64(msg);
+        }
+
+        return 0.0;
+    }
+};
+
+/**
+ * @brief Sends the product of the last values received on its @c size
+ * input slots each time one of them changes.
+ */
+struct multiplier : builtin_dynamics<multiplier>
+{
+    static constexpr dynamics_type type = dynamics_type::multiplier;
+    static constexpr int max_size = 4;
+
+    double values[max_size] = { 1.0, 1.0, 1.0, 1.0 };
+    int size = 2;
+
+    double initialize(double /*t*/) noexcept
+    {
+        return infinity;
+    }
+
+    void lambda(Outputs& outputs) noexcept
+    {
+        double product = 1.0;
+        for (int i = 0; i != size; ++i)
+            product *= values[i];
+
+        outputs.emit(0, product);
+    }
+
+    double internal(double /*t*/) noexcept
+    {
+        return infinity;
+    }
+
+    double external(double /*t*/, double /*e*/, const Bag& bag) noexcept
+    {
+        for (const auto& msg : bag) {
+            assert(msg.slot >= 0 && msg.slot < size);
+            values[msg.slot] = bag.real64(msg);
+        }
+
+        return 0.0;
+    }
+};
+
+/**
+ * @brief A first order quantized state integrator (QSS1): integrates the
+ * last derivative received and sends the state each time it changes by the
+ * quantum @c dq.
+ */
+struct integrator : builtin_dynamics<integrator>
+{
+    static constexpr dynamics_type type = dynamics_type::integrator;
+
+    double x = 0.0;  // state
+    double u = 0.0;  // derivative
+    double q = 0.0;  // last quantized state sent
+    double dq = 0.01;
+    double sigma = 0.0;
+
+    static double advance(double x, double u, double q, double dq) noexcept
+    {
+        if (u == 0.0)
+            return infinity;
+
+        const auto limit = u > 0.0 ? q + dq : q - dq;
+        const auto ta = (limit - x) / u;
+
+        return ta > 0.0 ? ta : 0.0;
+    }
+
+    double advance() const noexcept
+    {
+        return advance(x, u, q, dq);
+    }
+
+    double initialize(double /*t*/) noexcept
+    {
+        q = x;
+        sigma = advance();
+        return sigma;
+    }
+
+    void lambda(Outputs& outputs) noexcept
+    {
+        outputs.emit(0, x + u * sigma);
+    }
+
+    double internal(double /*t*/) noexcept
+    {
+        x += u * sigma;
+        q = x;
+        sigma = advance();
+        return sigma;
+    }
+
+    double external(double /*t*/, double e, const Bag& bag) noexcept
+    {
+        x += u * e;
+
+        for (const auto& msg : bag)
+            u = bag.real64(msg);
+
+        sigma = advance();
+        return sigma;
+    }
+};
+
+/**
+ * @brief The lowest strictly positive root of a s^2 + b s + c, infinity if
+ * there is none.
+ */
+inline double
+min_positive_root(double a, double b, double c) noexcept
+{
+    constexpr auto inf = std::numeric_limits<double>::infinity();
+
+    if (a == 0.0) {
+        if (b == 0.0)
+            return inf;
+
+        const auto root = -c / b;
+        return root > 0.0 ? root : inf;
+    }
+
+    const auto delta = b * b - 4.0 * a * c;
+    if (delta < 0.0)
+        return inf;
+
+    // The stable form avoids the cancellation of -b + sqrt(delta).
+    const auto sq = std::sqrt(delta);
+    const auto half = -0.5 * (b < 0.0 ? b - sq : b + sq);
+    const auto r1 = half / a;
+    const auto r2 = half != 0.0 ? c / half : inf;
+
+    if (r1 > 0.0 && r2 > 0.0)
+        return r1 < r2 ? r1 : r2;
+
+    return r1 > 0.0 ? r1 : r2 > 0.0 ? r2 : inf;
+}
+
+/**
+ * @brief The lowest strictly positive root of a s^3 + b s^2 + c s + d,
+ * infinity if there is none.
+ */
+inline double
+min_positive_root(double a, double b, double c, double d) noexcept
+{
+    constexpr auto inf = std::numeric_limits<double>::infinity();
+    constexpr auto pi = 3.14159265358979323846;
+
+    if (a == 0.0)
+        return min_positive_root(b, c, d);
+
+    // Cardano on the depressed cubic y^3 + p y + q with s = y - b / 3a.
+    const auto B = b / a;
+    const auto C = c / a;
+    const auto D = d / a;
+    const auto shift = B / 3.0;
+    const auto p = C - B * shift;
+    const auto q = 2.0 * shift * shift * shift - shift * C + D;
+    const auto delta = q * q / 4.0 + p * p * p / 27.0;
+
+    double roots[3];
+    int size;
+
+    if (delta > 0.0 || p == 0.0) {
+        const auto sq = std::sqrt(delta > 0.0 ? delta : 0.0);
+        roots[0] = std::cbrt(-q / 2.0 + sq) + std::cbrt(-q / 2.0 - sq) - shift;
+        size = 1;
+    } else {
+        const auto r = 2.0 * std::sqrt(-p / 3.0);
+        auto cosine = 3.0 * q / (p * r);
+        cosine = cosine < -1.0 ? -1.0 : cosine > 1.0 ? 1.0 : cosine;
+        const auto phi = std::acos(cosine) / 3.0;
+
+        for (int k = 0; k != 3; ++k)
+            roots[k] = r * std::cos(phi - 2.0 * pi * k / 3.0) - shift;
+        size = 3;
+    }
+
+    auto ret = inf;
+    for (int i = 0; i != size; ++i)
+        if (roots[i] > 0.0 && roots[i] < ret)
+            ret = roots[i];
+
+    return ret;
+}
+
+/**
+ * @brief A second order quantized state integrator (QSS2).
+ * @details The derivative is the line @c u + @c mu e, the state the
+ * parabola @c x + @c u e + @c mu e^2 / 2 and the quantized state the line
+ * @c q + @c mq e. The messages carry the coefficients of a polynomial of
+ * the elapsed time: the output is { x, u } and the input is read as
+ * { u, mu }, a missing coefficient is zero.
+ */
+struct qss2_integrator : builtin_dynamics<qss2_integrator>
+{
+    static constexpr dynamics_type type = dynamics_type::qss2_integrator;
+
+    double x = 0.0;
+    double u = 0.0;
+    double mu = 0.0;
+    double q = 0.0;
+    double mq = 0.0;
+    double dq = 0.01;
+    double sigma = 0.0;
+
+    /// The time advance when the quantized state is the tangent of the
+    /// state: |x - q| = mu e^2 / 2 reaches dq.
+    static double advance(double mu, double dq) noexcept
+    {
+        if (mu == 0.0)
+            return infinity;
+
+        return std::sqrt(2.0 * dq / std::abs(mu));
+    }
+
+    double initialize(double /*t*/) noexcept
+    {
+        q = x;
+        mq = u;
+        sigma = advance(mu, dq);
+        return sigma;
+    }
+
+    void lambda(Outputs& outputs) noexcept
+    {
+        const double s = sigma;
+        const double values[2] = { x + (u + 0.5 * mu * s) * s, u + mu * s };
+
+        outputs.emit(0, values, 2);
+    }
+
+    double internal(double /*t*/) noexcept
+    {
+        const double s = sigma;
+
+        x = x + (u + 0.5 * mu * s) * s;
+        u = u + mu * s;
+        q = x;
+        mq = u;
+        sigma = advance(mu, dq);
+        return sigma;
+    }
+
+    double external(double /*t*/, double e, const Bag& bag) noexcept
+    {
+        const double s = e;
+
+        x = x + (u + 0.5 * mu * s) * s;
+        q = q + mq * s;
+
+        for (const auto& msg : bag) {
+            u = bag.real64(msg);
+            mu = msg.value.size > 1 ? bag.real64(msg, 1) : 0.0;
+        }
+
+        // |(x - q) + (u - mq) s + mu s^2 / 2| reaches dq.
+        const auto a = 0.5 * mu;
+        const auto b = u - mq;
+        const auto c = x - q;
+        const auto ta = std::min(min_positive_root(a, b, c - dq),
+                                 min_positive_root(a, b, c + dq));
+
+        sigma = ta;
+        return sigma;
+    }
+};
+
+/**
+ * @brief A third order quantized state integrator (QSS3).
+ * @details The derivative is the parabola @c u + @c mu e + @c pu e^2, the
+ * state the cubic @c x + @c u e + @c mu e^2 / 2 + @c pu e^3 / 3 and the
+ * quantized state the parabola @c q + @c mq e + @c pq e^2. The output is
+ * { x, u, mu / 2 } and the input is read as { u, mu, pu }.
+ */
+struct qss3_integrator : builtin_dynamics<qss3_integrator>
+{
+    static constexpr dynamics_type type = dynamics_type::qss3_integrator;
+
+    double x = 0.0;
+    double u = 0.0;
+    double mu = 0.0;
+    double pu = 0.0;
+    double q = 0.0;
+    double mq = 0.0;
+    double pq = 0.0;
+    double dq = 0.01;
+    double sigma = 0.0;
+
+    /// The time advance when the quantized state is the second order
+    /// Taylor polynomial of the state: |x - q| = pu e^3 / 3 reaches dq.
+    static double advance(double pu, double dq) noexcept
+    {
+        if (pu == 0.0)
+            return infinity;
+
+        return std::cbrt(3.0 * dq / std::abs(pu));
+    }
+
+    double initialize(double /*t*/) noexcept
+    {
+        q = x;
+        mq = u;
+        pq = 0.5 * mu;
+        sigma = advance(pu, dq);
+        return sigma;
+    }
+
+    void lambda(Outputs& outputs) noexcept
+    {
+        const double s = sigma;
+        const double values[3] = { x + (u + (0.5 * mu + pu / 3.0 * s) * s) * s,
+                                   u + (mu + pu * s) * s,
+                                   0.5 * (mu + 2.0 * pu * s) };
+
+        outputs.emit(0, values, 3);
+    }
+
+    double internal(double /*t*/) noexcept
+    {
+        const double s = sigma;
+
+        x = x + (u + (0.5 * mu + pu / 3.0 * s) * s) * s;
+        u = u + (mu + pu * s) * s;
+        mu = mu + 2.0 * pu * s;
+        q = x;
+        mq = u;
+        pq = 0.5 * mu;
+        sigma = advance(pu, dq);
+        return sigma;
+    }
+
+    double external(double /*t*/, double e, const Bag& bag) noexcept
+    {
+        const double s = e;
+
+        x = x + (u + (0.5 * mu + pu / 3.0 * s) * s) * s;
+        q = q + (mq + pq * s) * s;
+        mq = mq + 2.0 * pq * s;
+
+        for (const auto& msg : bag) {
+            u = bag.real64(msg);
+            mu = msg.value.size > 1 ? bag.real64(msg, 1) : 0.0;
+            pu = msg.value.size > 2 ? bag.real64(msg, 2) : 0.0;
+        }
+
+        // |(x - q) + (u - mq) s + (mu / 2 - pq) s^2 + pu s^3 / 3| reaches
+        // dq.
+        const auto a = pu / 3.0;
+        const auto b = 0.5 * mu - pq;
+        const auto c = u - mq;
+        const auto d = x - q;
+        const auto ta = std::min(min_positive_root(a, b, c, d - dq),
+                                 min_positive_root(a, b, c, d + dq));
+
+        sigma = ta;
+        return sigma;
+    }
+};
+
+/**
+ * @brief Loads a dynamics from the columns of a structure of arrays and
+ * stores it back at the end of the scope: used to call the functions of the
+ * dynamics.
+ */
+template<typename Columns>
+struct column_proxy
+{
+    Columns& columns;
+    int index;
+    typename Columns::value_type value;
+
+    column_proxy(Columns& columns_, int index_) noexcept
+      : columns(columns_)
+      , index(index_)
+      , value(columns_.load(index_))
+    {}
+
+    ~column_proxy() noexcept
+    {
+        columns.store(index, value);
+    }
+
+    column_proxy(const column_proxy&) = delete;
+    column_proxy& operator=(const column_proxy&) = delete;
+};
+
+/**
+ * @brief The integrators stored as a structure of arrays.
+ * @details Each member of @c integrator is a column indexed by the column
+ * index of the integrator. The internal transitions of the imminent
+ * integrators of a bag are computed in batch over the columns: the loop
+ * touches only the useful bytes of each cache line and is vectorized (see
+ * qss.cpp).
+ */
+struct integrator_array
+{
+    using value_type = integrator;
+
+    array<double> x;
+    array<double> u;
+    array<double> q;
+    array<double> dq;
+    array<double> sigma;
+    int size = 0;
+    int capacity = 0;
+
+    bool init(int capacity_)
+    {
+        if (capacity_ < 0)
+            return false;
+
+        x.init(capacity_);
+        u.init(capacity_);
+        q.init(capacity_);
+        dq.init(capacity_);
+        sigma.init(capacity_);
+        size = 0;
+        capacity = capacity_;
+
+        return true;
+    }
+
+    bool full() const noexcept
+    {
+        return size == capacity;
+    }
+
+    /**
+     * @brief Appends a default integrator.
+     *
+     * @return the column index of the new integrator or -1 if the columns
+     * are full.
+     */
+    int alloc() noexcept
+    {
+        if (full())
+            return -1;
+
+        store(size, value_type{});
+        return size++;
+    }
+
+    value_type load(int i) const noexcept
+    {
+        value_type ret;
+        ret.x = x[i];
+        ret.u = u[i];
+        ret.q = q[i];
+        ret.dq = dq[i];
+        ret.sigma = sigma[i];
+
+        return ret;
+    }
+
+    void store(int i, const value_type& integ) noexcept
+    {
+        x[i] = integ.x;
+        u[i] = integ.u;
+        q[i] = integ.q;
+        dq[i] = integ.dq;
+        sigma[i] = integ.sigma;
+    }
+
+    /**
+     * @brief The internal transitions of the integrators @c columns[0] to
+     * @c columns[number - 1], all different. Same results as
+     * @c integrator::internal, the new time advances are in the @c sigma
+     * column.
+     */
+    void internal(const int* columns, int number) noexcept;
+};
+
+/**
+ * @brief The QSS2 integrators stored as a structure of arrays.
+ */
+struct qss2_integrator_array
+{
+    using value_type = qss2_integrator;
+
+    array<double> x;
+    array<double> u;
+    array<double> mu;
+    array<double> q;
+    array<double> mq;
+    array<double> dq;
+    array<double> sigma;
+    int size = 0;
+    int capacity = 0;
+
+    bool init(int capacity_)
+    {
+        if (capacity_ < 0)
+            return false;
+
+        x.init(capacity_);
+        u.init(capacity_);
+        mu.init(capacity_);
+        q.init(capacity_);
+        mq.init(capacity_);
+        dq.init(capacity_);
+        sigma.init(capacity_);
+        size = 0;
+        capacity = capacity_;
+
+        return true;
+    }
+
+    bool full() const noexcept
+    {
+        return size == capacity;
+    }
+
+    int alloc() noexcept
+    {
+        if (full())
+            return -1;
+
+        store(size, value_type{});
+        return size++;
+    }
+
+    value_type load(int i) const noexcept
+    {
+        value_type ret;
+        ret.x = x[i];
+        ret.u = u[i];
+        ret.mu = mu[i];
+        ret.q = q[i];
+        ret.mq = mq[i];
+        ret.dq = dq[i];
+        ret.sigma = sigma[i];
+
+        return ret;
+    }
+
+    void store(int i, const value_type& integ) noexcept
+    {
+        x[i] = integ.x;
+        u[i] = integ.u;
+        mu[i] = integ.mu;
+        q[i] = integ.q;
+        mq[i] = integ.mq;
+        dq[i] = integ.dq;
+        sigma[i] = integ.sigma;
+    }
+
+    void internal(const int* columns, int number) noexcept;
+};
+
+/**
+ * @brief The QSS3 integrators stored as a structure of arrays.
+ */
+struct qss3_integrator_array
+{
+    using value_type = qss3_integrator;
+
+    array<double> x;
+    array<double> u;
+    array<double> mu;
+    array<double> pu;
+    array<double> q;
+    array<double> mq;
+    array<double> pq;
+    array<double> dq;
+    array<double> sigma;
+    int size = 0;
+    int capacity = 0;
+
+    bool init(int capacity_)
+    {
+        if (capacity_ < 0)
+            return false;
+
+        x.init(capacity_);
+        u.init(capacity_);
+        mu.init(capacity_);
+        pu.init(capacity_);
+        q.init(capacity_);
+        mq.init(capacity_);
+        pq.init(capacity_);
+        dq.init(capacity_);
+        sigma.init(capacity_);
+        size = 0;
+        capacity = capacity_;
+
+        return true;
+    }
+
+    bool full() const noexcept
+    {
+        return size == capacity;
+    }
+
+    int alloc() noexcept
+    {
+        if (full())
+            return -1;
+
+        store(size, value_type{});
+        return size++;
+    }
+
+    value_type load(int i) const noexcept
+    {
+        value_type ret;
+        ret.x = x[i];
+        ret.u = u[i];
+        ret.mu = mu[i];
+        ret.pu = pu[i];
+        ret.q = q[i];
+        ret.mq = mq[i];
+        ret.pq = pq[i];
+        ret.dq = dq[i];
+        ret.sigma = sigma[i];
+
+        return ret;
+    }
+
+    void store(int i, const value_type& integ) noexcept
+    {
+        x[i] = integ.x;
+        u[i] = integ.u;
+        mu[i] = integ.mu;
+        pu[i] = integ.pu;
+        q[i] = integ.q;
+        mq[i] = integ.mq;
+        pq[i] = integ.pq;
+        dq[i] = integ.dq;
+        sigma[i] = integ.sigma;
+    }
+
+    void internal(const int* columns, int number) noexcept;
+};
+
+/**
+ * @brief The number of integrators computed at once by the internal
+ * transition kernels: 8 with AVX-512, 4 with AVX2, 1 otherwise.
+ */
+int
+integrator_kernel_width() noexcept;
+
+/**
+ * @brief Sends the received value when it crosses the @c threshold.
+ */
+struct cross_detector : builtin_dynamics<cross_detector>
+{
+    static constexpr dynamics_type type = dynamics_type::cross_detector;
+
+    double threshold = 0.0;
+    double value = 0.0;
+    bool above = false;
+
+    double initialize(double /*t*/) noexcept
+    {
+        above = value >= threshold;
+        return infinity;
+    }
+
+    void lambda(Outputs& outputs) noexcept
+    {
+        outputs.emit(0, value);
+    }
+
+    double internal(double /*t*/) noexcept
+    {
+        return infinity;
+    }
+
+    double external(double /*t*/, double /*e*/, const Bag& bag) noexcept
+    {
+        for (const auto& msg : bag)
+            value = bag.real64(msg);
+
+        if ((value >= threshold) == above)
+            return infinity;
+
+        above = !above;
+        return 0.0;
+    }
+};
+
+/**
+ * @brief Sends each received value @c delay after its reception. The
+ * values received when the queue is full are lost.
+ */
+struct queue : builtin_dynamics<queue>
+{
+    static constexpr dynamics_type type = dynamics_type::queue;
+    static constexpr int capacity = 32;
+
+    double times[capacity];
+    double values[capacity];
+    double delay = 1.0;
+    int head = 0;
+    int size = 0;
+
+    double advance(double t) const noexcept
+    {
+        if (size == 0)
+            return infinity;
+
+        return times[head] > t ? times[head] - t : 0.0;
+    }
+
+    double initialize(double /*t*/) noexcept
+    {
+        head = 0;
+        size = 0;
+        return infinity;
+    }
+
+    void lambda(Outputs& outputs) noexcept
+    {
+        for (int i = 0; i != size; ++i) {
+            const auto index = (head + i) % capacity;
+            if (times[index] != times[head])
+                break;
+
+            outputs.emit(0, values[index]);
+        }
+    }
+
+    double internal(double t) noexcept
+    {
+        const auto front = times[head];
+
+        while (size > 0 && times[head] == front) {
+            head = (head + 1) % capacity;
+            --size;
+        }
+
+        return advance(t);
+    }
+
+    double external(double t, double /*e*/, const Bag& bag) noexcept
+    {
+        for (const auto& msg : bag) {
+            if (size == capacity)
+                break;
+
+            const auto index = (head + size) % capacity;
+            times[index] = t + delay;
+            values[index] = bag.real64(msg);
+            ++size;
+        }
+
+        return advance(t);
+    }
+};
+
+/**
+ * @brief The objects of the built-in dynamics, one data_array per type,
+ * except the integrators stored as structures of arrays.
+ */
+struct BuiltinDynamics
+{
+    data_array<constant, ID, model_id_split> constants;
+    data_array<time_generator, ID, model_id_split> time_generators;
+    data_array<step_generator, ID, model_id_split> step_generators;
+    data_array<counter, ID, model_id_split> counters;
+    data_array<adder, ID, model_id_split> adders;
+    data_array<multiplier, ID, model_id_split> multipliers;
+    integrator_array integrators;
+    qss2_integrator_array qss2_integrators;
+    qss3_integrator_array qss3_integrators;
+    data_array<cross_detector, ID, model_id_split> cross_detectors;
+    data_array<queue, ID, model_id_split> queues;
+
+    bool init(int capacity)
+    {
+        return constants.init(capacity) && time_generators.init(capacity) &&
+               step_generators.init(capacity) && counters.init(capacity) &&
+               adders.init(capacity) && multipliers.init(capacity) &&
+               integrators.init(capacity) && qss2_integrators.init(capacity) &&
+               qss3_integrators.init(capacity) &&
+               cross_detectors.init(capacity) && queues.init(capacity);
+    }
+
+    template<typename Integrator>
+    auto& get_columns() noexcept
+    {
+        if constexpr (std::is_same_v<Integrator, integrator>)
+            return integrators;
+        else if constexpr (std::is_same_v<Integrator, qss2_integrator>)
+            return qss2_integrators;
+        else
+            return qss3_integrators;
+    }
+
+    template<typename Dynamics>
+    data_array<Dynamics, ID, model_id_split>& get() noexcept
+    {
+        static_assert(!std::is_same_v<Dynamics, integrator> &&
+                        !std::is_same_v<Dynamics, qss2_integrator> &&
+                        !std::is_same_v<Dynamics, qss3_integrator>,
+                      "integrators are stored in structures of arrays");
+
+        if constexpr (std::is_same_v<Dynamics, constant>)
+            return constants;
+        else if constexpr (std::is_same_v<Dynamics, time_generator>)
+            return time_generators;
+        else if constexpr (std::is_same_v<Dynamics, step_generator>)
+            return step_generators;
+        else if constexpr (std::is_same_v<Dynamics, counter>)
+            return counters;
+        else if constexpr (std::is_same_v<Dynamics, adder>)
+            return adders;
+        else if constexpr (std::is_same_v<Dynamics, multiplier>)
+            return multipliers;
+        else if constexpr (std::is_same_v<Dynamics, cross_detector>)
+            return cross_detectors;
+        else
+            return queues;
+    }
+};
+
+/**
+ * @brief An atomic model in a @c BasicFlatSimulation.
+ *
+ * @tparam Time The type of the time of the engine: @c float, @c double or
+ * a @c fixed_time.
+ */
+template<typename Time>
+struct BasicSimulator
 {
     ID dynamics;
+    ID node; // The atomic Node of the Model.
+    AtomicDynamics* atomic;
+
+    /// With a built-in type, @c builtin is the identifier of the object in
+    /// the @c BuiltinDynamics, or the column index for the integrators,
+    /// and @c atomic is unused.
+    dynamics_type type;
+    ID builtin;
 
     int input_slots_number;
     int output_slots_number;
 
-    float tl;
-    float tn;
+    Time tl;
+    Time tn;
+};
+
+using Simulator = BasicSimulator<float>;
+using Simulators = data_array<Simulator, ID, model_id_split, separated_ids>;
+
+/**
+ * @brief The destination of a message: an input slot of a simulator.
+ */
+struct Route
+{
+    ID simulator;
+    int slot;
 };
 
-struct FlatSimulation
+// A convenient class to be used in ranged-base loop over the routes of an
+// output slot.
+class route_range
 {
+    const Route* m_first;
+    const Route* m_last;
+
+public:
+    route_range(const Route* first, const Route* last) noexcept
+      : m_first(first)
+      , m_last(last)
+    {}
+
+    const Route* begin() const noexcept
+    {
+        return m_first;
+    }
+
+    const Route* end() const noexcept
+    {
+        return m_last;
+    }
+
+    int size() const noexcept
+    {
+        return static_cast<int>(m_last - m_first);
+    }
+
+    bool empty() const noexcept
+    {
+        return m_first == m_last;
+    }
+};
+
+/**
+ * @brief The sequential PDEVS engine of the flattened Model.
+ * @details The absolute times (the time of the bags, @c tl and @c tn of the
+ * simulators) are of type @c Time: @c float, @c double or a
+ * @c fixed_time for exact scheduling. The dynamics work in @c double: the
+ * time of the bag and the elapsed times are converted to @c double and the
+ * time advances converted back to @c Time.
+ *
+ * The engine is instantiated in simulation.cpp for @c float, @c double and
+ * @c fixed_time<1000000> (a microsecond tick).
+ */
+template<typename Time>
+struct BasicFlatSimulation
+{
+    using time_type = Time;
+    using simulator_type = BasicSimulator<Time>;
+
     ID model;
 
-    float start;
-    float current;
-    float end;
+    Time start;
+    Time current;
+    Time end;
+
+    /// The identifiers are stored apart from the simulators: checking an
+    /// identifier does not load a simulator.
+    data_array<simulator_type, ID, model_id_split, separated_ids> simulators;
+
+    /// The routing table in compressed sparse row format. The output slot
+    /// @c s of the simulator with index @c i is the row
+    /// @c output_rows[i] + s and its destinations are the routes in
+    /// [route_offsets[row], route_offsets[row + 1]).
+    std::vector<int> output_rows;
+    std::vector<int> route_offsets;
+    std::vector<Route> routes;
+
+    /// A simulator to transition in the current bag with its input
+    /// messages in [first, last[ of the inputs vector.
+    struct Transition
+    {
+        ID simulator;
+        int first;
+        int last;
+        bool imminent;
+    };
+
+    BuiltinDynamics builtins;
+
+    scheduler<Time, ID, model_id_split> events;
+    Values values;
+    std::vector<ID> imminent;
+    std::vector<OutputMessage> outputs;
+    std::vector<InputMessage> inputs;
+    std::vector<Transition> transitions;
+    std::vector<std::uint32_t> imminent_stamp;
+    std::vector<std::uint32_t> influenced_stamp;
+    std::uint32_t bag_number = 0;
+
+    /// The imminent integrators without input of the current bag: their
+    /// internal transitions are done in batch by @c transition_batch.
+    struct Batch
+    {
+        std::vector<ID> simulators;
+        std::vector<int> columns;
+    };
+
+    /// One batch for each order of integrator: QSS1, QSS2 and QSS3.
+    Batch batches[3];
+
+    /**
+     * @brief Build the simulators and the routing table from the model.
+     * @details Each atomic Node becomes a Simulator and every chain of
+     * connections through coupled Node is collapsed into a direct route
+     * from an output slot of a simulator to an input slot of another one.
+     * In a coupled Node, a Connection goes from the (output_model,
+     * output_slot) to the (input_model, input_slot). If the output_model
+     * is the coupled Node itself, the output_slot is one of its input
+     * slots. If the input_model is the coupled Node itself, the
+     * input_slot is one of its output slots.
+     */
+    status init(Model& model);
+
+    /**
+     * @brief Initialize all the simulators at the @c start time.
+     * @details Each simulator needs an @c AtomicDynamics.
+     *
+     * @return false if a simulator does not have dynamics.
+     */
+    bool initialize(Time start,
+                    Time end,
+                    scheduler_type type = default_scheduler_type);
+
+    /**
+     * @brief Run the bag of the next time if it is lower than the @c end
+     * time.
+     *
+     * @return false if the simulation is finished.
+     */
+    bool step();
+
+    /**
+     * @brief Run the bag of the next time, the transitions of the
+     * simulators are dispatched on the threads of the pool.
+     *
+     * @return false if the simulation is finished.
+     */
+    bool step(thread_pool& pool);
+
+    void run();
+    void run(thread_pool& pool);
+
+    /**
+     * @brief Computes the outputs of the imminent simulators, routes them
+     * and builds the transitions of the bag.
+     *
+     * @return false if the simulation is finished.
+     */
+    bool start_bag();
+    void transition(const Transition& transition) noexcept;
+
+    /**
+     * @brief The internal transitions of the batched integrators in
+     * [first, last[ of @c batches[order - 1].
+     */
+    void transition_batch(int order, int first, int last) noexcept;
+    void end_bag();
+
+    /**
+     * @brief Allocate a built-in dynamics for the simulator.
+     *
+     * @return nullptr if there is no more place.
+     */
+    template<typename Dynamics>
+    Dynamics* alloc_dynamics(simulator_type& sim) noexcept
+    {
+        static_assert(!std::is_same_v<Dynamics, integrator>,
+                      "use alloc_integrator");
+
+        auto& array = builtins.get<Dynamics>();
+        auto* dynamics = array.try_alloc();
+        if (!dynamics)
+            return nullptr;
+
+        sim.atomic = nullptr;
+        sim.type = Dynamics::type;
+        sim.builtin = array.get_id(*dynamics);
+
+        return dynamics;
+    }
+
+    /**
+     * @brief Allocate an @c integrator, a @c qss2_integrator or a
+     * @c qss3_integrator for the simulator, its parameters are in the
+     * columns of @c builtins.get_columns<Integrator>().
+     *
+     * @return the column index of the integrator or -1 if there is no more
+     * place.
+     */
+    template<typename Integrator = integrator>
+    int alloc_integrator(simulator_type& sim) noexcept
+    {
+        const auto column = builtins.get_columns<Integrator>().alloc();
+        if (column < 0)
+            return -1;
+
+        sim.atomic = nullptr;
+        sim.type = Integrator::type;
+        sim.builtin = static_cast<ID>(column);
+
+        return column;
+    }
+
+    void set_dynamics(simulator_type& sim, AtomicDynamics& atomic) noexcept
+    {
+        sim.atomic = &atomic;
+        sim.type = dynamics_type::external;
+        sim.builtin = 0;
+    }
+
+    /**
+     * @brief Calls @c fct with the dynamics of the simulator.
+     * @details A switch on the dynamics type gives @c fct the object of the
+     * built-in type, so that its functions can be inlined, or the
+     * @c AtomicDynamics of an external dynamics. An integrator is loaded
+     * from its columns and stored back after the call.
+     *
+     * @code
+     * auto ta = flat.visit(sim, [t](auto& dyn) { return dyn.internal(t); });
+     * @endcode
+     */
+    template<typename Function>
+    auto visit(const simulator_type& sim, Function&& fct)
+    {
+        switch (sim.type) {
+        case dynamics_type::constant:
+            return fct(builtins.constants.get(sim.builtin));
+        case dynamics_type::time_generator:
+            return fct(builtins.time_generators.get(sim.builtin));
+        case dynamics_type::step_generator:
+            return fct(builtins.step_generators.get(sim.builtin));
+        case dynamics_type::counter:
+            return fct(builtins.counters.get(sim.builtin));
+        case dynamics_type::adder:
+            return fct(builtins.adders.get(sim.builtin));
+        case dynamics_type::multiplier:
+            return fct(builtins.multipliers.get(sim.builtin));
+        case dynamics_type::integrator: {
+            column_proxy<integrator_array> dyn(builtins.integrators,
+                                               static_cast<int>(sim.builtin));
+            return fct(dyn.value);
+        }
+        case dynamics_type::qss2_integrator: {
+            column_proxy<qss2_integrator_array> dyn(
+              builtins.qss2_integrators, static_cast<int>(sim.builtin));
+            return fct(dyn.value);
+        }
+        case dynamics_type::qss3_integrator: {
+            column_proxy<qss3_integrator_array> dyn(
+              builtins.qss3_integrators, static_cast<int>(sim.builtin));
+            return fct(dyn.value);
+        }
+        case dynamics_type::cross_detector:
+            return fct(builtins.cross_detectors.get(sim.builtin));
+        case dynamics_type::queue:
+            return fct(builtins.queues.get(sim.builtin));
+        case dynamics_type::external:
+            break;
+        }
+
+        return fct(*sim.atomic);
+    }
+
+    /**
+     * @brief true if the simulator has a built-in dynamics or an
+     * @c AtomicDynamics.
+     */
+    bool has_dynamics(const simulator_type& sim) const noexcept
+    {
+        return sim.type != dynamics_type::external || sim.atomic;
+    }
+
+    route_range get_routes(ID simulator, int slot) const noexcept
+    {
+        const auto row = output_rows[model_index(simulator)] + slot;
+
+        assert(slot >= 0 &&
+               slot < simulators.get(simulator).output_slots_number);
+
+        return route_range(routes.data() + route_offsets[row],
+                           routes.data() + route_offsets[row + 1]);
+    }
 };
 
+using FlatSimulation = BasicFlatSimulation<float>;
+
+extern template struct BasicFlatSimulation<float>;
+extern template struct BasicFlatSimulation<double>;
+extern template struct BasicFlatSimulation<fixed_time<1000000>>;
+
 } // irr
 
 #endif // ORG_VLEPROJECT_IRRITATOR_SIMULATION_HPP
@@ -0,0 +1,110 @@
+// Copyright (c) 2019 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef ORG_VLEPROJECT_IRRITATOR_SPSC_QUEUE_HPP
+#define ORG_VLEPROJECT_IRRITATOR_SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+#include <cstdint>
+
+namespace irr {
+
+/**
+ * @brief A bounded lock-free queue for one producer and one consumer
+ * thread.
+ * @details A ring buffer with a power of two capacity. The producer only
+ * writes the tail and the consumer only writes the head, each index lives
+ * in its own cache line. Indices are stored and loaded with sequential
+ * consistency so that a message pushed before a global flag is raised is
+ * visible to a consumer that observed the flag.
+ *
+ * @tparam T A trivially copyable type.
+ */
+template<typename T>
+class spsc_queue
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "spsc_queue needs a trivially copyable type");
+
+    std::unique_ptr<T[]> m_buffer;
+    std::uint32_t m_mask = 0;
+
+    alignas(64) std::atomic<std::uint32_t> m_head{ 0 };
+    alignas(64) std::atomic<std::uint32_t> m_tail{ 0 };
+
+public:
+    spsc_queue() = default;
+
+    spsc_queue(const spsc_queue&) = delete;
+    spsc_queue& operator=(const spsc_queue&) = delete;
+
+    /**
+     * @brief Allocate the ring buffer.
+     *
+     * @return false if capacity is not a power of two greater than 1.
+     */
+    bool init(int capacity)
+    {
+        if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+            return false;
+
+        m_buffer = std::make_unique<T[]>(capacity);
+        m_mask = static_cast<std::uint32_t>(capacity - 1);
+        m_head.store(0);
+        m_tail.store(0);
+
+        return true;
+    }
+
+    int capacity() const noexcept
+    {
+        return static_cast<int>(m_mask + 1);
+    }
+
+    /**
+     * @brief Producer only.
+     *
+     * @return false if the queue is full.
+     */
+    bool push(const T& value) noexcept
+    {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load() > m_mask)
+            return false;
+
+        m_buffer[tail & m_mask] = value;
+        m_tail.store(tail + 1);
+
+        return true;
+    }
+
+    /**
+     * @brief Consumer only.
+     *
+     * @return false if the queue is empty.
+     */
+    bool pop(T& value) noexcept
+    {
+        const auto head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load())
+            return false;
+
+        value = m_buffer[head & m_mask];
+        m_head.store(head + 1);
+
+        return true;
+    }
+
+    bool empty() const noexcept
+    {
+        return m_head.load() == m_tail.load();
+    }
+};
+
+} // namespace irr
+
+#endif // ORG_VLEPROJECT_IRRITATOR_SPSC_QUEUE_HPP
@@ -0,0 +1,360 @@
+// Copyright (c) 2019 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef ORG_VLEPROJECT_IRRITATOR_THREAD_POOL_HPP
+#define ORG_VLEPROJECT_IRRITATOR_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <cassert>
+#include <cstdint>
+
+namespace irr {
+
+/**
+ * @brief A pool of threads to run loops over independent indices.
+ * @details The range of indices of a loop is split into one contiguous
+ * range per worker (the calling thread is the worker 0). A worker takes
+ * small chunks from the front of its own range and, when empty, steals the
+ * back half of the range of another worker. Each range is a single 64 bits
+ * atomic word updated with compare and swap: no lock is taken while a loop
+ * runs. Idle workers spin for a while then sleep on a condition variable
+ * until the next loop.
+ *
+ * @code
+ * irr::thread_pool pool(4);
+ * std::vector<double> x(1024);
+ * pool.parallel_for(0, 1024, [&x](int i) { x[i] = i * 2.0; });
+ * @endcode
+ *
+ * Only one thread may call @c parallel_for at a time and the function must
+ * not call @c parallel_for on the same pool.
+ */
+class thread_pool
+{
+    struct alignas(64) worker_range
+    {
+        std::atomic<std::uint64_t> range{ 0 };
+    };
+
+    using job_function = void (*)(void*, int, int);
+
+    std::vector<std::thread> m_threads;
+    std::unique_ptr<worker_range[]> m_ranges;
+    int m_size = 1;
+
+    job_function m_job = nullptr;
+    void* m_context = nullptr;
+    int m_grain = 1;
+
+    std::atomic<unsigned> m_generation{ 0 };
+    std::atomic<int> m_running{ 0 };
+    std::atomic<int> m_sleeping{ 0 };
+    std::atomic<bool> m_stop{ false };
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+
+    static constexpr int spin_before_sleep = 4096;
+
+    static constexpr std::uint64_t pack(int begin, int end) noexcept
+    {
+        return static_cast<std::uint64_t>(static_cast<std::uint32_t>(begin))
+                 << 32 |
+               static_cast<std::uint32_t>(end);
+    }
+
+    static constexpr int begin_of(std::uint64_t range) noexcept
+    {
+        return static_cast<int>(range >> 32);
+    }
+
+    static constexpr int end_of(std::uint64_t range) noexcept
+    {
+        return static_cast<int>(range & 0xffffffff);
+    }
+
+    bool pop_front(int worker, int& begin, int& end) noexcept
+    {
+        auto& range = m_ranges[worker].range;
+        auto current = range.load(std::memory_order_acquire);
+
+        for (;;) {
+            const auto first = begin_of(current);
+            const auto last = end_of(current);
+            if (first >= last)
+                return false;
+
+            const auto next = last - first > m_grain ? first + m_grain : last;
+            if (range.compare_exchange_weak(current,
+                                            pack(next, last),
+                                            std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+                begin = first;
+                end = next;
+                return true;
+            }
+        }
+    }
+
+    bool steal(int worker) noexcept
+    {
+        for (int i = 1; i != m_size; ++i) {
+            const auto victim = (worker + i) % m_size;
+            auto& range = m_ranges[victim].range;
+            auto current = range.load(std::memory_order_acquire);
+
+            for (;;) {
+                const auto first = begin_of(current);
+                const auto last = end_of(current);
+                if (first >= last)
+                    break;
+
+                const auto half = (last - first + 1) / 2;
+                if (range.compare_exchange_weak(current,
+                                                pack(first, last - half),
+                                                std::memory_order_acq_rel,
+                                                std::memory_order_acquire)) {
+                    m_ranges[worker].range.store(pack(last - half, last),
+                                                 std::memory_order_release);
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    void work(int worker) noexcept
+    {
+        int begin, end;
+
+        for (;;) {
+            while (pop_front(worker, begin, end))
+                m_job(m_context, begin, end);
+
+            if (!steal(worker))
+                return;
+        }
+    }
+
+    void run(int worker) noexcept
+    {
+        unsigned seen = 0;
+
+        for (;;) {
+            int spin = 0;
+            while (m_generation.load(std::memory_order_acquire) == seen &&
+                   !m_stop.load(std::memory_order_acquire)) {
+                if (++spin < spin_before_sleep) {
+                    std::this_thread::yield();
+                } else {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_sleeping.fetch_add(1);
+                    m_condition.wait(lock, [this, seen]() {
+                        return m_generation.load() != seen || m_stop.load();
+                    });
+                    m_sleeping.fetch_sub(1);
+                }
+            }
+
+            if (m_stop.load(std::memory_order_acquire))
+                return;
+
+            seen = m_generation.load(std::memory_order_acquire);
+            work(worker);
+            m_running.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    void wake_up() noexcept
+    {
+        if (m_sleeping.load() > 0) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_condition.notify_all();
+        }
+    }
+
+public:
+    /**
+     * @brief Starts the workers.
+     *
+     * @param workers The number of workers including the calling thread.
+     * If less than 1, use the number of hardware threads.
+     */
+    explicit thread_pool(int workers = 0)
+    {
+        if (workers < 1)
+            workers = static_cast<int>(std::thread::hardware_concurrency());
+
+        m_size = workers < 1 ? 1 : workers;
+        m_ranges = std::make_unique<worker_range[]>(m_size);
+
+        m_threads.reserve(m_size - 1);
+        for (int i = 1; i < m_size; ++i)
+            m_threads.emplace_back([this, i]() { run(i); });
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    ~thread_pool() noexcept
+    {
+        m_stop.store(true);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_condition.notify_all();
+        }
+
+        for (auto& thread : m_threads)
+            thread.join();
+    }
+
+    int size() const noexcept
+    {
+        return m_size;
+    }
+
+    /**
+     * @brief Calls @c fct(begin, end) on disjoint sub-ranges covering
+     * [first, last[ and returns when all calls are finished.
+     *
+     * @param grain The maximum length of a sub-range, if less than 1 a
+     * length is computed from the number of workers.
+     */
+    template<typename Function>
+    void parallel_for_range(int first, int last, int grain, Function&& fct)
+    {
+        const auto length = last - first;
+        if (length <= 0)
+            return;
+
+        if (grain < 1)
+            grain = length / (m_size * 8) > 1 ? length / (m_size * 8) : 1;
+
+        if (m_size == 1 || length <= grain) {
+            fct(first, last);
+            return;
+        }
+
+        using function_type = typename std::remove_reference<Function>::type;
+
+        m_job = [](void* context, int begin, int end) {
+            (*static_cast<function_type*>(context))(begin, end);
+        };
+        m_context = const_cast<void*>(static_cast<const void*>(&fct));
+        m_grain = grain;
+
+        for (int i = 0; i != m_size; ++i) {
+            const auto begin = first + static_cast<int>(
+                                         static_cast<std::int64_t>(length) *
+                                         i / m_size);
+            const auto end = first + static_cast<int>(
+                                       static_cast<std::int64_t>(length) *
+                                       (i + 1) / m_size);
+            m_ranges[i].range.store(pack(begin, end),
+                                    std::memory_order_relaxed);
+        }
+
+        m_running.store(m_size - 1, std::memory_order_relaxed);
+        m_generation.fetch_add(1);
+        wake_up();
+
+        work(0);
+
+        while (m_running.load(std::memory_order_acquire) != 0)
+            std::this_thread::yield();
+
+        m_job = nullptr;
+        m_context = nullptr;
+    }
+
+    /**
+     * @brief Calls @c fct(i) for each i in [first, last[ and returns when
+     * all calls are finished.
+     */
+    template<typename Function>
+    void parallel_for(int first, int last, Function&& fct)
+    {
+        parallel_for_range(first, last, 0, [&fct](int begin, int end) {
+            for (int i = begin; i != end; ++i)
+                fct(i);
+        });
+    }
+};
+
+/**
+ * @brief A barrier for a fixed number of threads that spin while waiting.
+ * @details The last thread to arrive releases the others by incrementing
+ * the phase. The writes of all threads before the barrier are visible to
+ * all threads after the barrier.
+ */
+class spin_barrier
+{
+    alignas(64) std::atomic<int> m_count{ 1 };
+    alignas(64) std::atomic<unsigned> m_phase{ 0 };
+    int m_size = 1;
+
+public:
+    explicit spin_barrier(int size = 1) noexcept
+      : m_count(size)
+      , m_size(size)
+    {
+        assert(size > 0);
+    }
+
+    spin_barrier(const spin_barrier&) = delete;
+    spin_barrier& operator=(const spin_barrier&) = delete;
+
+    /**
+     * @brief Reset the barrier. No thread may be waiting.
+     */
+    void init(int size) noexcept
+    {
+        assert(size > 0);
+
+        m_size = size;
+        m_count.store(size);
+    }
+
+    int size() const noexcept
+    {
+        return m_size;
+    }
+
+    /**
+     * @brief Wait for the other threads, @c idle() is called in loop until
+     * the last thread arrives.
+     */
+    template<typename Function>
+    void wait(Function&& idle)
+    {
+        const auto phase = m_phase.load(std::memory_order_acquire);
+
+        if (m_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            m_count.store(m_size, std::memory_order_relaxed);
+            m_phase.fetch_add(1, std::memory_order_acq_rel);
+            return;
+        }
+
+        while (m_phase.load(std::memory_order_acquire) == phase)
+            idle();
+    }
+
+    void wait()
+    {
+        wait([]() { std::this_thread::yield(); });
+    }
+};
+
+} // namespace irr
+
+#endif // ORG_VLEPROJECT_IRRITATOR_THREAD_POOL_HPP
@@ -0,0 +1,183 @@
+// Copyright (c) 2019 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef ORG_VLEPROJECT_IRRITATOR_TIME_HPP
+#define ORG_VLEPROJECT_IRRITATOR_TIME_HPP
+
+#include <limits>
+
+#include <cmath>
+#include <cstdint>
+
+namespace irr {
+
+/**
+ * @brief A fixed-point time: an integer number of ticks, @c TicksPerUnit
+ * ticks for a unit of time.
+ * @details Additions and comparisons are exact, times computed by
+ * different paths are equal if they round to the same tick. The largest
+ * number of ticks is the infinity: adding to it or converting a too large
+ * or NaN real gives the infinity.
+ *
+ * Like @c float and @c double, a @c fixed_time is built from a real and
+ * converted to a real with @c static_cast.
+ *
+ * @code
+ * using microseconds = irr::fixed_time<1000000>;
+ * auto t = static_cast<microseconds>(0.1) + static_cast<microseconds>(0.2);
+ * assert(t == static_cast<microseconds>(0.3));
+ * @endcode
+ */
+template<std::int64_t TicksPerUnit>
+struct fixed_time
+{
+    static_assert(TicksPerUnit > 0, "TicksPerUnit must be positive");
+
+    static constexpr std::int64_t ticks_per_unit = TicksPerUnit;
+    static constexpr std::int64_t infinity_ticks =
+      std::numeric_limits<std::int64_t>::max();
+
+    std::int64_t ticks = 0;
+
+    constexpr fixed_time() noexcept = default;
+
+    /// Rounds the real to the nearest tick.
+    explicit fixed_time(double real) noexcept
+    {
+        const auto scaled = real * static_cast<double>(TicksPerUnit);
+
+        // 2^63 is the first double out of the range of std::int64_t.
+        if (!(scaled < 9223372036854775808.0))
+            ticks = infinity_ticks;
+        else if (scaled < -9223372036854775808.0)
+            ticks = -infinity_ticks;
+        else
+            ticks = std::llround(scaled);
+    }
+
+    static constexpr fixed_time from_ticks(std::int64_t ticks) noexcept
+    {
+        fixed_time ret;
+        ret.ticks = ticks;
+        return ret;
+    }
+
+    explicit operator double() const noexcept
+    {
+        if (ticks == infinity_ticks)
+            return std::numeric_limits<double>::infinity();
+
+        return static_cast<double>(ticks) / static_cast<double>(TicksPerUnit);
+    }
+
+    explicit operator float() const noexcept
+    {
+        return static_cast<float>(static_cast<double>(*this));
+    }
+
+    constexpr fixed_time operator+(fixed_time other) const noexcept
+    {
+        if (ticks == infinity_ticks || other.ticks == infinity_ticks ||
+            (other.ticks > 0 && ticks > infinity_ticks - 1 - other.ticks))
+            return from_ticks(infinity_ticks);
+
+        return from_ticks(ticks + other.ticks);
+    }
+
+    constexpr fixed_time operator-(fixed_time other) const noexcept
+    {
+        if (ticks == infinity_ticks)
+            return from_ticks(infinity_ticks);
+
+        return from_ticks(ticks - other.ticks);
+    }
+
+    constexpr fixed_time& operator+=(fixed_time other) noexcept
+    {
+        return *this = *this + other;
+    }
+
+    constexpr fixed_time& operator-=(fixed_time other) noexcept
+    {
+        return *this = *this - other;
+    }
+
+    constexpr bool operator==(fixed_time other) const noexcept
+    {
+        return ticks == other.ticks;
+    }
+
+    constexpr bool operator!=(fixed_time other) const noexcept
+    {
+        return ticks != other.ticks;
+    }
+
+    constexpr bool operator<(fixed_time other) const noexcept
+    {
+        return ticks < other.ticks;
+    }
+
+    constexpr bool operator<=(fixed_time other) const noexcept
+    {
+        return ticks <= other.ticks;
+    }
+
+    constexpr bool operator>(fixed_time other) const noexcept
+    {
+        return ticks > other.ticks;
+    }
+
+    constexpr bool operator>=(fixed_time other) const noexcept
+    {
+        return ticks >= other.ticks;
+    }
+};
+
+} // namespace irr
+
+namespace std {
+
+// The schedulers and the engines use numeric_limits<Time>::infinity() for
+// a passive simulator.
+template<std::int64_t TicksPerUnit>
+class numeric_limits<irr::fixed_time<TicksPerUnit>>
+{
+    using time = irr::fixed_time<TicksPerUnit>;
+
+public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr bool is_integer = false;
+    static constexpr bool is_exact = true;
+    static constexpr bool has_infinity = true;
+
+    static constexpr time min() noexcept
+    {
+        return time::from_ticks(1);
+    }
+
+    static constexpr time lowest() noexcept
+    {
+        return time::from_ticks(-time::infinity_ticks);
+    }
+
+    static constexpr time max() noexcept
+    {
+        return time::from_ticks(time::infinity_ticks - 1);
+    }
+
+    static constexpr time epsilon() noexcept
+    {
+        return time::from_ticks(1);
+    }
+
+    static constexpr time infinity() noexcept
+    {
+        return time::from_ticks(time::infinity_ticks);
+    }
+};
+
+} // namespace std
+
+#endif // ORG_VLEPROJECT_IRRITATOR_TIME_HPP
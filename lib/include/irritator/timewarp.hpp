@@ -0,0 +1,133 @@
+// Copyright (c) 2019 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef ORG_VLEPROJECT_IRRITATOR_TIMEWARP_HPP
+#define ORG_VLEPROJECT_IRRITATOR_TIMEWARP_HPP
+
+#include <irritator/simulation.hpp>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <cstdint>
+
+namespace irr {
+
+struct TimeWarpStatistics
+{
+    std::uint64_t steps = 0;             // processed bags, rolled back too
+    std::uint64_t rollbacks = 0;         // number of rollbacks
+    std::uint64_t rolled_back_steps = 0; // bags undone by the rollbacks
+    std::uint64_t fossil_steps = 0;      // bags committed below the GVT
+    std::uint64_t messages = 0;          // messages between partitions
+    std::uint64_t anti_messages = 0;     // cancelled messages
+    std::uint64_t gvt_rounds = 0;        // GVT computations
+};
+
+// Defined in timewarp.cpp.
+struct timewarp_partition;
+
+/**
+ * @brief An optimistic parallel engine for a @c FlatSimulation.
+ * @details The simulators are dispatched on partitions, one thread per
+ * partition. Each partition runs its own bags as soon as possible without
+ * waiting for the other partitions. A message received from another
+ * partition with a time lower than or equal to the last processed bag
+ * (a straggler) rolls back the partition: the states of the simulators are
+ * restored with the @c AtomicDynamics::restore function and anti-messages
+ * cancel the messages sent by the undone bags that the new execution does
+ * not send again (lazy cancellation).
+ *
+ * Before a transition, only the state of the transitioned simulator is
+ * saved. The global virtual time (GVT), the lower bound of the time of any
+ * future rollback, is computed asynchronously with the shared memory
+ * algorithm of Fujimoto and Hybinette: the bags below the GVT are
+ * committed and their saved states released (fossil collection).
+ *
+ * Partitions exchange messages with a lock-free queue for each pair of
+ * connected partitions. The messages are limited to @c payload reals, the
+ * application aborts if a simulator sends a longer vector to another
+ * partition.
+ *
+ * @code
+ * irr::TimeWarp tw;
+ * if (tw.initialize(flat, 4, 0.f, 100.f))
+ *     tw.run();
+ * @endcode
+ *
+ * After @c run, the simulators of @c flat hold the state at the @c end
+ * time, the same state as the sequential @c FlatSimulation::run.
+ */
+struct TimeWarp
+{
+    static constexpr int payload = 4;
+
+    FlatSimulation* flat = nullptr;
+    float start = 0.f;
+    float end = 0.f;
+
+    /// The number of loops of the first partition between two GVT
+    /// computations.
+    int gvt_interval = 16;
+
+    /// The partition of each simulator, indexed by @c model_index(ID).
+    std::vector<int> owner;
+    std::vector<std::unique_ptr<timewarp_partition>> partitions;
+
+    std::vector<float> local_minimum;
+    std::atomic<float> gvt{ 0.f };
+    std::atomic<unsigned> gvt_round{ 0 };
+    std::atomic<int> gvt_remaining{ 0 };
+    std::atomic<bool> gvt_active{ false };
+    std::atomic<bool> done{ false };
+
+    TimeWarp() noexcept;
+    ~TimeWarp() noexcept;
+
+    TimeWarp(const TimeWarp&) = delete;
+    TimeWarp& operator=(const TimeWarp&) = delete;
+
+    /**
+     * @brief Dispatch the simulators on @c partition_number partitions by
+     * contiguous blocks and initialize them at the @c start time.
+     *
+     * @param queue_capacity The capacity, a power of two, of the queue of
+     * messages between two partitions.
+     *
+     * @return false if a simulator does not have dynamics or if a
+     * parameter is invalid.
+     */
+    bool initialize(FlatSimulation& flat,
+                    int partition_number,
+                    float start,
+                    float end,
+                    int queue_capacity = 1024);
+
+    /**
+     * @brief Same as above with a user partition: @c owner[model_index(id)]
+     * is the partition of the simulator @c id.
+     */
+    bool initialize(FlatSimulation& flat,
+                    const std::vector<int>& owner,
+                    int partition_number,
+                    float start,
+                    float end,
+                    int queue_capacity = 1024);
+
+    /**
+     * @brief Run the simulation until the @c end time, the calling thread
+     * runs the first partition.
+     */
+    void run();
+
+    /**
+     * @brief Sum of the statistics of the partitions.
+     */
+    TimeWarpStatistics statistics() const noexcept;
+};
+
+} // namespace irr
+
+#endif // ORG_VLEPROJECT_IRRITATOR_TIMEWARP_HPP
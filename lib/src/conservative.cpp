@@ -0,0 +1,500 @@
+// Copyright (c) 2019 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <irritator/conservative.hpp>
+#include <irritator/spsc-queue.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include <cassert>
+#include <cstdlib>
+
+namespace irr {
+
+namespace {
+
+constexpr float infinity = std::numeric_limits<float>::infinity();
+
+struct conservative_message
+{
+    float time;
+    ID destination;
+    ID source;
+    int slot;
+    int size;
+    double data[Conservative::payload];
+};
+
+} // anonymous namespace
+
+struct conservative_partition
+{
+    Conservative& engine;
+    FlatSimulation& flat;
+    const int id;
+
+    /// The queues of messages from the other partitions indexed by sender,
+    /// nullptr if the sender has no route to this partition.
+    std::vector<std::unique_ptr<spsc_queue<conservative_message>>> queues;
+
+    heap<float, ID, model_id_split> events;
+    std::multimap<float, conservative_message> pending;
+
+    Values values;
+    std::vector<ID> imminent;
+    std::vector<OutputMessage> outputs;
+    std::vector<InputMessage> inputs;
+    std::vector<FlatSimulation::Transition> transitions;
+    std::vector<std::uint32_t> imminent_stamp;
+    std::vector<std::uint32_t> influenced_stamp;
+    std::uint32_t bag_number = 0;
+
+    /// The minimum lookahead of the simulators with a route to another
+    /// partition, infinity if there is none.
+    float lookahead = infinity;
+    float sent_minimum = infinity;
+
+    /// Published to the other partitions between two barriers: the time
+    /// of the next bag and the lowest time of the next message to another
+    /// partition.
+    float next = infinity;
+    float earliest_output = infinity;
+
+    ConservativeStatistics stats;
+
+    conservative_partition(Conservative& engine_, int id_) noexcept
+      : engine(engine_)
+      , flat(*engine_.flat)
+      , id(id_)
+    {}
+
+    bool init(int partition_number, int values_capacity)
+    {
+        queues.resize(partition_number);
+        imminent_stamp.assign(flat.simulators.capacity, 0);
+        influenced_stamp.assign(flat.simulators.capacity, 0);
+
+        return events.init(flat.simulators.capacity) &&
+               values.init(values_capacity);
+    }
+
+    float minimum_time() const noexcept
+    {
+        return pending.empty() ? events.tn()
+                               : std::min(events.tn(), pending.begin()->first);
+    }
+
+    void drain()
+    {
+        conservative_message msg;
+
+        for (auto& queue : queues)
+            if (queue)
+                while (queue->pop(msg))
+                    pending.emplace(msg.time, msg);
+    }
+
+    void idle()
+    {
+        drain();
+        std::this_thread::yield();
+    }
+
+    void send(const conservative_message& msg, int to)
+    {
+        auto& queue = *engine.partitions[to]->queues[id];
+
+        // If the queue is full, the receiver may itself wait for one of our
+        // queues: keep them flowing until a slot is available.
+        while (!queue.push(msg))
+            idle();
+
+        sent_minimum = std::min(sent_minimum, msg.time);
+        ++stats.messages;
+    }
+
+    /// Computes the outputs of the imminent simulators at time @c t, keeps
+    /// the messages to local simulators and sends the others.
+    void start_bag(float t)
+    {
+        if (++bag_number == 0) {
+            std::fill(imminent_stamp.begin(), imminent_stamp.end(), 0);
+            std::fill(influenced_stamp.begin(), influenced_stamp.end(), 0);
+            bag_number = 1;
+        }
+
+        imminent.clear();
+        if (events.tn() == t)
+            events.pop(imminent);
+
+        values.clear();
+        outputs.clear();
+        inputs.clear();
+
+        for (auto simulator : imminent) {
+            imminent_stamp[model_index(simulator)] = bag_number;
+
+            Outputs out(values, outputs, simulator);
+            flat.visit(flat.simulators.get(simulator),
+                       [&out](auto& dyn) { dyn.lambda(out); });
+        }
+
+        for (const auto& msg : outputs) {
+            for (const auto& route : flat.get_routes(msg.source, msg.slot)) {
+                const auto to = engine.owner[model_index(route.simulator)];
+
+                if (to == id) {
+                    inputs.push_back(InputMessage{
+                      route.simulator, msg.source, route.slot, msg.value });
+                    continue;
+                }
+
+                assert(msg.value.type == Value::value_type::real64);
+                assert(msg.value.size <= Conservative::payload);
+                if (msg.value.size > Conservative::payload)
+                    std::abort();
+
+                conservative_message remote{};
+                remote.time = t;
+                remote.destination = route.simulator;
+                remote.source = msg.source;
+                remote.slot = route.slot;
+                remote.size = msg.value.size;
+                std::copy_n(&values.real64[msg.value.index],
+                            msg.value.size,
+                            remote.data);
+
+                send(remote, to);
+            }
+        }
+    }
+
+    void transition(const FlatSimulation::Transition& tr, float t) noexcept
+    {
+        auto& sim = flat.simulators.get(tr.simulator);
+        const Bag bag(
+          inputs.data() + tr.first, inputs.data() + tr.last, values);
+        double ta;
+
+        if (tr.imminent) {
+            if (bag.empty())
+                ta = flat.visit(sim,
+                                [t](auto& dyn) { return dyn.internal(t); });
+            else
+                ta = flat.visit(sim, [t, &bag](auto& dyn) {
+                    return dyn.confluent(t, bag);
+                });
+        } else {
+            const auto e = t - sim.tl;
+            ta = flat.visit(sim, [t, e, &bag](auto& dyn) {
+                return dyn.external(t, e, bag);
+            });
+        }
+
+        sim.tl = t;
+        sim.tn = t + static_cast<float>(ta);
+    }
+
+    /// Adds the messages received from the other partitions at time @c t to
+    /// the bag and runs the transitions.
+    ///
+    /// @return false if no simulator was transitioned.
+    bool end_bag(float t)
+    {
+        while (!pending.empty() && pending.begin()->first == t) {
+            const auto& msg = pending.begin()->second;
+            auto value =
+              values.alloc_real64(msg.data[0], static_cast<int16_t>(msg.size));
+            std::copy_n(
+              msg.data + 1, msg.size - 1, &values.real64[value.index + 1]);
+
+            inputs.push_back(
+              InputMessage{ msg.destination, msg.source, msg.slot, value });
+            pending.erase(pending.begin());
+        }
+
+        // Same order as the sequential engine. The messages of a source come
+        // through a same queue in the order of emission.
+        std::stable_sort(
+          inputs.begin(),
+          inputs.end(),
+          [](const InputMessage& lhs, const InputMessage& rhs) {
+              const auto lhs_dst = model_index(lhs.destination);
+              const auto rhs_dst = model_index(rhs.destination);
+
+              return lhs_dst < rhs_dst ||
+                     (lhs_dst == rhs_dst &&
+                      model_index(lhs.source) < model_index(rhs.source));
+          });
+
+        transitions.clear();
+
+        const auto size = static_cast<int>(inputs.size());
+        for (int first = 0; first != size;) {
+            const auto simulator = inputs[first].destination;
+            auto last = first + 1;
+            while (last != size && inputs[last].destination == simulator)
+                ++last;
+
+            influenced_stamp[model_index(simulator)] = bag_number;
+            transitions.push_back(FlatSimulation::Transition{
+              simulator,
+              first,
+              last,
+              imminent_stamp[model_index(simulator)] == bag_number });
+
+            first = last;
+        }
+
+        for (auto simulator : imminent)
+            if (influenced_stamp[model_index(simulator)] != bag_number)
+                transitions.push_back(
+                  FlatSimulation::Transition{ simulator, 0, 0, true });
+
+        for (const auto& tr : transitions) {
+            transition(tr, t);
+            events.insert_or_update(tr.simulator,
+                                    flat.simulators.get(tr.simulator).tn);
+        }
+
+        return !transitions.empty();
+    }
+
+    /// The lowest time of a message to another partition after the bag
+    /// at time @c t: the next internal event or, if a message from another
+    /// partition at a time greater than @c t triggers an external
+    /// transition, @c t plus the lookahead. An infinite lookahead bounds
+    /// the external transitions only: the internal events still send.
+    float next_output(float t) const noexcept
+    {
+        if (lookahead == infinity)
+            return events.tn();
+
+        const bool has_inputs = std::any_of(
+          queues.begin(), queues.end(), [](const auto& q) { return !!q; });
+
+        return has_inputs ? std::min(events.tn(), t + lookahead)
+                          : events.tn();
+    }
+
+    void run()
+    {
+        auto wait = [this]() { engine.barrier.wait([this]() { idle(); }); };
+
+        for (;;) {
+            // The messages sent during the window may not be drained yet by
+            // their receiver: their times are published too.
+            next = std::min(minimum_time(), sent_minimum);
+            sent_minimum = infinity;
+            wait();
+
+            auto t = infinity;
+            for (const auto& partition : engine.partitions)
+                t = std::min(t, partition->next);
+
+            if (!(t < engine.end))
+                break;
+
+            if (id == 0)
+                ++stats.epochs;
+
+            // All partitions run the bag at time t: first the outputs, then
+            // the transitions.
+            drain();
+            start_bag(t);
+            wait();
+
+            drain();
+            sent_minimum = infinity;
+            if (end_bag(t))
+                ++stats.lockstep_bags;
+
+            earliest_output = next_output(t);
+            wait();
+
+            // No message lower than limit can arrive from another partition.
+            auto limit = engine.end;
+            for (const auto& partition : engine.partitions)
+                if (partition->id != id)
+                    limit = std::min(limit, partition->earliest_output);
+
+            for (;;) {
+                const auto window = minimum_time();
+                if (!(window < limit))
+                    break;
+
+                drain();
+                start_bag(window);
+                end_bag(window);
+                ++stats.window_bags;
+            }
+        }
+    }
+};
+
+Conservative::Conservative() noexcept = default;
+
+Conservative::~Conservative() noexcept = default;
+
+bool
+Conservative::initialize(FlatSimulation& flat_,
+                         int partition_number,
+                         float start_,
+                         float end_,
+                         int queue_capacity)
+{
+    if (partition_number < 1)
+        return false;
+
+    std::vector<int> owner_(flat_.simulators.capacity, 0);
+    const auto number = flat_.simulators.size();
+    int i = 0;
+
+    Simulator* sim = nullptr;
+    while (flat_.simulators.next(sim))
+        owner_[model_index(flat_.simulators.get_id(*sim))] =
+          static_cast<int>(static_cast<std::int64_t>(i++) * partition_number /
+                           number);
+
+    return initialize(
+      flat_, owner_, partition_number, start_, end_, queue_capacity);
+}
+
+bool
+Conservative::initialize(FlatSimulation& flat_,
+                         const std::vector<int>& owner_,
+                         int partition_number,
+                         float start_,
+                         float end_,
+                         int queue_capacity)
+{
+    if (partition_number < 1 || !(start_ < end_) ||
+        owner_.size() < static_cast<std::size_t>(flat_.simulators.capacity))
+        return false;
+
+    flat = &flat_;
+    start = start_;
+    end = end_;
+    owner = owner_;
+
+    // An estimate of the values of a bag of a partition, the outputs of
+    // its simulators and the messages from the other partitions: Values
+    // grows beyond.
+    int values_capacity =
+      16 + payload * static_cast<int>(flat->routes.size());
+
+    {
+        Simulator* sim = nullptr;
+        while (flat->simulators.next(sim)) {
+            if (!flat->has_dynamics(*sim))
+                return false;
+
+            const auto to = owner[model_index(flat->simulators.get_id(*sim))];
+            if (to < 0 || to >= partition_number)
+                return false;
+
+            values_capacity += 4 * sim->output_slots_number;
+        }
+    }
+
+    partitions.clear();
+    for (int i = 0; i != partition_number; ++i) {
+        partitions.emplace_back(
+          std::make_unique<conservative_partition>(*this, i));
+        if (!partitions.back()->init(partition_number, values_capacity))
+            return false;
+    }
+
+    barrier.init(partition_number);
+
+    // A queue for each pair of partitions connected by at least one route
+    // and the lookahead of the partitions.
+    {
+        Simulator* sim = nullptr;
+        while (flat->simulators.next(sim)) {
+            const auto id = flat->simulators.get_id(*sim);
+            const auto from = owner[model_index(id)];
+
+            for (int slot = 0; slot != sim->output_slots_number; ++slot) {
+                for (const auto& route : flat->get_routes(id, slot)) {
+                    const auto to = owner[model_index(route.simulator)];
+                    if (to == from)
+                        continue;
+
+                    auto& lookahead = partitions[from]->lookahead;
+                    lookahead = std::min(
+                      lookahead,
+                      static_cast<float>(flat->visit(*sim, [](auto& dyn) {
+                          return dyn.lookahead();
+                      })));
+
+                    auto& queue = partitions[to]->queues[from];
+                    if (queue)
+                        continue;
+
+                    queue =
+                      std::make_unique<spsc_queue<conservative_message>>();
+                    if (!queue->init(queue_capacity))
+                        return false;
+                }
+            }
+        }
+    }
+
+    flat->start = start;
+    flat->current = start;
+    flat->end = end;
+
+    Simulator* sim = nullptr;
+    while (flat->simulators.next(sim)) {
+        const auto id = flat->simulators.get_id(*sim);
+
+        const auto ta = flat->visit(
+          *sim, [this](auto& dyn) { return dyn.initialize(start); });
+
+        sim->tl = start;
+        sim->tn = start + static_cast<float>(ta);
+        partitions[owner[model_index(id)]]->events.insert(id, sim->tn);
+    }
+
+    return true;
+}
+
+void
+Conservative::run()
+{
+    std::vector<std::thread> threads;
+    threads.reserve(partitions.size() - 1);
+
+    for (std::size_t i = 1; i < partitions.size(); ++i)
+        threads.emplace_back([this, i]() { partitions[i]->run(); });
+
+    partitions[0]->run();
+
+    for (auto& thread : threads)
+        thread.join();
+
+    flat->current = end;
+}
+
+ConservativeStatistics
+Conservative::statistics() const noexcept
+{
+    ConservativeStatistics ret;
+
+    for (const auto& partition : partitions) {
+        ret.epochs += partition->stats.epochs;
+        ret.lockstep_bags += partition->stats.lockstep_bags;
+        ret.window_bags += partition->stats.window_bags;
+        ret.messages += partition->stats.messages;
+    }
+
+    return ret;
+}
+
+} // namespace irr
@@ -181,8 +181,11 @@ struct irr_json_handler
 
         if (stack.top().is(irr_element::conditions_array_object)) {
             auto* cnd = model.conditions.try_to_get(stack.top().id);
-            auto& value = model.integer32s.alloc(b ? 1 : 0);
-            cnd->value = model.integer32s.get_id(value);
+            auto* value = model.integer32s.try_alloc(b ? 1 : 0);
+            if (!value)
+                return false;
+
+            cnd->value = model.integer32s.get_id(*value);
             cnd->type = irr::Condition::condition_type::integer32;
         }
 
@@ -196,8 +199,11 @@ struct irr_json_handler
 
         if (stack.top().is(irr_element::conditions_array_object)) {
             auto* cnd = model.conditions.try_to_get(stack.top().id);
-            auto& value = model.integer32s.alloc(i);
-            cnd->value = model.integer32s.get_id(value);
+            auto* value = model.integer32s.try_alloc(i);
+            if (!value)
+                return false;
+
+            cnd->value = model.integer32s.get_id(*value);
             cnd->type = irr::Condition::condition_type::integer32;
         }
 
@@ -218,8 +224,11 @@ struct irr_json_handler
                 model.version_patch = static_cast<int>(u);
         } else if (stack.top().is(irr_element::conditions_array_object)) {
             auto* cnd = model.conditions.try_to_get(stack.top().id);
-            auto& value = model.integer32s.alloc(u);
-            cnd->value = model.integer32s.get_id(value);
+            auto* value = model.integer32s.try_alloc(u);
+            if (!value)
+                return false;
+
+            cnd->value = model.integer32s.get_id(*value);
             cnd->type = irr::Condition::condition_type::integer32;
         }
 
@@ -233,8 +242,11 @@ struct irr_json_handler
 
         if (stack.top().is(irr_element::conditions_array_object)) {
             auto* cnd = model.conditions.try_to_get(stack.top().id);
-            auto& value = model.integer64s.alloc(i);
-            cnd->value = model.integer64s.get_id(value);
+            auto* value = model.integer64s.try_alloc(i);
+            if (!value)
+                return false;
+
+            cnd->value = model.integer64s.get_id(*value);
             cnd->type = irr::Condition::condition_type::integer64;
         }
 
@@ -248,8 +260,11 @@ struct irr_json_handler
 
         if (stack.top().is(irr_element::conditions_array_object)) {
             auto* cnd = model.conditions.try_to_get(stack.top().id);
-            auto& value = model.integer64s.alloc(u);
-            cnd->value = model.integer64s.get_id(value);
+            auto* value = model.integer64s.try_alloc(u);
+            if (!value)
+                return false;
+
+            cnd->value = model.integer64s.get_id(*value);
             cnd->type = irr::Condition::condition_type::integer64;
         }
 
@@ -263,8 +278,11 @@ struct irr_json_handler
 
         if (stack.top().is(irr_element::conditions_array_object)) {
             auto* cnd = model.conditions.try_to_get(stack.top().id);
-            auto& value = model.real64s.alloc(d);
-            cnd->value = model.real64s.get_id(value);
+            auto* value = model.real64s.try_alloc(d);
+            if (!value)
+                return false;
+
+            cnd->value = model.real64s.get_id(*value);
             cnd->type = irr::Condition::condition_type::real64;
         }
 
@@ -293,8 +311,11 @@ struct irr_json_handler
             model.author = str;
         } else if (stack.top().is(irr_element::conditions_array_object)) {
             auto* cnd = model.conditions.try_to_get(stack.top().id);
-            auto& value = model.strings.alloc(str, length);
-            cnd->value = model.strings.get_id(value);
+            auto* value = model.strings.try_alloc(str, length);
+            if (!value)
+                return false;
+
+            cnd->value = model.strings.get_id(*value);
             cnd->type = irr::Condition::condition_type::string;
         } else if (stack.top().is(
                      irr_element::views_array_object_array_options_array)) {
@@ -331,14 +352,17 @@ struct irr_json_handler
                     break;
 
             if (cnd) {
-                view->conditions.push_back(model.links,
+                view->conditions.push_back(model.chunks,
                                            model.conditions.get_id(*cnd));
                 return true;
             } else {
                 info(context, "unknown condition {} - adding it", str);
-                auto& condition = model.conditions.alloc(str);
-                auto id = model.conditions.get_id(condition);
-                view->conditions.push_back(model.links, id);
+                auto* condition = model.conditions.try_alloc(str);
+                if (!condition)
+                    return false;
+
+                auto id = model.conditions.get_id(*condition);
+                view->conditions.push_back(model.chunks, id);
             }
         }
 
@@ -363,14 +387,20 @@ struct irr_json_handler
             else if (!strncmp(str, "views", length))
                 stack.emplace(irr_element::views);
         } else if (stack.top().is(irr_element::conditions_array_object)) {
-            auto& condition = model.conditions.alloc(str);
-            auto id = model.conditions.get_id(condition);
-            std::cout << "read condition " << condition.name.data() << '\n';
+            auto* condition = model.conditions.try_alloc(str);
+            if (!condition)
+                return false;
+
+            auto id = model.conditions.get_id(*condition);
+            std::cout << "read condition " << condition->name.data() << '\n';
             stack.top().id = id;
         } else if (stack.top().is(irr_element::views_array_object)) {
-            auto& view = model.views.alloc(str);
-            auto id = model.views.get_id(view);
-            std::cout << "read view " << view.name.data() << '\n';
+            auto* view = model.views.try_alloc(str);
+            if (!view)
+                return false;
+
+            auto id = model.views.get_id(*view);
+            std::cout << "read view " << view->name.data() << '\n';
             stack.top().id = id;
         } else if (stack.top().is(irr_element::views_array_object_array)) {
             if (!strncmp(str, "options", length)) {
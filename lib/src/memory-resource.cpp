@@ -0,0 +1,236 @@
+// Copyright (c) 2019 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <irritator/memory-resource.hpp>
+
+#include <new>
+
+#include <cstdint>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#endif
+
+namespace irr {
+
+namespace {
+
+constexpr std::size_t system_page_size = 4096;
+
+std::size_t
+round_up(std::size_t bytes, std::size_t alignment) noexcept
+{
+    return (bytes + alignment - 1) & ~(alignment - 1);
+}
+
+#if defined(__linux__)
+
+// Maps @c length bytes (a multiple of the huge page size) starting on a
+// huge page boundary: the mapping is one huge page longer and the head and
+// the tail are unmapped.
+void*
+map_aligned(std::size_t length) noexcept
+{
+    const auto total = length + huge_page_size;
+    auto* p = ::mmap(nullptr,
+                     total,
+                     PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS,
+                     -1,
+                     0);
+    if (p == MAP_FAILED)
+        return nullptr;
+
+    const auto address = reinterpret_cast<std::uintptr_t>(p);
+    const auto begin = round_up(address, huge_page_size);
+    const auto head = begin - address;
+    const auto tail = total - head - length;
+
+    if (head)
+        ::munmap(p, head);
+    if (tail)
+        ::munmap(reinterpret_cast<void*>(begin + length), tail);
+
+    return reinterpret_cast<void*>(begin);
+}
+
+void*
+map_system_pages(std::size_t length) noexcept
+{
+    auto* p = ::mmap(nullptr,
+                     length,
+                     PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS,
+                     -1,
+                     0);
+
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+void*
+map_explicit_huge_pages(std::size_t length) noexcept
+{
+    auto* p = ::mmap(nullptr,
+                     length,
+                     PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB,
+                     -1,
+                     0);
+
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+// The glibc has no wrapper for mbind (libnuma has one): the system call
+// is used directly.
+void
+set_policy(void* p,
+           std::size_t length,
+           numa_policy policy,
+           std::uint64_t nodes) noexcept
+{
+    if (policy == numa_policy::first_touch || nodes == 0u)
+        return;
+
+    const unsigned long mask = static_cast<unsigned long>(nodes);
+    const int mode = policy == numa_policy::bind ? MPOL_BIND : MPOL_INTERLEAVE;
+
+    ::syscall(SYS_mbind, p, length, mode, &mask, sizeof(mask) * 8 + 1, 0);
+}
+
+// Writes a byte by system page with the workers of the pool: each worker
+// touches a contiguous range of the block, in the split used by
+// parallel_for.
+void
+touch(thread_pool& pool, void* p, std::size_t length) noexcept
+{
+    auto* bytes = static_cast<volatile char*>(p);
+    const auto pages = static_cast<int>(length / system_page_size);
+
+    pool.parallel_for_range(0, pages, 0, [bytes](int begin, int end) {
+        for (int i = begin; i != end; ++i)
+            bytes[static_cast<std::size_t>(i) * system_page_size] = 0;
+    });
+}
+
+#endif
+
+} // anonymous namespace
+
+page_memory_resource::page_memory_resource(
+  huge_pages pages,
+  numa_policy policy,
+  std::uint64_t nodes,
+  thread_pool* pool,
+  std::size_t threshold,
+  std::pmr::memory_resource* upstream) noexcept
+  : m_upstream(upstream)
+  , m_pool(pool)
+  , m_threshold(threshold)
+  , m_nodes(nodes)
+  , m_pages(pages)
+  , m_policy(policy)
+{}
+
+bool
+page_memory_resource::is_mapped(std::size_t bytes,
+                                std::size_t alignment) const noexcept
+{
+#if defined(__linux__)
+    const auto page = m_pages == huge_pages::none ? system_page_size
+                                                  : huge_page_size;
+
+    return bytes > 0 && bytes >= m_threshold && alignment <= page;
+#else
+    (void)bytes;
+    (void)alignment;
+
+    return false;
+#endif
+}
+
+void*
+page_memory_resource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    if (!is_mapped(bytes, alignment))
+        return m_upstream->allocate(bytes, alignment);
+
+#if defined(__linux__)
+    void* p = nullptr;
+    std::size_t length;
+
+    if (m_pages == huge_pages::none) {
+        length = round_up(bytes, system_page_size);
+        p = map_system_pages(length);
+    } else {
+        length = round_up(bytes, huge_page_size);
+
+        if (m_pages == huge_pages::explicit_2mb) {
+            p = map_explicit_huge_pages(length);
+            if (!p)
+                m_fallbacks.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (!p) {
+            p = map_aligned(length);
+            if (p)
+                ::madvise(p, length, MADV_HUGEPAGE);
+        }
+    }
+
+    if (!p)
+        throw std::bad_alloc();
+
+    // The policy applies to the pages not yet touched: set it before the
+    // first write.
+    set_policy(p, length, m_policy, m_nodes);
+
+    if (m_policy == numa_policy::first_touch && m_pool)
+        touch(*m_pool, p, length);
+
+    m_mapped.fetch_add(length, std::memory_order_relaxed);
+
+    return p;
+#else
+    return nullptr;
+#endif
+}
+
+void
+page_memory_resource::do_deallocate(void* p,
+                                    std::size_t bytes,
+                                    std::size_t alignment)
+{
+    if (!is_mapped(bytes, alignment)) {
+        m_upstream->deallocate(p, bytes, alignment);
+        return;
+    }
+
+#if defined(__linux__)
+    const auto length = round_up(
+      bytes, m_pages == huge_pages::none ? system_page_size : huge_page_size);
+
+    ::munmap(p, length);
+    m_mapped.fetch_sub(length, std::memory_order_relaxed);
+#endif
+}
+
+bool
+page_memory_resource::do_is_equal(
+  const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+} // namespace irr
@@ -0,0 +1,384 @@
+// Copyright (c) 2019 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <irritator/simulation.hpp>
+
+#include <cmath>
+#include <limits>
+
+#if defined(__AVX512F__)
+#define IRRITATOR_KERNEL_WIDTH 8
+#elif defined(__AVX2__)
+#define IRRITATOR_KERNEL_WIDTH 4
+#else
+#define IRRITATOR_KERNEL_WIDTH 1
+#endif
+
+#if IRRITATOR_KERNEL_WIDTH > 1
+#include <immintrin.h>
+#endif
+
+namespace irr {
+
+namespace {
+
+constexpr int width = IRRITATOR_KERNEL_WIDTH;
+
+// The kernels process @c width integrators at once: the columns are read
+// with gathers from the column indices of the batch and written back with
+// scatters (a loop of scalar stores for AVX2). The operations are the same
+// as the scalar functions of the integrators, the remaining integrators of
+// a batch use them.
+
+#if IRRITATOR_KERNEL_WIDTH == 8
+
+using real = __m512d;
+using mask = __mmask8;
+using index = __m256i;
+
+inline index
+load_index(const int* columns) noexcept
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(columns));
+}
+
+inline real
+gather(const double* column, index i) noexcept
+{
+    return _mm512_i32gather_pd(i, column, 8);
+}
+
+inline void
+scatter(double* column, index i, real value) noexcept
+{
+    _mm512_i32scatter_pd(column, i, value, 8);
+}
+
+inline real
+set1(double value) noexcept
+{
+    return _mm512_set1_pd(value);
+}
+
+inline real
+add(real a, real b) noexcept
+{
+    return _mm512_add_pd(a, b);
+}
+
+inline real
+sub(real a, real b) noexcept
+{
+    return _mm512_sub_pd(a, b);
+}
+
+inline real
+mul(real a, real b) noexcept
+{
+    return _mm512_mul_pd(a, b);
+}
+
+inline real
+div(real a, real b) noexcept
+{
+    return _mm512_div_pd(a, b);
+}
+
+inline real
+sqrt(real a) noexcept
+{
+    return _mm512_sqrt_pd(a);
+}
+
+inline real
+abs(real a) noexcept
+{
+    return _mm512_abs_pd(a);
+}
+
+inline mask
+equal(real a, real b) noexcept
+{
+    return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ);
+}
+
+inline mask
+greater(real a, real b) noexcept
+{
+    return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ);
+}
+
+// Returns @c a where @c m is set, @c b otherwise.
+inline real
+select(mask m, real a, real b) noexcept
+{
+    return _mm512_mask_blend_pd(m, b, a);
+}
+
+inline void
+store(double* values, real a) noexcept
+{
+    _mm512_store_pd(values, a);
+}
+
+inline real
+load(const double* values) noexcept
+{
+    return _mm512_load_pd(values);
+}
+
+#elif IRRITATOR_KERNEL_WIDTH == 4
+
+using real = __m256d;
+using mask = __m256d;
+using index = __m128i;
+
+inline index
+load_index(const int* columns) noexcept
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(columns));
+}
+
+inline real
+gather(const double* column, index i) noexcept
+{
+    return _mm256_i32gather_pd(column, i, 8);
+}
+
+inline void
+scatter(double* column, index i, real value) noexcept
+{
+    alignas(32) double values[4];
+    alignas(16) int columns[4];
+
+    _mm256_store_pd(values, value);
+    _mm_store_si128(reinterpret_cast<__m128i*>(columns), i);
+
+    for (int k = 0; k != 4; ++k)
+        column[columns[k]] = values[k];
+}
+
+inline real
+set1(double value) noexcept
+{
+    return _mm256_set1_pd(value);
+}
+
+inline real
+add(real a, real b) noexcept
+{
+    return _mm256_add_pd(a, b);
+}
+
+inline real
+sub(real a, real b) noexcept
+{
+    return _mm256_sub_pd(a, b);
+}
+
+inline real
+mul(real a, real b) noexcept
+{
+    return _mm256_mul_pd(a, b);
+}
+
+inline real
+div(real a, real b) noexcept
+{
+    return _mm256_div_pd(a, b);
+}
+
+inline real
+sqrt(real a) noexcept
+{
+    return _mm256_sqrt_pd(a);
+}
+
+inline real
+abs(real a) noexcept
+{
+    return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a);
+}
+
+inline mask
+equal(real a, real b) noexcept
+{
+    return _mm256_cmp_pd(a, b, _CMP_EQ_OQ);
+}
+
+inline mask
+greater(real a, real b) noexcept
+{
+    return _mm256_cmp_pd(a, b, _CMP_GT_OQ);
+}
+
+// Returns @c a where @c m is set, @c b otherwise.
+inline real
+select(mask m, real a, real b) noexcept
+{
+    return _mm256_blendv_pd(b, a, m);
+}
+
+inline void
+store(double* values, real a) noexcept
+{
+    _mm256_store_pd(values, a);
+}
+
+inline real
+load(const double* values) noexcept
+{
+    return _mm256_load_pd(values);
+}
+
+#endif
+
+#if IRRITATOR_KERNEL_WIDTH > 1
+
+// No vector instruction for the cubic root: one std::cbrt by lane.
+inline real
+cbrt(real a) noexcept
+{
+    alignas(64) double values[width];
+
+    store(values, a);
+    for (int k = 0; k != width; ++k)
+        values[k] = std::cbrt(values[k]);
+
+    return load(values);
+}
+
+#endif
+
+// The scalar transitions of the integrators not processed by a kernel.
+template<typename Columns>
+void
+scalar_internal(Columns& columns, const int* indices, int number) noexcept
+{
+    for (int k = 0; k < number; ++k) {
+        auto integ = columns.load(indices[k]);
+        integ.internal(0.0);
+        columns.store(indices[k], integ);
+    }
+}
+
+} // anonymous namespace
+
+int
+integrator_kernel_width() noexcept
+{
+    return width;
+}
+
+void
+integrator_array::internal(const int* columns, int number) noexcept
+{
+    int k = 0;
+
+#if IRRITATOR_KERNEL_WIDTH > 1
+    const auto zero = set1(0.0);
+    const auto inf = set1(std::numeric_limits<double>::infinity());
+
+    for (; k + width <= number; k += width) {
+        const auto i = load_index(columns + k);
+        const auto u_ = gather(u.items, i);
+        const auto dq_ = gather(dq.items, i);
+        const auto x_ =
+          add(gather(x.items, i), mul(u_, gather(sigma.items, i)));
+
+        const auto limit =
+          select(greater(u_, zero), add(x_, dq_), sub(x_, dq_));
+        auto ta = div(sub(limit, x_), u_);
+        ta = select(greater(ta, zero), ta, zero);
+        ta = select(equal(u_, zero), inf, ta);
+
+        scatter(x.items, i, x_);
+        scatter(q.items, i, x_);
+        scatter(sigma.items, i, ta);
+    }
+#endif
+
+    scalar_internal(*this, columns + k, number - k);
+}
+
+void
+qss2_integrator_array::internal(const int* columns, int number) noexcept
+{
+    int k = 0;
+
+#if IRRITATOR_KERNEL_WIDTH > 1
+    const auto zero = set1(0.0);
+    const auto half = set1(0.5);
+    const auto two = set1(2.0);
+    const auto inf = set1(std::numeric_limits<double>::infinity());
+
+    for (; k + width <= number; k += width) {
+        const auto i = load_index(columns + k);
+        const auto s = gather(sigma.items, i);
+        const auto u_ = gather(u.items, i);
+        const auto mu_ = gather(mu.items, i);
+
+        const auto x_ = add(gather(x.items, i),
+                            mul(add(u_, mul(mul(half, mu_), s)), s));
+        const auto next_u = add(u_, mul(mu_, s));
+        const auto ta =
+          select(equal(mu_, zero),
+                 inf,
+                 sqrt(div(mul(two, gather(dq.items, i)), abs(mu_))));
+
+        scatter(x.items, i, x_);
+        scatter(q.items, i, x_);
+        scatter(u.items, i, next_u);
+        scatter(mq.items, i, next_u);
+        scatter(sigma.items, i, ta);
+    }
+#endif
+
+    scalar_internal(*this, columns + k, number - k);
+}
+
+void
+qss3_integrator_array::internal(const int* columns, int number) noexcept
+{
+    int k = 0;
+
+#if IRRITATOR_KERNEL_WIDTH > 1
+    const auto zero = set1(0.0);
+    const auto half = set1(0.5);
+    const auto two = set1(2.0);
+    const auto three = set1(3.0);
+    const auto inf = set1(std::numeric_limits<double>::infinity());
+
+    for (; k + width <= number; k += width) {
+        const auto i = load_index(columns + k);
+        const auto s = gather(sigma.items, i);
+        const auto u_ = gather(u.items, i);
+        const auto mu_ = gather(mu.items, i);
+        const auto pu_ = gather(pu.items, i);
+
+        const auto x_ = add(
+          gather(x.items, i),
+          mul(add(u_, mul(add(mul(half, mu_), mul(div(pu_, three), s)), s)),
+              s));
+        const auto next_u = add(u_, mul(add(mu_, mul(pu_, s)), s));
+        const auto next_mu = add(mu_, mul(mul(two, pu_), s));
+        const auto ta =
+          select(equal(pu_, zero),
+                 inf,
+                 cbrt(div(mul(three, gather(dq.items, i)), abs(pu_))));
+
+        scatter(x.items, i, x_);
+        scatter(q.items, i, x_);
+        scatter(u.items, i, next_u);
+        scatter(mq.items, i, next_u);
+        scatter(mu.items, i, next_mu);
+        scatter(pq.items, i, mul(half, next_mu));
+        scatter(sigma.items, i, ta);
+    }
+#endif
+
+    scalar_internal(*this, columns + k, number - k);
+}
+
+} // namespace irr
@@ -6,6 +6,11 @@
 
 #include "private.hpp"
 
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
 namespace irr {
 
 // void
@@ -488,15 +493,673 @@ Model::Model(int estimated_model_number)
     views.init(estimated_model_number);
     nodes.init(estimated_model_number);
 
-    links.init(estimated_model_number * 1024);
-    wlinks.init(estimated_model_number * 1024);
-
     integer32s.init(estimated_model_number);
     integer64s.init(estimated_model_number);
     real64s.init(estimated_model_number);
     strings.init(estimated_model_number);
 }
 
+ModelRemap
+Model::compact()
+{
+    const auto was_frozen = is_frozen;
+    if (was_frozen)
+        thaw();
+
+    ModelRemap remap;
+
+    remap.conditions = conditions.compact();
+    remap.connections = connections.compact();
+    remap.slots = slots.compact();
+    remap.views = views.compact();
+    remap.nodes = nodes.compact();
+    remap.classes = classes.compact();
+    remap.integer32s = integer32s.compact();
+    remap.integer64s = integer64s.compact();
+    remap.real32s = real32s.compact();
+    remap.real64s = real64s.compact();
+    remap.strings = strings.compact();
+
+    for (auto& node : nodes) {
+        node.parent = remap.nodes(node.parent);
+        node.conditions.remap(chunks, remap.conditions);
+        node.observables.remap(links, remap.views);
+        node.children.remap(chunks, remap.nodes);
+        node.connections.remap(chunks, remap.connections);
+    }
+
+    for (auto& cnx : connections) {
+        cnx.input_model = remap.nodes(cnx.input_model);
+        cnx.output_model = remap.nodes(cnx.output_model);
+    }
+
+    for (auto& view : views)
+        view.conditions.remap(chunks, remap.conditions);
+
+    for (auto& cls : classes)
+        cls.model = remap.nodes(cls.model);
+
+    for (auto& cnd : conditions) {
+        switch (cnd.type) {
+        case Condition::condition_type::integer32:
+            cnd.value = remap.integer32s(cnd.value);
+            break;
+        case Condition::condition_type::integer64:
+            cnd.value = remap.integer64s(cnd.value);
+            break;
+        case Condition::condition_type::real64:
+            cnd.value = remap.real64s(cnd.value);
+            break;
+        case Condition::condition_type::string:
+            cnd.value = remap.strings(cnd.value);
+            break;
+        }
+    }
+
+    if (was_frozen)
+        freeze();
+
+    return remap;
+}
+
+void
+Model::freeze()
+{
+    if (is_frozen)
+        return;
+
+    frozen_lists.clear();
+
+    // A row by index: the free entries of the arrays have empty rows.
+    for (int i = 0; i != nodes.max_used; ++i) {
+        if (!model_id_split::valid(nodes.id(i))) {
+            frozen_lists.node_conditions.push_back();
+            frozen_lists.node_observables.push_back();
+            frozen_lists.node_children.push_back();
+            frozen_lists.node_connections.push_back();
+            continue;
+        }
+
+        auto& node = nodes.value(i);
+        frozen_lists.node_conditions.push_back(node.conditions.begin(chunks),
+                                               node.conditions.end(chunks));
+        frozen_lists.node_observables.push_back(node.observables.begin(links),
+                                                node.observables.end(links));
+        frozen_lists.node_children.push_back(node.children.begin(chunks),
+                                             node.children.end(chunks));
+        frozen_lists.node_connections.push_back(node.connections.begin(chunks),
+                                                node.connections.end(chunks));
+
+        node.conditions.clear(chunks);
+        node.observables.clear(links);
+        node.children.clear(chunks);
+        node.connections.clear(chunks);
+    }
+
+    for (int i = 0; i != views.max_used; ++i) {
+        if (!model_id_split::valid(views.id(i))) {
+            frozen_lists.view_conditions.push_back();
+            continue;
+        }
+
+        auto& view = views.value(i);
+        frozen_lists.view_conditions.push_back(view.conditions.begin(chunks),
+                                               view.conditions.end(chunks));
+        view.conditions.clear(chunks);
+    }
+
+    is_frozen = true;
+}
+
+void
+Model::thaw()
+{
+    if (!is_frozen)
+        return;
+
+    for (auto& node : nodes) {
+        const auto index = model_index(nodes.get_id(node));
+        if (index >= frozen_lists.node_conditions.rows())
+            continue;
+
+        const auto conditions = frozen_lists.node_conditions[index];
+        const auto observables = frozen_lists.node_observables[index];
+        const auto children = frozen_lists.node_children[index];
+        const auto connections = frozen_lists.node_connections[index];
+
+        node.conditions.assign(chunks, conditions.begin(), conditions.end());
+        node.observables.assign(links, observables.begin(), observables.end());
+        node.children.assign(chunks, children.begin(), children.end());
+        node.connections.assign(
+          chunks, connections.begin(), connections.end());
+    }
+
+    for (auto& view : views) {
+        const auto index = model_index(views.get_id(view));
+        if (index >= frozen_lists.view_conditions.rows())
+            continue;
+
+        const auto conditions = frozen_lists.view_conditions[index];
+        view.conditions.assign(chunks, conditions.begin(), conditions.end());
+    }
+
+    frozen_lists.clear();
+    is_frozen = false;
+}
+
+namespace {
+
+/// A port of a Node in the flattening graph: an input or output slot.
+struct flat_port
+{
+    ID node;
+    int slot;
+    bool input;
+};
+
+} // anonymous namespace
+
+template<typename Time>
+status
+BasicFlatSimulation<Time>::init(Model& model)
+{
+    const auto max_node = model.nodes.max_used;
+
+    // Assigns to each input and output slot of each Node a port number.
+
+    std::vector<int> input_ports(max_node, 0);
+    std::vector<int> output_ports(max_node, 0);
+    std::vector<flat_port> ports;
+    int atomic_number = 0;
+
+    {
+        Node* node = nullptr;
+        while (model.nodes.next(node)) {
+            const auto id = model.nodes.get_id(*node);
+            const auto index = model_index(id);
+
+            input_ports[index] = static_cast<int>(ports.size());
+            for (int i = 0; i != node->input_slots_number; ++i)
+                ports.push_back(flat_port{ id, i, true });
+
+            output_ports[index] = static_cast<int>(ports.size());
+            for (int i = 0; i != node->output_slots_number; ++i)
+                ports.push_back(flat_port{ id, i, false });
+
+            if (node->type == Node::model_type::atomic)
+                ++atomic_number;
+        }
+    }
+
+    if (!simulators.init(atomic_number) || !builtins.init(atomic_number))
+        return status::simulation_flat_not_enough_memory;
+
+    // Builds the graph of connections between ports: each Connection of a
+    // coupled Node becomes an edge, the slots of coupled Node are the
+    // intermediate vertices.
+
+    std::vector<std::pair<int, int>> edges;
+
+    // The connections are read from the compressed sparse rows of a frozen
+    // Model or from the lists otherwise.
+    auto add_edges = [&](ID parent, auto&& connections) -> bool {
+        for (auto cnx_id : connections) {
+            auto* cnx = model.connections.try_to_get(cnx_id);
+            if (!cnx)
+                return false;
+
+            auto* src = model.nodes.try_to_get(cnx->output_model);
+            auto* dst = model.nodes.try_to_get(cnx->input_model);
+            if (!src || !dst)
+                return false;
+
+            const auto src_slot = static_cast<int>(cnx->output_slot);
+            const auto dst_slot = static_cast<int>(cnx->input_slot);
+            int from, to;
+
+            if (cnx->output_model == parent) {
+                if (src_slot >= src->input_slots_number)
+                    return false;
+                from = input_ports[model_index(parent)] + src_slot;
+            } else {
+                if (src->parent != parent ||
+                    src_slot >= src->output_slots_number)
+                    return false;
+                from = output_ports[model_index(cnx->output_model)] + src_slot;
+            }
+
+            if (cnx->input_model == parent) {
+                if (dst_slot >= dst->output_slots_number)
+                    return false;
+                to = output_ports[model_index(parent)] + dst_slot;
+            } else {
+                if (dst->parent != parent ||
+                    dst_slot >= dst->input_slots_number)
+                    return false;
+                to = input_ports[model_index(cnx->input_model)] + dst_slot;
+            }
+
+            edges.emplace_back(from, to);
+        }
+
+        return true;
+    };
+
+    {
+        Node* node = nullptr;
+        while (model.nodes.next(node)) {
+            if (node->type != Node::model_type::coupled)
+                continue;
+
+            const auto parent = model.nodes.get_id(*node);
+            const auto success =
+              model.frozen()
+                ? add_edges(parent, model.connections_of(*node))
+                : add_edges(parent, node->connections(model.chunks));
+
+            if (!success)
+                return status::simulation_flat_bad_connection;
+        }
+    }
+
+    const auto port_number = static_cast<int>(ports.size());
+    std::vector<int> edge_offsets(port_number + 1, 0);
+    std::vector<int> edge_targets(edges.size());
+
+    for (const auto& edge : edges)
+        ++edge_offsets[edge.first + 1];
+
+    for (int i = 0; i != port_number; ++i)
+        edge_offsets[i + 1] += edge_offsets[i];
+
+    {
+        std::vector<int> fill(edge_offsets.begin(), edge_offsets.end() - 1);
+        for (const auto& edge : edges)
+            edge_targets[fill[edge.first]++] = edge.second;
+    }
+
+    // Allocates the simulators and maps each atomic Node to its simulator.
+
+    std::vector<ID> node_to_simulator(max_node, 0);
+
+    {
+        Node* node = nullptr;
+        while (model.nodes.next(node)) {
+            if (node->type != Node::model_type::atomic)
+                continue;
+
+            auto* ptr = simulators.try_alloc();
+            if (!ptr)
+                return status::simulation_flat_not_enough_memory;
+
+            auto& sim = *ptr;
+            sim.dynamics = node->dynamics;
+            sim.node = model.nodes.get_id(*node);
+            sim.atomic = nullptr;
+            sim.type = dynamics_type::external;
+            sim.builtin = 0;
+            sim.input_slots_number = node->input_slots_number;
+            sim.output_slots_number = node->output_slots_number;
+            sim.tl = Time{};
+            sim.tn = std::numeric_limits<Time>::infinity();
+
+            node_to_simulator[model_index(sim.node)] = simulators.get_id(sim);
+        }
+    }
+
+    // For each output slot of each simulator, walks the graph through the
+    // slots of the coupled Node until reaching input slots of atomic Node.
+    // The stamp prevents cycle and duplicated routes.
+
+    output_rows.assign(simulators.capacity, 0);
+    route_offsets.clear();
+    routes.clear();
+
+    std::vector<int> stamp(port_number, -1);
+    std::vector<int> stack;
+    int row = 0;
+
+    {
+        simulator_type* sim = nullptr;
+        while (simulators.next(sim)) {
+            output_rows[model_index(simulators.get_id(*sim))] = row;
+
+            for (int slot = 0; slot != sim->output_slots_number; ++slot) {
+                route_offsets.push_back(static_cast<int>(routes.size()));
+
+                const auto first = output_ports[model_index(sim->node)] + slot;
+                stack.push_back(first);
+                stamp[first] = row;
+
+                while (!stack.empty()) {
+                    const auto port = stack.back();
+                    stack.pop_back();
+
+                    for (int e = edge_offsets[port];
+                         e != edge_offsets[port + 1];
+                         ++e) {
+                        const auto next = edge_targets[e];
+                        if (stamp[next] == row)
+                            continue;
+
+                        stamp[next] = row;
+                        const auto& target = ports[next];
+                        const auto& node = model.nodes.get(target.node);
+
+                        if (node.type == Node::model_type::atomic) {
+                            if (target.input)
+                                routes.push_back(Route{
+                                  node_to_simulator[model_index(target.node)],
+                                  target.slot });
+                        } else {
+                            stack.push_back(next);
+                        }
+                    }
+                }
+
+                ++row;
+            }
+        }
+    }
+
+    route_offsets.push_back(static_cast<int>(routes.size()));
+
+    this->model = 0;
+
+    {
+        Node* node = nullptr;
+        while (model.nodes.next(node)) {
+            if (node->parent == 0) {
+                this->model = model.nodes.get_id(*node);
+                break;
+            }
+        }
+    }
+
+    start = Time{};
+    current = Time{};
+    end = std::numeric_limits<Time>::infinity();
+
+    return status::simulation_flat_success;
+}
+
+template<typename Time>
+bool
+BasicFlatSimulation<Time>::initialize(Time start_,
+                                      Time end_,
+                                      scheduler_type type)
+{
+    // An estimate of the values of a bag, Values grows beyond.
+    int values_capacity = 16;
+
+    {
+        simulator_type* sim = nullptr;
+        while (simulators.next(sim)) {
+            if (!has_dynamics(*sim))
+                return false;
+
+            values_capacity += 4 * sim->output_slots_number;
+        }
+    }
+
+    if (!events.init(simulators.capacity, type))
+        return false;
+
+    if (!values.init(values_capacity))
+        return false;
+
+    imminent_stamp.assign(simulators.capacity, 0);
+    influenced_stamp.assign(simulators.capacity, 0);
+    bag_number = 0;
+
+    start = start_;
+    current = start_;
+    end = end_;
+
+    // The dynamics work with double times.
+    const auto t = static_cast<double>(start);
+
+    simulator_type* sim = nullptr;
+    while (simulators.next(sim)) {
+        const auto ta =
+          visit(*sim, [t](auto& dyn) { return dyn.initialize(t); });
+
+        sim->tl = start;
+        sim->tn = start + static_cast<Time>(ta);
+        events.insert(simulators.get_id(*sim), sim->tn);
+    }
+
+    return true;
+}
+
+template<typename Time>
+bool
+BasicFlatSimulation<Time>::start_bag()
+{
+    const auto t = events.tn();
+    if (!(t < end))
+        return false;
+
+    current = t;
+
+    if (++bag_number == 0) {
+        std::fill(imminent_stamp.begin(), imminent_stamp.end(), 0);
+        std::fill(influenced_stamp.begin(), influenced_stamp.end(), 0);
+        bag_number = 1;
+    }
+
+    imminent.clear();
+    events.pop(imminent);
+
+    values.clear();
+    outputs.clear();
+
+    for (auto id : imminent) {
+        imminent_stamp[model_index(id)] = bag_number;
+
+        Outputs out(values, outputs, id);
+        visit(simulators.get(id), [&out](auto& dyn) { dyn.lambda(out); });
+    }
+
+    inputs.clear();
+    for (const auto& msg : outputs)
+        for (const auto& route : get_routes(msg.source, msg.slot))
+            inputs.push_back(InputMessage{
+              route.simulator, msg.source, route.slot, msg.value });
+
+    // The bag of a simulator is ordered by source simulator to get the same
+    // results whatever the order of the imminent simulators.
+    std::stable_sort(
+      inputs.begin(),
+      inputs.end(),
+      [](const InputMessage& lhs, const InputMessage& rhs) {
+          const auto lhs_dst = model_index(lhs.destination);
+          const auto rhs_dst = model_index(rhs.destination);
+
+          return lhs_dst < rhs_dst ||
+                 (lhs_dst == rhs_dst &&
+                  model_index(lhs.source) < model_index(rhs.source));
+      });
+
+    transitions.clear();
+
+    const auto size = static_cast<int>(inputs.size());
+    for (int first = 0; first != size;) {
+        const auto id = inputs[first].destination;
+        auto last = first + 1;
+        while (last != size && inputs[last].destination == id)
+            ++last;
+
+        influenced_stamp[model_index(id)] = bag_number;
+        transitions.push_back(Transition{
+          id, first, last, imminent_stamp[model_index(id)] == bag_number });
+
+        first = last;
+    }
+
+    for (auto& batch : batches) {
+        batch.simulators.clear();
+        batch.columns.clear();
+    }
+
+    for (auto id : imminent) {
+        if (influenced_stamp[model_index(id)] == bag_number)
+            continue;
+
+        const auto& sim = simulators.get(id);
+        const auto order = sim.type == dynamics_type::integrator        ? 1
+                           : sim.type == dynamics_type::qss2_integrator ? 2
+                           : sim.type == dynamics_type::qss3_integrator ? 3
+                                                                        : 0;
+
+        if (order) {
+            batches[order - 1].simulators.push_back(id);
+            batches[order - 1].columns.push_back(
+              static_cast<int>(sim.builtin));
+        } else {
+            transitions.push_back(Transition{ id, 0, 0, true });
+        }
+    }
+
+    return true;
+}
+
+template<typename Time>
+void
+BasicFlatSimulation<Time>::transition(const Transition& tr) noexcept
+{
+    auto& sim = simulators.get(tr.simulator);
+    const Bag bag(inputs.data() + tr.first, inputs.data() + tr.last, values);
+    const auto t = static_cast<double>(current);
+    double ta;
+
+    if (tr.imminent) {
+        if (bag.empty())
+            ta = visit(sim, [t](auto& dyn) { return dyn.internal(t); });
+        else
+            ta = visit(sim, [t, &bag](auto& dyn) {
+                return dyn.confluent(t, bag);
+            });
+    } else {
+        const auto e = static_cast<double>(current - sim.tl);
+        ta = visit(sim, [t, e, &bag](auto& dyn) {
+            return dyn.external(t, e, bag);
+        });
+    }
+
+    sim.tl = current;
+    sim.tn = current + static_cast<Time>(ta);
+}
+
+template<typename Time>
+void
+BasicFlatSimulation<Time>::transition_batch(int order,
+                                            int first,
+                                            int last) noexcept
+{
+    const auto& batch = batches[order - 1];
+    const auto* columns = batch.columns.data();
+    const double* sigma;
+
+    switch (order) {
+    case 1:
+        builtins.integrators.internal(columns + first, last - first);
+        sigma = builtins.integrators.sigma.items;
+        break;
+    case 2:
+        builtins.qss2_integrators.internal(columns + first, last - first);
+        sigma = builtins.qss2_integrators.sigma.items;
+        break;
+    default:
+        builtins.qss3_integrators.internal(columns + first, last - first);
+        sigma = builtins.qss3_integrators.sigma.items;
+        break;
+    }
+
+    for (int i = first; i != last; ++i) {
+        auto& sim = simulators.get(batch.simulators[i]);
+        sim.tl = current;
+        sim.tn = current + static_cast<Time>(sigma[columns[i]]);
+    }
+}
+
+template<typename Time>
+void
+BasicFlatSimulation<Time>::end_bag()
+{
+    for (const auto& tr : transitions)
+        events.insert_or_update(tr.simulator,
+                                simulators.get(tr.simulator).tn);
+
+    for (const auto& batch : batches)
+        for (auto id : batch.simulators)
+            events.insert_or_update(id, simulators.get(id).tn);
+}
+
+template<typename Time>
+bool
+BasicFlatSimulation<Time>::step()
+{
+    if (!start_bag())
+        return false;
+
+    for (const auto& tr : transitions)
+        transition(tr);
+
+    for (int order = 1; order <= 3; ++order)
+        transition_batch(
+          order, 0, static_cast<int>(batches[order - 1].columns.size()));
+
+    end_bag();
+
+    return true;
+}
+
+template<typename Time>
+bool
+BasicFlatSimulation<Time>::step(thread_pool& pool)
+{
+    if (!start_bag())
+        return false;
+
+    pool.parallel_for(0,
+                      static_cast<int>(transitions.size()),
+                      [this](int i) { transition(transitions[i]); });
+
+    for (int order = 1; order <= 3; ++order)
+        pool.parallel_for_range(
+          0,
+          static_cast<int>(batches[order - 1].columns.size()),
+          1024,
+          [this, order](int first, int last) {
+              transition_batch(order, first, last);
+          });
+
+    end_bag();
+
+    return true;
+}
+
+template<typename Time>
+void
+BasicFlatSimulation<Time>::run()
+{
+    while (step())
+        ;
+}
+
+template<typename Time>
+void
+BasicFlatSimulation<Time>::run(thread_pool& pool)
+{
+    while (step(pool))
+        ;
+}
+
+template struct BasicFlatSimulation<float>;
+template struct BasicFlatSimulation<double>;
+template struct BasicFlatSimulation<fixed_time<1000000>>;
+
 VLE::VLE()
 {
     int value = 0;
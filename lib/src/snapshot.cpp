@@ -0,0 +1,675 @@
+// Copyright (c) 2019 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <irritator/modeling.hpp>
+
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <sys/types.h>
+#endif
+
+namespace irr {
+
+/// Access to the memory of a @c data_list or a @c chunk_list for the
+/// snapshots.
+template<typename List>
+struct list_access
+{
+    using item_type = typename List::item;
+
+    static item_type* items(const List& list) noexcept
+    {
+        return list.items;
+    }
+
+    static void set(List& list,
+                    int max_size,
+                    int max_used,
+                    int free_head) noexcept
+    {
+        list.max_size = max_size;
+        list.max_used = max_used;
+        list.free_head = free_head;
+        list.high_water = max_size;
+    }
+
+    static void get(const List& list,
+                    int& capacity,
+                    int& max_size,
+                    int& max_used,
+                    int& free_head) noexcept
+    {
+        capacity = list.capacity;
+        max_size = list.max_size;
+        max_used = list.max_used;
+        free_head = list.free_head;
+    }
+};
+
+namespace {
+
+// A snapshot is:
+// - a snapshot_header,
+// - a table of snapshot_section, one by array of the Model in the order of
+//   the Model members,
+// - the sections, each section starts on a multiple of 64 bytes from the
+//   start of the file.
+//
+// The section of a data_array stores the occupancy words, then the items
+// (with their identifiers for interleaved_ids), or the identifiers then the
+// items (for separated_ids), each block aligned on 64 bytes. The section of
+// a data_array of std::string stores the occupancy words, the identifiers
+// then the length and the characters of each item. The section of a
+// data_list or a chunk_list stores its items.
+
+constexpr char snapshot_magic[8] = { 'I', 'R', 'R', 'S', 'N', 'A', 'P', '\0' };
+// Version 2: the id_list of the nodes and the views store their size.
+// Version 3: the chunks of the unrolled_id_list.
+// Version 4: the identifiers of the Model with 24 bits of index.
+constexpr std::uint32_t snapshot_version = 4;
+constexpr std::uint32_t snapshot_endianness = 0x01020304;
+constexpr std::uint32_t snapshot_section_number = 14;
+constexpr std::uint64_t snapshot_alignment = 64;
+
+enum class section_kind : std::uint32_t
+{
+    interleaved_array = 1,
+    separated_array,
+    string_array,
+    list
+};
+
+struct snapshot_header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t endianness;
+    std::uint32_t section_number;
+    std::uint32_t pointer_size;
+    std::int32_t version_major;
+    std::int32_t version_minor;
+    std::int32_t version_patch;
+    std::uint32_t reserved;
+    char name[32];
+    char author[32];
+};
+
+struct snapshot_section
+{
+    section_kind kind;
+    std::uint32_t entry_size; // an item with its id for interleaved_ids.
+    std::uint32_t id_size;
+    std::int32_t capacity;
+    std::int32_t max_size;
+    std::int32_t max_used;
+    std::int32_t free_head;
+    std::uint32_t next_key;
+    std::uint64_t offset;
+    std::uint64_t length;
+};
+
+constexpr std::uint64_t
+aligned(std::uint64_t size) noexcept
+{
+    return (size + snapshot_alignment - 1) / snapshot_alignment *
+           snapshot_alignment;
+}
+
+constexpr std::uint64_t
+occupancy_size(int max_used) noexcept
+{
+    return static_cast<std::uint64_t>((max_used + 63) / 64) *
+           sizeof(std::uint64_t);
+}
+
+// The items are written byte by byte: they must not hold pointers or
+// resources.
+template<typename T>
+constexpr bool is_raw_copyable =
+  std::is_trivially_destructible<T>::value && !std::is_pointer<T>::value;
+
+// Moves to a 64 bits offset of the file: std::fseek takes a long, 32 bits
+// on Windows, and the snapshots of large models exceed 2 GB.
+bool
+seek_file(std::FILE* file, std::uint64_t position) noexcept
+{
+#if defined(_WIN32)
+    using offset_type = __int64;
+#else
+    using offset_type = off_t;
+#endif
+
+    if (position >
+        static_cast<std::uint64_t>(std::numeric_limits<offset_type>::max()))
+        return false;
+
+#if defined(_WIN32)
+    return ::_fseeki64(file, static_cast<offset_type>(position), SEEK_SET) ==
+           0;
+#else
+    return ::fseeko(file, static_cast<offset_type>(position), SEEK_SET) == 0;
+#endif
+}
+
+class snapshot_writer
+{
+    std::FILE* m_file;
+    std::uint64_t m_position = 0;
+    bool m_error = false;
+
+public:
+    explicit snapshot_writer(std::FILE* file) noexcept
+      : m_file(file)
+    {}
+
+    bool error() const noexcept
+    {
+        return m_error;
+    }
+
+    std::uint64_t position() const noexcept
+    {
+        return m_position;
+    }
+
+    void write(const void* data, std::uint64_t size) noexcept
+    {
+        if (m_error || size == 0)
+            return;
+
+        if (std::fwrite(data, 1, size, m_file) != size)
+            m_error = true;
+
+        m_position += size;
+    }
+
+    void align() noexcept
+    {
+        static const char zeros[snapshot_alignment] = { 0 };
+
+        write(zeros, aligned(m_position) - m_position);
+    }
+
+    void seek(std::uint64_t position) noexcept
+    {
+        if (!m_error && !seek_file(m_file, position))
+            m_error = true;
+
+        m_position = position;
+    }
+};
+
+class snapshot_reader
+{
+    std::FILE* m_file;
+    bool m_error = false;
+
+public:
+    explicit snapshot_reader(std::FILE* file) noexcept
+      : m_file(file)
+    {}
+
+    bool error() const noexcept
+    {
+        return m_error;
+    }
+
+    void read(void* data, std::uint64_t size) noexcept
+    {
+        if (m_error || size == 0)
+            return;
+
+        if (std::fread(data, 1, size, m_file) != size)
+            m_error = true;
+    }
+
+    void seek(std::uint64_t position) noexcept
+    {
+        if (!m_error && !seek_file(m_file, position))
+            m_error = true;
+    }
+};
+
+template<typename Array>
+snapshot_section
+make_section(const Array& array, section_kind kind, std::uint32_t entry_size)
+{
+    snapshot_section section{};
+    section.kind = kind;
+    section.entry_size = entry_size;
+    section.id_size = sizeof(typename Array::identifier_type);
+    section.capacity = array.capacity;
+    section.max_size = array.max_size;
+    section.max_used = array.max_used;
+    section.free_head = array.free_head;
+    section.next_key = array.next_key;
+
+    return section;
+}
+
+template<typename T, typename Identifier, typename Split>
+snapshot_section
+write_array(snapshot_writer& out,
+            const data_array<T, Identifier, Split, interleaved_ids>& array)
+{
+    static_assert(is_raw_copyable<T>, "snapshot needs raw copyable items");
+
+    using item =
+      typename data_array_storage<T, Identifier, interleaved_ids>::item;
+
+    auto section =
+      make_section(array, section_kind::interleaved_array, sizeof(item));
+    section.offset = out.position();
+
+    out.write(array.occupancy, occupancy_size(array.max_used));
+    out.align();
+    out.write(array.items, sizeof(item) * array.max_used);
+
+    section.length = out.position() - section.offset;
+    out.align();
+
+    return section;
+}
+
+template<typename T, typename Identifier, typename Split>
+snapshot_section
+write_array(snapshot_writer& out,
+            const data_array<T, Identifier, Split, separated_ids>& array)
+{
+    static_assert(is_raw_copyable<T>, "snapshot needs raw copyable items");
+
+    auto section =
+      make_section(array, section_kind::separated_array, sizeof(T));
+    section.offset = out.position();
+
+    out.write(array.occupancy, occupancy_size(array.max_used));
+    out.align();
+    out.write(array.ids, sizeof(Identifier) * array.max_used);
+    out.align();
+    out.write(array.items, sizeof(T) * array.max_used);
+
+    section.length = out.position() - section.offset;
+    out.align();
+
+    return section;
+}
+
+snapshot_section
+write_array(snapshot_writer& out, const Strings& array)
+{
+    auto section =
+      make_section(array, section_kind::string_array, sizeof(ID));
+    section.offset = out.position();
+
+    out.write(array.occupancy, occupancy_size(array.max_used));
+    out.align();
+
+    for (int i = 0; i != array.max_used; ++i)
+        out.write(&array.items[i].id, sizeof(ID));
+
+    for (int i = array.next_index(0); i < array.max_used;
+         i = array.next_index(i + 1)) {
+        const auto& str = array.items[i].item;
+        const auto length = static_cast<std::uint32_t>(str.size());
+
+        out.write(&length, sizeof(length));
+        out.write(str.data(), length);
+    }
+
+    section.length = out.position() - section.offset;
+    out.align();
+
+    return section;
+}
+
+template<typename List>
+snapshot_section
+write_list(snapshot_writer& out, const List& list)
+{
+    using access = list_access<List>;
+    using item = typename access::item_type;
+    using Identifier = typename List::identifier_type;
+
+    snapshot_section section{};
+    section.kind = section_kind::list;
+    section.entry_size = sizeof(item);
+    section.id_size = sizeof(Identifier);
+    access::get(list,
+                section.capacity,
+                section.max_size,
+                section.max_used,
+                section.free_head);
+    section.offset = out.position();
+
+    out.write(access::items(list), sizeof(item) * section.max_used);
+
+    section.length = out.position() - section.offset;
+    out.align();
+
+    return section;
+}
+
+bool
+check_section(const snapshot_section& section,
+              section_kind kind,
+              std::uint32_t entry_size,
+              std::uint32_t id_size) noexcept
+{
+    return section.kind == kind && section.entry_size == entry_size &&
+           section.id_size == id_size && section.capacity >= 0 &&
+           section.max_used >= 0 && section.max_used <= section.capacity &&
+           section.max_size >= 0 && section.max_size <= section.max_used &&
+           section.free_head >= -1 && section.free_head < section.max_used;
+}
+
+template<typename Array>
+bool
+init_array(Array& array, const snapshot_section& section)
+{
+    if (!array.init(section.capacity))
+        return false;
+
+    array.max_size = section.max_size;
+    array.max_used = section.max_used;
+    array.free_head = section.free_head;
+    array.next_key = section.next_key;
+
+    return true;
+}
+
+template<typename T, typename Identifier, typename Split>
+status
+read_array(snapshot_reader& in,
+           const snapshot_section& section,
+           data_array<T, Identifier, Split, interleaved_ids>& array)
+{
+    using item =
+      typename data_array_storage<T, Identifier, interleaved_ids>::item;
+
+    if (!check_section(section,
+                       section_kind::interleaved_array,
+                       sizeof(item),
+                       sizeof(Identifier)) ||
+        !init_array(array, section))
+        return status::snapshot_bad_format;
+
+    const auto occupancy = occupancy_size(section.max_used);
+
+    in.seek(section.offset);
+    in.read(array.occupancy, occupancy);
+    in.seek(section.offset + aligned(occupancy));
+    in.read(array.items, sizeof(item) * section.max_used);
+
+    return in.error() ? status::snapshot_read_error
+                      : status::snapshot_read_success;
+}
+
+template<typename T, typename Identifier, typename Split>
+status
+read_array(snapshot_reader& in,
+           const snapshot_section& section,
+           data_array<T, Identifier, Split, separated_ids>& array)
+{
+    if (!check_section(section,
+                       section_kind::separated_array,
+                       sizeof(T),
+                       sizeof(Identifier)) ||
+        !init_array(array, section))
+        return status::snapshot_bad_format;
+
+    const auto occupancy = occupancy_size(section.max_used);
+    const auto ids = sizeof(Identifier) * section.max_used;
+
+    in.seek(section.offset);
+    in.read(array.occupancy, occupancy);
+    in.seek(section.offset + aligned(occupancy));
+    in.read(array.ids, ids);
+    in.seek(section.offset + aligned(occupancy) + aligned(ids));
+    in.read(array.items, sizeof(T) * section.max_used);
+
+    return in.error() ? status::snapshot_read_error
+                      : status::snapshot_read_success;
+}
+
+status
+read_array(snapshot_reader& in,
+           const snapshot_section& section,
+           Strings& array)
+{
+    if (!check_section(
+          section, section_kind::string_array, sizeof(ID), sizeof(ID)) ||
+        !init_array(array, section))
+        return status::snapshot_bad_format;
+
+    const auto occupancy = occupancy_size(section.max_used);
+
+    in.seek(section.offset);
+    in.read(array.occupancy, occupancy);
+    in.seek(section.offset + aligned(occupancy));
+
+    for (int i = 0; i != section.max_used; ++i)
+        in.read(&array.items[i].id, sizeof(ID));
+
+    // Until all the strings are read, clear() must not destroy the
+    // strings not yet constructed.
+    std::string str;
+    int constructed = 0;
+
+    for (int i = array.next_index(0); i < array.max_used;
+         i = array.next_index(i + 1)) {
+        std::uint32_t length = 0;
+        in.read(&length, sizeof(length));
+        if (in.error() || length > section.length)
+            break;
+
+        str.resize(length);
+        in.read(str.data(), length);
+        new (&array.items[i].item) std::string(str);
+        ++constructed;
+    }
+
+    if (constructed != array.max_size || in.error()) {
+        for (int i = array.next_index(0), j = 0; j != constructed;
+             i = array.next_index(i + 1), ++j)
+            array.items[i].item.~basic_string();
+
+        std::fill_n(array.occupancy, occupancy / sizeof(std::uint64_t), 0);
+        array.clear();
+
+        return status::snapshot_read_error;
+    }
+
+    return status::snapshot_read_success;
+}
+
+template<typename List>
+status
+read_list(snapshot_reader& in, const snapshot_section& section, List& list)
+{
+    using access = list_access<List>;
+    using item = typename access::item_type;
+    using Identifier = typename List::identifier_type;
+
+    if (!check_section(
+          section, section_kind::list, sizeof(item), sizeof(Identifier)) ||
+        !list.init(section.capacity))
+        return status::snapshot_bad_format;
+
+    access::set(list, section.max_size, section.max_used, section.free_head);
+
+    in.seek(section.offset);
+    in.read(access::items(list), sizeof(item) * section.max_used);
+
+    return in.error() ? status::snapshot_read_error
+                      : status::snapshot_read_success;
+}
+
+} // anonymous namespace
+
+status
+Model::write_snapshot(const std::filesystem::path& file_name) const
+{
+    if (is_frozen)
+        return status::snapshot_model_frozen;
+
+    auto* file = std::fopen(file_name.string().c_str(), "wb");
+    if (!file)
+        return status::snapshot_open_error;
+
+    snapshot_header header{};
+    std::memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+    header.version = snapshot_version;
+    header.endianness = snapshot_endianness;
+    header.section_number = snapshot_section_number;
+    header.pointer_size = sizeof(void*);
+    header.version_major = version_major;
+    header.version_minor = version_minor;
+    header.version_patch = version_patch;
+    std::strncpy(header.name, name.data(), sizeof(header.name) - 1);
+    std::strncpy(header.author, author.data(), sizeof(header.author) - 1);
+
+    snapshot_section sections[snapshot_section_number] = {};
+    snapshot_writer out(file);
+
+    out.write(&header, sizeof(header));
+    out.write(sections, sizeof(sections));
+    out.align();
+
+    int i = 0;
+    sections[i++] = write_array(out, conditions);
+    sections[i++] = write_array(out, connections);
+    sections[i++] = write_array(out, slots);
+    sections[i++] = write_array(out, views);
+    sections[i++] = write_array(out, nodes);
+    sections[i++] = write_array(out, classes);
+    sections[i++] = write_list(out, links);
+    sections[i++] = write_list(out, wlinks);
+    sections[i++] = write_list(out, chunks);
+    sections[i++] = write_array(out, integer32s);
+    sections[i++] = write_array(out, integer64s);
+    sections[i++] = write_array(out, real32s);
+    sections[i++] = write_array(out, real64s);
+    sections[i++] = write_array(out, strings);
+
+    out.seek(sizeof(header));
+    out.write(sections, sizeof(sections));
+
+    const auto error = out.error();
+    if (std::fclose(file) != 0 || error)
+        return status::snapshot_write_error;
+
+    return status::snapshot_write_success;
+}
+
+status
+Model::read_snapshot(const std::filesystem::path& file_name)
+{
+    auto* file = std::fopen(file_name.string().c_str(), "rb");
+    if (!file)
+        return status::snapshot_open_error;
+
+    snapshot_reader in(file);
+    snapshot_header header{};
+    snapshot_section sections[snapshot_section_number] = {};
+
+    in.read(&header, sizeof(header));
+    in.read(sections, sizeof(sections));
+
+    if (in.error() ||
+        std::memcmp(header.magic, snapshot_magic, sizeof(header.magic)) != 0) {
+        std::fclose(file);
+        return status::snapshot_bad_format;
+    }
+
+    if (header.version != snapshot_version ||
+        header.endianness != snapshot_endianness ||
+        header.pointer_size != sizeof(void*) ||
+        header.section_number != snapshot_section_number) {
+        std::fclose(file);
+        return status::snapshot_bad_version;
+    }
+
+    frozen_lists.clear();
+    is_frozen = false;
+
+    // The capacities to empty the arrays if a section fails.
+    const int capacities[] = {
+        conditions.capacity, connections.capacity, slots.capacity,
+        views.capacity,      nodes.capacity,       classes.capacity,
+        integer32s.capacity, integer64s.capacity,  real32s.capacity,
+        real64s.capacity,    strings.capacity
+    };
+
+    // Reads the sections in order and stops at the first failure.
+    auto ret = status::snapshot_read_success;
+    auto read = [&ret](auto&& fct) {
+        if (ret == status::snapshot_read_success)
+            ret = fct();
+    };
+
+    read([&]() { return read_array(in, sections[0], conditions); });
+    read([&]() { return read_array(in, sections[1], connections); });
+    read([&]() { return read_array(in, sections[2], slots); });
+    read([&]() { return read_array(in, sections[3], views); });
+    read([&]() { return read_array(in, sections[4], nodes); });
+    read([&]() { return read_array(in, sections[5], classes); });
+    read([&]() { return read_list(in, sections[6], links); });
+    read([&]() { return read_list(in, sections[7], wlinks); });
+    read([&]() { return read_list(in, sections[8], chunks); });
+    read([&]() { return read_array(in, sections[9], integer32s); });
+    read([&]() { return read_array(in, sections[10], integer64s); });
+    read([&]() { return read_array(in, sections[11], real32s); });
+    read([&]() { return read_array(in, sections[12], real64s); });
+    read([&]() { return read_array(in, sections[13], strings); });
+
+    std::fclose(file);
+
+    if (ret != status::snapshot_read_success) {
+        // The arrays mix items of the Model and partial items of the
+        // snapshot: the Model is emptied.
+        name.clear();
+        author.clear();
+        version_major = -1;
+        version_minor = -1;
+        version_patch = -1;
+
+        int i = 0;
+        conditions.init(capacities[i++]);
+        connections.init(capacities[i++]);
+        slots.init(capacities[i++]);
+        views.init(capacities[i++]);
+        nodes.init(capacities[i++]);
+        classes.init(capacities[i++]);
+        links.init(0);
+        wlinks.init(0);
+        chunks.init(0);
+        integer32s.init(capacities[i++]);
+        integer64s.init(capacities[i++]);
+        real32s.init(capacities[i++]);
+        real64s.init(capacities[i++]);
+        strings.init(capacities[i++]);
+
+        return ret;
+    }
+
+    header.name[sizeof(header.name) - 1] = '\0';
+    header.author[sizeof(header.author) - 1] = '\0';
+    name = header.name;
+    author = header.author;
+    version_major = header.version_major;
+    version_minor = header.version_minor;
+    version_patch = header.version_patch;
+
+    return ret;
+}
+
+} // namespace irr
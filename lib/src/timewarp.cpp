@@ -0,0 +1,736 @@
+// Copyright (c) 2019 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <irritator/spsc-queue.hpp>
+#include <irritator/timewarp.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <map>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+#include <cstdlib>
+
+namespace irr {
+
+namespace {
+
+constexpr float infinity = std::numeric_limits<float>::infinity();
+
+/**
+ * A message between two partitions. The pair (sender, serial) identifies
+ * the message and its anti-message. The rank is the order of emission of
+ * the message by its source simulator.
+ */
+struct timewarp_message
+{
+    float time;
+    ID destination;
+    ID source;
+    int slot;
+    int sender;
+    int rank;
+    std::uint64_t serial;
+    bool anti;
+    int size;
+    double data[TimeWarp::payload];
+};
+
+bool
+is_same_message(const timewarp_message& lhs,
+                const timewarp_message& rhs) noexcept
+{
+    return lhs.time == rhs.time && lhs.destination == rhs.destination &&
+           lhs.source == rhs.source && lhs.slot == rhs.slot &&
+           lhs.rank == rhs.rank && lhs.size == rhs.size &&
+           std::equal(lhs.data, lhs.data + lhs.size, rhs.data);
+}
+
+struct saved_state
+{
+    ID simulator;
+    float tl;
+    float tn;
+    int offset;
+    int size;
+};
+
+/**
+ * A bag processed by a partition with everything needed to undo it: the
+ * states of the transitioned simulators before the bag, the messages
+ * received from other partitions and the messages sent.
+ */
+struct processed_step
+{
+    float time;
+    std::vector<saved_state> saved;
+    std::vector<unsigned char> states;
+    std::vector<timewarp_message> consumed;
+    std::vector<timewarp_message> sent;
+
+    void clear() noexcept
+    {
+        saved.clear();
+        states.clear();
+        consumed.clear();
+        sent.clear();
+    }
+};
+
+} // anonymous namespace
+
+struct timewarp_partition
+{
+    TimeWarp& tw;
+    FlatSimulation& flat;
+    const int id;
+
+    /// The queues of messages from the other partitions indexed by sender,
+    /// nullptr if the sender has no route to this partition.
+    std::vector<std::unique_ptr<spsc_queue<timewarp_message>>> queues;
+
+    heap<float, ID, model_id_split> events;
+    std::multimap<float, timewarp_message> pending;
+    std::deque<processed_step> history;
+    std::vector<processed_step> free_steps;
+    std::vector<timewarp_message> inbox;
+    std::vector<timewarp_message> lazy;
+
+    Values values;
+    std::vector<ID> imminent;
+    std::vector<OutputMessage> outputs;
+    std::vector<InputMessage> inputs;
+    std::vector<FlatSimulation::Transition> transitions;
+    std::vector<timewarp_message> received;
+    std::vector<std::uint32_t> imminent_stamp;
+    std::vector<std::uint32_t> influenced_stamp;
+    std::uint32_t bag_number = 0;
+
+    float lvt = -infinity;
+    float send_minimum = infinity;
+    unsigned reported_round = 0;
+    int gvt_loop = 0;
+    std::uint64_t serial = 0;
+
+    TimeWarpStatistics stats;
+
+    timewarp_partition(TimeWarp& tw_, int id_) noexcept
+      : tw(tw_)
+      , flat(*tw_.flat)
+      , id(id_)
+    {}
+
+    bool init(int partition_number, int values_capacity)
+    {
+        queues.resize(partition_number);
+        imminent_stamp.assign(flat.simulators.capacity, 0);
+        influenced_stamp.assign(flat.simulators.capacity, 0);
+
+        return events.init(flat.simulators.capacity) &&
+               values.init(values_capacity);
+    }
+
+    float minimum_time() const noexcept
+    {
+        return pending.empty() ? events.tn()
+                               : std::min(events.tn(), pending.begin()->first);
+    }
+
+    /// The lowest time of a message this partition may still send: an
+    /// unprocessed bag or an anti-message of the lazy cancellation.
+    float minimum_send_time() const noexcept
+    {
+        auto ret = minimum_time();
+
+        for (const auto& msg : lazy)
+            ret = std::min(ret, msg.time);
+
+        return ret;
+    }
+
+    void drain()
+    {
+        timewarp_message msg;
+
+        for (auto& queue : queues)
+            if (queue)
+                while (queue->pop(msg))
+                    inbox.push_back(msg);
+    }
+
+    void send(const timewarp_message& msg, int to)
+    {
+        auto& queue = *tw.partitions[to]->queues[id];
+
+        // If the queue is full, the receiver may itself wait for one of our
+        // queues: keep them flowing until a slot is available.
+        while (!queue.push(msg)) {
+            drain();
+            std::this_thread::yield();
+        }
+
+        // A message sent while a GVT computation is running and before
+        // this partition reports may be missed by the receiver.
+        if (tw.gvt_active.load() && reported_round != tw.gvt_round.load())
+            send_minimum = std::min(send_minimum, msg.time);
+
+        if (msg.anti)
+            ++stats.anti_messages;
+        else
+            ++stats.messages;
+    }
+
+    bool annihilate(const timewarp_message& anti)
+    {
+        auto range = pending.equal_range(anti.time);
+
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second.sender == anti.sender &&
+                it->second.serial == anti.serial) {
+                pending.erase(it);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /// Send the anti-messages of the rolled back messages at a time lower
+    /// than or equal to @c t that the new bags did not send again.
+    void cancel(float t)
+    {
+        std::size_t i = 0;
+
+        while (i != lazy.size()) {
+            if (lazy[i].time <= t) {
+                auto msg = lazy[i];
+                msg.anti = true;
+                send(msg, tw.owner[model_index(msg.destination)]);
+
+                lazy[i] = lazy.back();
+                lazy.pop_back();
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    /// Undo all the bags at a time greater than or equal to @c t. The sent
+    /// messages are cancelled lazily: only those not sent again by the new
+    /// execution of the bags are cancelled. Otherwise two partitions
+    /// exchanging messages at the same time would cancel each other
+    /// forever.
+    void rollback(float t)
+    {
+        ++stats.rollbacks;
+
+        while (!history.empty() && history.back().time >= t) {
+            auto& step = history.back();
+
+            for (auto it = step.saved.rbegin(); it != step.saved.rend();
+                 ++it) {
+                auto& sim = flat.simulators.get(it->simulator);
+                sim.tl = it->tl;
+                sim.tn = it->tn;
+
+                if (it->size > 0) {
+                    const auto* state = step.states.data() + it->offset;
+                    flat.visit(sim,
+                               [state](auto& dyn) { dyn.restore(state); });
+                }
+
+                events.insert_or_update(it->simulator, sim.tn);
+            }
+
+            for (const auto& msg : step.consumed)
+                pending.emplace(msg.time, msg);
+
+            lazy.insert(lazy.end(), step.sent.begin(), step.sent.end());
+
+            ++stats.rolled_back_steps;
+            step.clear();
+            free_steps.emplace_back(std::move(step));
+            history.pop_back();
+        }
+
+        lvt = history.empty() ? -infinity : history.back().time;
+    }
+
+    void receive()
+    {
+        drain();
+
+        // A rollback sends nothing: it moves the sent messages to the lazy
+        // list, cancel() sends their anti-messages when the bags run again.
+        for (const auto& msg : inbox) {
+            if (!msg.anti) {
+                if (msg.time <= lvt)
+                    rollback(msg.time);
+
+                pending.emplace(msg.time, msg);
+            } else if (!annihilate(msg)) {
+                // The message is already consumed, roll back before it.
+                rollback(msg.time);
+
+                [[maybe_unused]] const bool found = annihilate(msg);
+                assert(found);
+            }
+        }
+
+        inbox.clear();
+    }
+
+    void report()
+    {
+        tw.local_minimum[id] = std::min(minimum_send_time(), send_minimum);
+        send_minimum = infinity;
+        reported_round = tw.gvt_round.load();
+
+        if (tw.gvt_remaining.fetch_sub(1) == 1) {
+            auto gvt = infinity;
+            for (auto t : tw.local_minimum)
+                gvt = std::min(gvt, t);
+
+            ++stats.gvt_rounds;
+            tw.gvt.store(gvt);
+            if (!(gvt < tw.end))
+                tw.done.store(true);
+
+            tw.gvt_active.store(false);
+        }
+    }
+
+    void start_gvt()
+    {
+        if (++gvt_loop < tw.gvt_interval || tw.gvt_active.load())
+            return;
+
+        gvt_loop = 0;
+        tw.gvt_remaining.store(static_cast<int>(tw.partitions.size()));
+        tw.gvt_round.fetch_add(1);
+        tw.gvt_active.store(true);
+    }
+
+    /// Release the bags below the GVT, they can not be rolled back.
+    void collect_fossils()
+    {
+        const auto gvt = tw.gvt.load(std::memory_order_relaxed);
+
+        while (!history.empty() && history.front().time < gvt) {
+            ++stats.fossil_steps;
+            history.front().clear();
+            free_steps.emplace_back(std::move(history.front()));
+            history.pop_front();
+        }
+    }
+
+    processed_step take_step()
+    {
+        if (free_steps.empty())
+            return processed_step{};
+
+        auto step = std::move(free_steps.back());
+        free_steps.pop_back();
+        return step;
+    }
+
+    void save(processed_step& step, ID simulator)
+    {
+        const auto& sim = flat.simulators.get(simulator);
+        const auto size =
+          flat.visit(sim, [](auto& dyn) { return dyn.state_size(); });
+        const auto offset = static_cast<int>(step.states.size());
+
+        if (size > 0) {
+            step.states.resize(offset + size);
+            auto* state = step.states.data() + offset;
+            flat.visit(sim, [state](auto& dyn) { dyn.save(state); });
+        }
+
+        step.saved.push_back(
+          saved_state{ simulator, sim.tl, sim.tn, offset, size });
+    }
+
+    void transition(const FlatSimulation::Transition& tr, float t) noexcept
+    {
+        auto& sim = flat.simulators.get(tr.simulator);
+        const Bag bag(
+          inputs.data() + tr.first, inputs.data() + tr.last, values);
+        double ta;
+
+        if (tr.imminent) {
+            if (bag.empty())
+                ta = flat.visit(sim,
+                                [t](auto& dyn) { return dyn.internal(t); });
+            else
+                ta = flat.visit(sim, [t, &bag](auto& dyn) {
+                    return dyn.confluent(t, bag);
+                });
+        } else {
+            const auto e = t - sim.tl;
+            ta = flat.visit(sim, [t, e, &bag](auto& dyn) {
+                return dyn.external(t, e, bag);
+            });
+        }
+
+        sim.tl = t;
+        sim.tn = t + static_cast<float>(ta);
+    }
+
+    /**
+     * @brief Process the bag of the next local time if it is lower than the
+     * @c end time.
+     *
+     * @return false if there is nothing to do.
+     */
+    bool step()
+    {
+        const auto t = minimum_time();
+        if (!(t < tw.end)) {
+            cancel(infinity);
+            return false;
+        }
+
+        if (++bag_number == 0) {
+            std::fill(imminent_stamp.begin(), imminent_stamp.end(), 0);
+            std::fill(influenced_stamp.begin(), influenced_stamp.end(), 0);
+            bag_number = 1;
+        }
+
+        auto step = take_step();
+        step.time = t;
+
+        imminent.clear();
+        if (events.tn() == t)
+            events.pop(imminent);
+
+        values.clear();
+        outputs.clear();
+
+        for (auto simulator : imminent) {
+            imminent_stamp[model_index(simulator)] = bag_number;
+
+            Outputs out(values, outputs, simulator);
+            flat.visit(flat.simulators.get(simulator),
+                       [&out](auto& dyn) { dyn.lambda(out); });
+        }
+
+        inputs.clear();
+        int rank = 0;
+        for (std::size_t i = 0; i != outputs.size(); ++i) {
+            const auto& msg = outputs[i];
+            if (i == 0 || outputs[i - 1].source != msg.source)
+                rank = 0;
+
+            for (const auto& route : flat.get_routes(msg.source, msg.slot)) {
+                const auto to = tw.owner[model_index(route.simulator)];
+
+                if (to == id) {
+                    inputs.push_back(InputMessage{
+                      route.simulator, msg.source, route.slot, msg.value });
+                    continue;
+                }
+
+                assert(msg.value.type == Value::value_type::real64);
+                assert(msg.value.size <= TimeWarp::payload);
+                if (msg.value.size > TimeWarp::payload)
+                    std::abort();
+
+                timewarp_message remote{};
+                remote.time = t;
+                remote.destination = route.simulator;
+                remote.source = msg.source;
+                remote.slot = route.slot;
+                remote.sender = id;
+                remote.rank = rank++;
+                remote.anti = false;
+                remote.size = msg.value.size;
+                std::copy_n(&values.real64[msg.value.index],
+                            msg.value.size,
+                            remote.data);
+
+                auto it = std::find_if(
+                  lazy.begin(), lazy.end(), [&remote](const auto& sent) {
+                      return is_same_message(sent, remote);
+                  });
+
+                if (it != lazy.end()) {
+                    remote.serial = it->serial;
+                    *it = lazy.back();
+                    lazy.pop_back();
+                } else {
+                    remote.serial = serial++;
+                    send(remote, to);
+                }
+
+                step.sent.push_back(remote);
+            }
+        }
+
+        received.clear();
+        while (!pending.empty() && pending.begin()->first == t) {
+            received.push_back(pending.begin()->second);
+            pending.erase(pending.begin());
+        }
+
+        // Restores the emission order of the messages of a same source: a
+        // rollback may have reordered the pending messages.
+        std::sort(received.begin(),
+                  received.end(),
+                  [](const timewarp_message& lhs, const timewarp_message& rhs) {
+                      const auto lhs_src = model_index(lhs.source);
+                      const auto rhs_src = model_index(rhs.source);
+
+                      return lhs_src < rhs_src ||
+                             (lhs_src == rhs_src && lhs.rank < rhs.rank);
+                  });
+
+        for (const auto& msg : received) {
+            auto value = values.alloc_real64(msg.data[0],
+                                             static_cast<int16_t>(msg.size));
+            std::copy_n(
+              msg.data + 1, msg.size - 1, &values.real64[value.index + 1]);
+
+            inputs.push_back(
+              InputMessage{ msg.destination, msg.source, msg.slot, value });
+            step.consumed.push_back(msg);
+        }
+
+        // Same order as the sequential engine.
+        std::stable_sort(
+          inputs.begin(),
+          inputs.end(),
+          [](const InputMessage& lhs, const InputMessage& rhs) {
+              const auto lhs_dst = model_index(lhs.destination);
+              const auto rhs_dst = model_index(rhs.destination);
+
+              return lhs_dst < rhs_dst ||
+                     (lhs_dst == rhs_dst &&
+                      model_index(lhs.source) < model_index(rhs.source));
+          });
+
+        transitions.clear();
+
+        const auto size = static_cast<int>(inputs.size());
+        for (int first = 0; first != size;) {
+            const auto simulator = inputs[first].destination;
+            auto last = first + 1;
+            while (last != size && inputs[last].destination == simulator)
+                ++last;
+
+            influenced_stamp[model_index(simulator)] = bag_number;
+            transitions.push_back(FlatSimulation::Transition{
+              simulator,
+              first,
+              last,
+              imminent_stamp[model_index(simulator)] == bag_number });
+
+            first = last;
+        }
+
+        for (auto simulator : imminent)
+            if (influenced_stamp[model_index(simulator)] != bag_number)
+                transitions.push_back(
+                  FlatSimulation::Transition{ simulator, 0, 0, true });
+
+        for (const auto& tr : transitions) {
+            save(step, tr.simulator);
+            transition(tr, t);
+            events.insert_or_update(tr.simulator,
+                                    flat.simulators.get(tr.simulator).tn);
+        }
+
+        history.emplace_back(std::move(step));
+        lvt = t;
+        ++stats.steps;
+
+        cancel(t);
+
+        return true;
+    }
+
+    void run()
+    {
+        while (!tw.done.load()) {
+            const bool must_report =
+              tw.gvt_active.load() && reported_round != tw.gvt_round.load();
+
+            receive();
+
+            if (must_report)
+                report();
+
+            if (id == 0)
+                start_gvt();
+
+            collect_fossils();
+
+            if (!step())
+                std::this_thread::yield();
+        }
+    }
+};
+
+TimeWarp::TimeWarp() noexcept = default;
+
+TimeWarp::~TimeWarp() noexcept = default;
+
+bool
+TimeWarp::initialize(FlatSimulation& flat_,
+                     int partition_number,
+                     float start_,
+                     float end_,
+                     int queue_capacity)
+{
+    if (partition_number < 1)
+        return false;
+
+    std::vector<int> owner_(flat_.simulators.capacity, 0);
+    const auto number = flat_.simulators.size();
+    int i = 0;
+
+    Simulator* sim = nullptr;
+    while (flat_.simulators.next(sim))
+        owner_[model_index(flat_.simulators.get_id(*sim))] =
+          static_cast<int>(static_cast<std::int64_t>(i++) * partition_number /
+                           number);
+
+    return initialize(
+      flat_, owner_, partition_number, start_, end_, queue_capacity);
+}
+
+bool
+TimeWarp::initialize(FlatSimulation& flat_,
+                     const std::vector<int>& owner_,
+                     int partition_number,
+                     float start_,
+                     float end_,
+                     int queue_capacity)
+{
+    if (partition_number < 1 || !(start_ < end_) ||
+        owner_.size() < static_cast<std::size_t>(flat_.simulators.capacity))
+        return false;
+
+    flat = &flat_;
+    start = start_;
+    end = end_;
+    owner = owner_;
+
+    // An estimate of the values of a bag of a partition, the outputs of
+    // its simulators and the messages from the other partitions: Values
+    // grows beyond.
+    int values_capacity =
+      16 + payload * static_cast<int>(flat->routes.size());
+
+    {
+        Simulator* sim = nullptr;
+        while (flat->simulators.next(sim)) {
+            if (!flat->has_dynamics(*sim))
+                return false;
+
+            const auto to = owner[model_index(flat->simulators.get_id(*sim))];
+            if (to < 0 || to >= partition_number)
+                return false;
+
+            values_capacity += 4 * sim->output_slots_number;
+        }
+    }
+
+    partitions.clear();
+    for (int i = 0; i != partition_number; ++i) {
+        partitions.emplace_back(
+          std::make_unique<timewarp_partition>(*this, i));
+        if (!partitions.back()->init(partition_number, values_capacity))
+            return false;
+    }
+
+    // A queue for each pair of partitions connected by at least one route.
+    {
+        Simulator* sim = nullptr;
+        while (flat->simulators.next(sim)) {
+            const auto id = flat->simulators.get_id(*sim);
+            const auto from = owner[model_index(id)];
+
+            for (int slot = 0; slot != sim->output_slots_number; ++slot) {
+                for (const auto& route : flat->get_routes(id, slot)) {
+                    const auto to = owner[model_index(route.simulator)];
+                    auto& queue = partitions[to]->queues[from];
+
+                    if (to == from || queue)
+                        continue;
+
+                    queue = std::make_unique<spsc_queue<timewarp_message>>();
+                    if (!queue->init(queue_capacity))
+                        return false;
+                }
+            }
+        }
+    }
+
+    local_minimum.assign(partition_number, start);
+    gvt.store(start);
+    gvt_round.store(0);
+    gvt_remaining.store(0);
+    gvt_active.store(false);
+    done.store(false);
+
+    flat->start = start;
+    flat->current = start;
+    flat->end = end;
+
+    Simulator* sim = nullptr;
+    while (flat->simulators.next(sim)) {
+        const auto id = flat->simulators.get_id(*sim);
+
+        const auto ta = flat->visit(
+          *sim, [this](auto& dyn) { return dyn.initialize(start); });
+
+        sim->tl = start;
+        sim->tn = start + static_cast<float>(ta);
+        partitions[owner[model_index(id)]]->events.insert(id, sim->tn);
+    }
+
+    return true;
+}
+
+void
+TimeWarp::run()
+{
+    std::vector<std::thread> threads;
+    threads.reserve(partitions.size() - 1);
+
+    for (std::size_t i = 1; i < partitions.size(); ++i)
+        threads.emplace_back([this, i]() { partitions[i]->run(); });
+
+    partitions[0]->run();
+
+    for (auto& thread : threads)
+        thread.join();
+
+    flat->current = end;
+}
+
+TimeWarpStatistics
+TimeWarp::statistics() const noexcept
+{
+    TimeWarpStatistics ret;
+
+    for (const auto& partition : partitions) {
+        ret.steps += partition->stats.steps;
+        ret.rollbacks += partition->stats.rollbacks;
+        ret.rolled_back_steps += partition->stats.rolled_back_steps;
+        ret.fossil_steps += partition->stats.fossil_steps;
+        ret.messages += partition->stats.messages;
+        ret.anti_messages += partition->stats.anti_messages;
+        ret.gvt_rounds += partition->stats.gvt_rounds;
+    }
+
+    return ret;
+}
+
+} // namespace irr
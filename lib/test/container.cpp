@@ -2,12 +2,24 @@
 // Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
 // http://www.boost.org/LICENSE_1_0.txt)
 
+#include <irritator/concurrent-data-array.hpp>
 #include <irritator/data-array.hpp>
 #include <irritator/data-list.hpp>
 #include <irritator/linker.hpp>
+#include <irritator/memory-resource.hpp>
+#include <irritator/parallel-algorithm.hpp>
 #include <irritator/string.hpp>
+#include <irritator/thread-pool.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
+
+#include <cstdint>
 
 #include <fmt/format.h>
 
@@ -173,6 +185,766 @@ TEST_CASE("check irr::data_array api", "[lib/container]")
     }
 }
 
+TEST_CASE("check irr::data_array identifier split", "[lib/container]")
+{
+    using id16 = irr::default_id_split<irr::ID>;
+    using id24 = irr::id_split<irr::ID, 24>;
+    using id28 = irr::id_split<irr::ID, 28>;
+
+    REQUIRE(id16::make_id(1u, 5) == 0x00010005u);
+    REQUIRE(id16::get_index(0x00010005u) == 5);
+    REQUIRE(id16::get_key(0x00010005u) == 1u);
+    REQUIRE(id16::max_size() == 65535);
+    REQUIRE(irr::get_key(irr::make_id<irr::ID>(3u, 7)) == 3u);
+    REQUIRE(irr::get_index(irr::make_id<irr::ID>(3u, 7)) == 7);
+
+    REQUIRE(id24::max_size() == (1 << 24) - 1);
+    REQUIRE(id24::max_key() == 255u);
+    REQUIRE(id24::get_index(id24::make_id(255u, 123456)) == 123456);
+    REQUIRE(id24::get_key(id24::make_id(255u, 123456)) == 255u);
+    REQUIRE(irr::default_id_split<irr::WID>::max_size() == INT32_MAX);
+
+    SECTION("default ID is limited to 65535 items")
+    {
+        irr::data_array<int, irr::ID> array;
+        REQUIRE(array.init(65535));
+        REQUIRE(!array.init(65536));
+    }
+
+    SECTION("WID addresses more than 65535 items")
+    {
+        constexpr int size = 100000;
+
+        irr::data_array<int, irr::WID> array;
+        REQUIRE(array.init(size));
+
+        for (int i = 0; i != size; ++i)
+            array.alloc() = i;
+
+        REQUIRE(array.full());
+
+        int* last = nullptr;
+        int number = 0;
+        while (array.next(last))
+            ++number;
+
+        REQUIRE(number == size);
+        REQUIRE(*last == size - 1);
+        REQUIRE(irr::get_index(array.get_id(*last)) == size - 1);
+        REQUIRE(array.try_to_get(array.get_id(*last)) == last);
+    }
+
+    SECTION("ID with 24 bits of index")
+    {
+        constexpr int size = 1 << 20;
+
+        irr::data_array<int, irr::ID, id24> array;
+        REQUIRE(array.init(size));
+
+        for (int i = 0; i != size; ++i)
+            array.alloc() = i;
+
+        REQUIRE(array.full());
+
+        auto& item = array.get(id24::make_id(1u, size - 1));
+        REQUIRE(item == size - 1);
+
+        const auto id = array.get_id(item);
+        REQUIRE(id24::get_index(id) == size - 1);
+        REQUIRE(array.try_to_get(id) == &item);
+
+        array.free(item);
+        REQUIRE(array.try_to_get(id) == nullptr);
+
+        auto& reused = array.alloc();
+        REQUIRE(&reused == &item);
+        REQUIRE(array.get_id(reused) != id);
+    }
+
+    SECTION("the key wraps to 1")
+    {
+        irr::data_array<int, irr::ID, id28> array;
+        REQUIRE(array.init(1));
+
+        for (int i = 0; i != 40; ++i) {
+            auto& item = array.alloc();
+            const auto key = id28::get_key(array.get_id(item));
+
+            REQUIRE(key >= 1u);
+            REQUIRE(key <= 15u);
+            REQUIRE(key == static_cast<unsigned>(i % 15 + 1));
+            array.free(item);
+        }
+    }
+}
+
+TEST_CASE("check irr::data_array free list", "[lib/container]")
+{
+    irr::data_array<int, irr::ID> array;
+    REQUIRE(array.init(8));
+
+    for (int i = 0; i != 8; ++i)
+        array.alloc() = i;
+
+    array.free(array.get(irr::make_id<irr::ID>(3u, 2)));
+    array.free(array.get(irr::make_id<irr::ID>(7u, 6)));
+
+    int* it = nullptr;
+    int sum = 0;
+    int number = 0;
+    while (array.next(it)) {
+        sum += *it;
+        ++number;
+    }
+
+    REQUIRE(number == 6);
+    REQUIRE(sum == 0 + 1 + 3 + 4 + 5 + 7);
+
+    auto& a = array.alloc();
+    auto& b = array.alloc();
+    REQUIRE(irr::get_index(array.get_id(a)) == 6);
+    REQUIRE(irr::get_index(array.get_id(b)) == 2);
+    REQUIRE(array.full());
+}
+
+TEST_CASE("check irr::data_array occupancy", "[lib/container]")
+{
+    constexpr int size = 10000;
+
+    irr::data_array<int, irr::ID> array;
+    REQUIRE(array.init(size));
+    REQUIRE(array.begin() == array.end());
+
+    for (int i = 0; i != size; ++i)
+        array.alloc() = i;
+
+    for (int i = 0; i != size; ++i)
+        if (i % 97 != 5)
+            array.free(array.get(irr::make_id<irr::ID>(1u, i)));
+
+    std::vector<int> with_next;
+    int* it = nullptr;
+    while (array.next(it))
+        with_next.emplace_back(*it);
+
+    std::vector<int> with_for;
+    for (auto& value : array)
+        with_for.emplace_back(value);
+
+    REQUIRE(with_next.size() == (size - 5 + 96) / 97);
+    REQUIRE(with_next == with_for);
+    for (auto value : with_next)
+        REQUIRE(value % 97 == 5);
+
+    REQUIRE(array.next_index(0) == 5);
+    REQUIRE(array.next_index(6) == 102);
+    REQUIRE(array.next_index(size) == array.max_used);
+
+    auto& reused = array.alloc();
+    reused = -1;
+    REQUIRE(std::count(array.begin(), array.end(), -1) == 1);
+
+    while (array.size() > 0)
+        array.free(*array.begin());
+
+    REQUIRE(array.begin() == array.end());
+}
+
+TEST_CASE("check irr::data_array separated identifiers", "[lib/container]")
+{
+    using strings = irr::data_array<std::string,
+                                    irr::ID,
+                                    irr::default_id_split<irr::ID>,
+                                    irr::separated_ids>;
+
+    strings array;
+    REQUIRE(array.init(1000));
+    REQUIRE(array.items != nullptr);
+    REQUIRE(array.ids != nullptr);
+
+    std::vector<irr::ID> ids;
+    for (int i = 0; i != 1000; ++i) {
+        auto& str = array.alloc(fmt::format("a long string to allocate {}", i));
+        ids.emplace_back(array.get_id(str));
+        REQUIRE(&array.get(ids.back()) == &str);
+        REQUIRE(irr::get_index(ids.back()) == i);
+    }
+
+    REQUIRE(array.full());
+    REQUIRE(array.ids[10] == ids[10]);
+
+    for (int i = 0; i < 1000; i += 3)
+        array.free(ids[i]);
+
+    for (int i = 0; i != 1000; ++i) {
+        if (i % 3)
+            REQUIRE(*array.try_to_get(ids[i]) ==
+                    fmt::format("a long string to allocate {}", i));
+        else
+            REQUIRE(array.try_to_get(ids[i]) == nullptr);
+    }
+
+    int number = 0;
+    for (auto& str : array) {
+        REQUIRE(array.try_to_get(array.get_id(str)) == &str);
+        ++number;
+    }
+    REQUIRE(number == array.size());
+
+    auto& reused = array.alloc("reused");
+    REQUIRE(irr::get_index(array.get_id(reused)) == 999);
+    REQUIRE(array.get_id(reused) != ids[999]);
+
+    array.clear();
+    REQUIRE(array.items == nullptr);
+    REQUIRE(array.ids == nullptr);
+}
+
+TEST_CASE("check irr::data_array compact", "[lib/container]")
+{
+    irr::data_array<std::string, irr::ID> array;
+    REQUIRE(array.init(100));
+
+    std::vector<irr::ID> ids;
+    for (int i = 0; i != 100; ++i)
+        ids.emplace_back(
+          array.get_id(array.alloc(fmt::format("a long string {}", i))));
+
+    for (int i = 0; i < 100; i += 3)
+        array.free(ids[i]);
+
+    irr::linker<irr::ID, irr::ID> links;
+    links.init(100);
+    for (int i = 0; i != 100; ++i)
+        links.emplace(ids[i], ids[99 - i]);
+
+    irr::data_list<irr::ID> list;
+    REQUIRE(list.init(100));
+    irr::ListID numbers;
+    for (int i = 0; i != 100; ++i)
+        numbers.push_back(list, ids[i]);
+
+    const auto remap = array.compact();
+
+    REQUIRE(array.size() == 66);
+    REQUIRE(array.max_used == 66);
+    REQUIRE(array.free_head == -1);
+
+    int index = 0;
+    for (int i = 0; i != 100; ++i) {
+        if (i % 3 == 0) {
+            REQUIRE(remap(ids[i]) == 0);
+            continue;
+        }
+
+        const auto id = remap(ids[i]);
+        REQUIRE(irr::get_index(id) == index++);
+        REQUIRE(irr::get_key(id) == irr::get_key(ids[i]));
+        REQUIRE(array.get(id) == fmt::format("a long string {}", i));
+        REQUIRE(array.try_to_get(ids[i]) == nullptr);
+    }
+
+    int number = 0;
+    for (auto& str : array) {
+        REQUIRE(irr::get_index(array.get_id(str)) == number);
+        ++number;
+    }
+    REQUIRE(number == 66);
+
+    links.remap_identifiers(remap);
+    links.remap_references(remap);
+    for (int i = 0; i != 100; ++i)
+        if (i % 3 && (99 - i) % 3)
+            REQUIRE(links[remap(ids[i])] == remap(ids[99 - i]));
+
+    numbers.remap(list, remap);
+    int i = 0;
+    for (auto id : numbers(list)) {
+        if (i % 3)
+            REQUIRE(array.get(id) == fmt::format("a long string {}", i));
+        else
+            REQUIRE(id == 0);
+        ++i;
+    }
+
+    auto& added = array.alloc("added");
+    REQUIRE(irr::get_index(array.get_id(added)) == 66);
+}
+
+namespace {
+
+struct throwing_item
+{
+    explicit throwing_item(bool fail)
+    {
+        if (fail)
+            throw std::runtime_error("throwing_item");
+    }
+};
+
+} // anonymous namespace
+
+TEST_CASE("check irr::concurrent_data_array", "[lib/container]")
+{
+    SECTION("throwing constructor")
+    {
+        // The index of a failed construction is given back: the only
+        // entry of the array is allocated after the exceptions.
+        irr::concurrent_data_array<throwing_item, irr::ID> array;
+        REQUIRE(array.init(1));
+
+        REQUIRE_THROWS(array.alloc(true));
+        REQUIRE(array.size() == 0);
+        auto* item = array.alloc(false);
+        REQUIRE(item);
+        REQUIRE(array.size() == 1);
+        REQUIRE(array.free(array.get_id(*item)));
+
+        {
+            decltype(array)::cache cache(array);
+            REQUIRE_THROWS(array.alloc(cache, true));
+            REQUIRE(array.alloc(cache, false));
+        }
+
+        REQUIRE(array.size() == 1);
+        REQUIRE(array.alloc(false) == nullptr);
+    }
+
+    SECTION("one thread")
+    {
+        irr::concurrent_data_array<std::string, irr::ID> array;
+        REQUIRE(array.init(3));
+
+        auto* a = array.alloc("a long string to allocate a");
+        auto* b = array.alloc("b");
+        auto* c = array.alloc("c");
+        REQUIRE(a);
+        REQUIRE(b);
+        REQUIRE(c);
+        REQUIRE(array.alloc("d") == nullptr);
+        REQUIRE(array.size() == 3);
+
+        const auto id = array.get_id(*b);
+        REQUIRE(irr::get_index(id) == 1);
+        REQUIRE(irr::get_key(id) == 1u);
+        REQUIRE(array.try_to_get(id) == b);
+        REQUIRE(array.free(id));
+        REQUIRE(!array.free(id));
+        REQUIRE(array.try_to_get(id) == nullptr);
+
+        int number = 0;
+        std::string* it = nullptr;
+        while (array.next(it))
+            ++number;
+        REQUIRE(number == 2);
+
+        auto* e = array.alloc("e");
+        REQUIRE(e == b);
+        REQUIRE(irr::get_key(array.get_id(*e)) == 2u);
+        REQUIRE(array.try_to_get(id) == nullptr);
+        REQUIRE(*array.try_to_get(array.get_id(*e)) == "e");
+    }
+
+    SECTION("threads with caches")
+    {
+        constexpr int threads = 4;
+        constexpr int loops = 20000;
+        constexpr int kept = 50;
+
+        irr::concurrent_data_array<std::int64_t, irr::ID> array;
+        REQUIRE(array.init(threads * (kept + 2 * array.cache_size)));
+
+        std::atomic<int> errors{ 0 };
+        std::vector<std::thread> workers;
+
+        for (int t = 0; t != threads; ++t) {
+            workers.emplace_back([&array, &errors, t]() {
+                decltype(array)::cache cache(array);
+                std::vector<irr::ID> ids;
+                std::vector<irr::ID> freed;
+
+                for (int i = 0; i != loops; ++i) {
+                    const std::int64_t value = t * 1000000 + i;
+                    auto* item = array.alloc(cache, value);
+                    if (!item) {
+                        ++errors;
+                        continue;
+                    }
+                    ids.emplace_back(array.get_id(*item));
+
+                    if (ids.size() > kept) {
+                        const auto id = ids[ids.size() - kept - 1];
+                        auto* old = array.try_to_get(id);
+                        if (!old || *old / 1000000 != t)
+                            ++errors;
+                        if (!array.free(cache, id))
+                            ++errors;
+                        freed.emplace_back(id);
+                    }
+
+                    if (i % 97 == 0)
+                        for (auto id : freed)
+                            if (array.try_to_get(id))
+                                ++errors;
+
+                    if (freed.size() > 16)
+                        freed.erase(freed.begin());
+                }
+            });
+        }
+
+        for (auto& worker : workers)
+            worker.join();
+
+        REQUIRE(errors == 0);
+        REQUIRE(array.size() == threads * kept);
+
+        int number = 0;
+        std::int64_t* it = nullptr;
+        while (array.next(it)) {
+            REQUIRE(*it % 1000000 >= loops - kept);
+            ++number;
+        }
+        REQUIRE(number == threads * kept);
+    }
+}
+
+TEST_CASE("check irr::parallel algorithms", "[lib/container]")
+{
+    constexpr int size = 100000;
+
+    irr::data_array<float, irr::WID> values;
+    REQUIRE(values.init(size));
+
+    for (int i = 0; i != size; ++i)
+        values.alloc(1.f / static_cast<float>(i + 1));
+
+    for (int i = 0; i < size; i += 7)
+        values.free(values.get(irr::make_id<irr::WID>(1u + i, i)));
+
+    float expected = 0.f;
+    for (auto value : values)
+        expected += value;
+
+    std::vector<float> sums;
+    std::vector<int> partitions;
+
+    for (int workers : { 1, 2, 3, 8 }) {
+        irr::thread_pool pool(workers);
+
+        irr::parallel_for_each(pool, values, [](float& x) { x *= 2.f; });
+        irr::parallel_for_each(pool, values, [](float& x) { x /= 2.f; });
+
+        sums.emplace_back(irr::parallel_transform_reduce(
+          pool,
+          values,
+          0.f,
+          [](float a, float b) { return a + b; },
+          [](float x) { return x; },
+          256));
+
+        const auto number = irr::parallel_transform_reduce(
+          pool,
+          values,
+          0,
+          [](int a, int b) { return a + b; },
+          [](float) { return 1; });
+        REQUIRE(number == values.size());
+
+        // A bool reduction with small chunks: the results of neighbouring
+        // chunks are written at once by several workers.
+        const auto all_positive = irr::parallel_transform_reduce(
+          pool,
+          values,
+          true,
+          [](bool a, bool b) { return a && b; },
+          [](float x) { return x > 0.f; },
+          8);
+        REQUIRE(all_positive);
+
+        const auto any_large = irr::parallel_transform_reduce(
+          pool,
+          values,
+          false,
+          [](bool a, bool b) { return a || b; },
+          [](float x) { return x > 1.f; },
+          8);
+        REQUIRE_FALSE(any_large);
+
+        std::vector<float> large, small;
+        partitions.emplace_back(irr::parallel_partition_copy(
+          pool, values, large, small, [](float x) { return x > 1e-3f; }));
+
+        REQUIRE(static_cast<int>(large.size()) == partitions.back());
+        REQUIRE(static_cast<int>(large.size() + small.size()) ==
+                values.size());
+        REQUIRE(std::is_sorted(large.rbegin(), large.rend()));
+        REQUIRE(std::is_sorted(small.rbegin(), small.rend()));
+    }
+
+    for (auto sum : sums) {
+        REQUIRE(sum == sums.front());
+        REQUIRE(sum == Approx(expected).epsilon(1e-3));
+    }
+
+    for (auto partition : partitions)
+        REQUIRE(partition == partitions.front());
+}
+
+TEST_CASE("check irr::paged_data_array", "[lib/container]")
+{
+    SECTION("pointers and identifiers stay valid")
+    {
+        constexpr int size = 5000;
+
+        irr::paged_data_array<int, irr::ID, irr::default_id_split<irr::ID>, 64>
+          array;
+        REQUIRE(array.init(0));
+        REQUIRE(array.capacity == 0);
+
+        std::vector<int*> pointers;
+        std::vector<irr::ID> ids;
+
+        for (int i = 0; i != size; ++i) {
+            auto& item = array.alloc(i);
+            pointers.emplace_back(&item);
+            ids.emplace_back(array.get_id(item));
+        }
+
+        REQUIRE(array.size() == size);
+        REQUIRE(array.capacity == (size + 63) / 64 * 64);
+        REQUIRE(array.pages.size() == (size + 63) / 64);
+
+        for (int i = 0; i != size; ++i) {
+            REQUIRE(array.try_to_get(ids[i]) == pointers[i]);
+            REQUIRE(*pointers[i] == i);
+        }
+
+        for (int i = 0; i < size; i += 2)
+            array.free(ids[i]);
+
+        REQUIRE(array.size() == size / 2);
+
+        for (int i = 0; i != size; ++i) {
+            if (i % 2)
+                REQUIRE(array.try_to_get(ids[i]) == pointers[i]);
+            else
+                REQUIRE(array.try_to_get(ids[i]) == nullptr);
+        }
+
+        int* it = nullptr;
+        int number = 0;
+        while (array.next(it)) {
+            REQUIRE(*it % 2 == 1);
+            ++number;
+        }
+        REQUIRE(number == size / 2);
+
+        for (int i = 0; i != size / 2; ++i)
+            array.alloc(-1);
+
+        REQUIRE(array.size() == size);
+        REQUIRE(array.capacity == (size + 63) / 64 * 64);
+        REQUIRE(array.try_to_get(irr::make_id<irr::ID>(1u, size + 64)) ==
+                nullptr);
+    }
+
+    SECTION("WID and default page size")
+    {
+        constexpr int size = 70000;
+
+        irr::paged_data_array<double, irr::WID> array;
+        REQUIRE(array.init(1000));
+        REQUIRE(array.capacity == 1024);
+
+        auto& first = array.alloc(1.0);
+        for (int i = 1; i != size; ++i)
+            array.alloc(static_cast<double>(i));
+
+        REQUIRE(array.size() == size);
+        REQUIRE(array.get(array.get_id(first)) == 1.0);
+        REQUIRE(irr::get_index(array.get_id(array.alloc(0.0))) == size);
+        REQUIRE(!array.full());
+    }
+
+    SECTION("items are constructed and destroyed")
+    {
+        irr::paged_data_array<std::string, irr::ID> array;
+        REQUIRE(array.init(16));
+
+        for (int i = 0; i != 2048; ++i)
+            array.alloc(fmt::format("a long string to allocate {}", i));
+
+        std::vector<irr::ID> ids;
+        std::string* it = nullptr;
+        while (array.next(it))
+            if (it->back() == '7')
+                ids.emplace_back(array.get_id(*it));
+
+        for (auto id : ids)
+            array.free(id);
+
+        REQUIRE(array.size() == 2048 - 205);
+
+        auto& str = array.alloc("reused");
+        REQUIRE(irr::get_index(array.get_id(str)) == 2047);
+
+        array.clear();
+        REQUIRE(array.size() == 0);
+        REQUIRE(array.pages.empty());
+    }
+
+    SECTION("try_alloc of a full array")
+    {
+        irr::data_array<int, irr::ID> fixed;
+        REQUIRE(fixed.init(3));
+
+        for (int i = 0; i != 3; ++i)
+            REQUIRE(fixed.try_alloc(i) != nullptr);
+
+        REQUIRE(fixed.full());
+        REQUIRE(fixed.try_alloc(3) == nullptr);
+        REQUIRE(fixed.try_alloc() == nullptr);
+        REQUIRE(fixed.size() == 3);
+
+        fixed.free(fixed.get(irr::make_id<irr::ID>(2u, 1)));
+        auto* item = fixed.try_alloc(4);
+        REQUIRE(item != nullptr);
+        REQUIRE(*item == 4);
+
+        using split = irr::id_split<irr::ID, 8>;
+        irr::paged_data_array<int, irr::ID, split, 64> paged;
+        REQUIRE(paged.init(0));
+
+        for (int i = 0; i != split::max_size(); ++i)
+            REQUIRE(paged.try_alloc(i) != nullptr);
+
+        REQUIRE(paged.full());
+        REQUIRE(paged.try_alloc(0) == nullptr);
+        REQUIRE(paged.size() == split::max_size());
+    }
+}
+
+TEST_CASE("check irr::page_memory_resource", "[lib/container]")
+{
+    constexpr int size = 1 << 18;
+
+    SECTION("containers on transparent huge pages")
+    {
+        irr::page_memory_resource resource(irr::huge_pages::transparent);
+
+        {
+            irr::data_array<int, irr::WID> array(&resource);
+            irr::array<double> column(size, &resource);
+            irr::data_list<irr::WID> list(&resource);
+            irr::pmr::linker<irr::WID, irr::WID> map(&resource);
+
+            REQUIRE(array.init(size));
+            REQUIRE(list.init(size));
+            map.init(size);
+
+            REQUIRE(resource.mapped() > 0);
+            REQUIRE(resource.mapped() % irr::huge_page_size == 0);
+            REQUIRE(reinterpret_cast<std::uintptr_t>(array.items) %
+                      irr::huge_page_size ==
+                    0);
+
+            irr::ListWID ids;
+            for (int i = 0; i != size; ++i) {
+                auto& item = array.alloc(i);
+                column[i] = static_cast<double>(i);
+                ids.push_back(list, array.get_id(item));
+                map.emplace(array.get_id(item), array.get_id(item));
+            }
+
+            int i = 0, errors = 0;
+            for (auto id : ids(list)) {
+                if (array.get(id) != i || map[id] != id ||
+                    column[i] != static_cast<double>(i))
+                    ++errors;
+                ++i;
+            }
+            REQUIRE(i == size);
+            REQUIRE(errors == 0);
+        }
+
+        REQUIRE(resource.mapped() == 0);
+    }
+
+    SECTION("small blocks come from the upstream resource")
+    {
+        irr::page_memory_resource resource(irr::huge_pages::transparent);
+        irr::data_array<int, irr::ID> array(&resource);
+
+        REQUIRE(array.init(16));
+        REQUIRE(resource.mapped() == 0);
+    }
+
+    SECTION("explicit huge pages fall back to transparent huge pages")
+    {
+        irr::page_memory_resource resource(irr::huge_pages::explicit_2mb);
+
+        {
+            irr::array<double> column(size, &resource);
+            REQUIRE(resource.mapped() == irr::huge_page_size);
+            REQUIRE(reinterpret_cast<std::uintptr_t>(column.items) %
+                      irr::huge_page_size ==
+                    0);
+
+            for (int i = 0; i != size; ++i)
+                column[i] = 1.0;
+        }
+
+        REQUIRE(resource.mapped() == 0);
+        REQUIRE(resource.fallbacks() <= 1);
+    }
+
+    SECTION("NUMA placement")
+    {
+        irr::thread_pool pool(4);
+        irr::page_memory_resource touched(irr::huge_pages::none,
+                                          irr::numa_policy::first_touch,
+                                          1u,
+                                          &pool,
+                                          4096);
+        irr::page_memory_resource bound(
+          irr::huge_pages::transparent, irr::numa_policy::bind, 1u);
+        irr::page_memory_resource interleaved(
+          irr::huge_pages::transparent, irr::numa_policy::interleave, 1u);
+
+        irr::data_array<double,
+                        irr::WID,
+                        irr::default_id_split<irr::WID>,
+                        irr::separated_ids>
+          a(&touched);
+        irr::data_array<double, irr::WID> b(&bound);
+        irr::data_array<double, irr::WID> c(&interleaved);
+
+        REQUIRE(a.init(size));
+        REQUIRE(b.init(size));
+        REQUIRE(c.init(size));
+        REQUIRE(touched.mapped() > 0);
+        REQUIRE(bound.mapped() > 0);
+        REQUIRE(interleaved.mapped() > 0);
+
+        for (int i = 0; i != size; ++i) {
+            a.alloc(1.0);
+            b.alloc(2.0);
+            c.alloc(3.0);
+        }
+
+        double sum = 0.0;
+        for (auto& x : a)
+            sum += x;
+        for (auto& x : b)
+            sum += x;
+        for (auto& x : c)
+            sum += x;
+
+        REQUIRE(sum == 6.0 * size);
+    }
+}
+
 TEST_CASE("check irr::data_list api", "[lib/container]")
 {
     struct x_position
@@ -262,6 +1034,289 @@ TEST_CASE("check irr::data_list api", "[lib/container]")
     REQUIRE(size == 1);
 }
 
+TEST_CASE("check irr::id_list size splice assign sort", "[lib/container]")
+{
+    irr::data_list<irr::ID> links;
+    REQUIRE(links.init(64));
+
+    auto to_vector = [&links](irr::ListID& ids) {
+        std::vector<irr::ID> ret;
+        for (auto id : ids(links))
+            ret.emplace_back(id);
+        return ret;
+    };
+
+    irr::ListID a, b;
+    const std::vector<irr::ID> values{ 5u, 3u, 8u, 1u };
+    a.assign(links, values.begin(), values.end());
+    REQUIRE(a.size() == 4);
+    REQUIRE(a.size(links) == 4);
+    REQUIRE(to_vector(a) == values);
+
+    b.push_back(links, 10u);
+    b.push_back(links, 11u);
+    b.push_front(links, 9u);
+    REQUIRE(b.size() == 3);
+
+    SECTION("splice a list at the end, at the front and in the middle")
+    {
+        a.splice(links, a.end(links), b);
+        REQUIRE(b.empty());
+        REQUIRE(b.size() == 0);
+        REQUIRE(a.size() == 7);
+        REQUIRE(to_vector(a) ==
+                std::vector<irr::ID>{ 5u, 3u, 8u, 1u, 9u, 10u, 11u });
+
+        b.push_back(links, 20u);
+        b.push_back(links, 21u);
+        a.splice(links, a.begin(links), b);
+        REQUIRE(a.size() == 9);
+        REQUIRE(to_vector(a) == std::vector<irr::ID>{
+                                  20u, 21u, 5u, 3u, 8u, 1u, 9u, 10u, 11u });
+
+        b.push_back(links, 30u);
+        auto it = a.begin(links);
+        ++it;
+        ++it;
+        a.splice(links, it, b);
+        REQUIRE(a.size() == 10);
+        const std::vector<irr::ID> expected{ 20u, 21u, 30u, 5u, 3u,
+                                             8u,  1u,  9u,  10u, 11u };
+        REQUIRE(to_vector(a) == expected);
+        REQUIRE(a.back(links) == 11u);
+    }
+
+    SECTION("splice one element")
+    {
+        auto it = a.begin(links);
+        ++it;
+        b.splice(links, b.end(links), a, it);
+        REQUIRE(a.size() == 3);
+        REQUIRE(b.size() == 4);
+        REQUIRE(to_vector(a) == std::vector<irr::ID>{ 5u, 8u, 1u });
+        REQUIRE(to_vector(b) == std::vector<irr::ID>{ 9u, 10u, 11u, 3u });
+
+        a.splice(links, a.begin(links), b, b.begin(links));
+        REQUIRE(to_vector(a) == std::vector<irr::ID>{ 9u, 5u, 8u, 1u });
+        REQUIRE(to_vector(b) == std::vector<irr::ID>{ 10u, 11u, 3u });
+    }
+
+    SECTION("sort and clear")
+    {
+        a.sort(links);
+        REQUIRE(to_vector(a) == std::vector<irr::ID>{ 1u, 3u, 5u, 8u });
+
+        a.sort(links, [](auto lhs, auto rhs) { return lhs > rhs; });
+        REQUIRE(to_vector(a) == std::vector<irr::ID>{ 8u, 5u, 3u, 1u });
+
+        a.pop_front(links);
+        a.erase(links, a.begin(links));
+        REQUIRE(a.size() == 2);
+
+        a.clear(links);
+        b.clear(links);
+        REQUIRE(a.size() == 0);
+        REQUIRE(a.empty());
+
+        // All the elements are back on the free list.
+        for (int i = 0; i != 64; ++i)
+            a.push_back(links, static_cast<irr::ID>(i + 1));
+        REQUIRE(a.size() == 64);
+    }
+}
+
+TEST_CASE("check irr::unrolled_id_list", "[lib/container]")
+{
+    irr::chunk_list<irr::ID> chunks;
+    REQUIRE(chunks.init(64));
+
+    auto to_vector = [&chunks](irr::UnrolledListID& ids) {
+        std::vector<irr::ID> ret;
+        for (auto id : ids(chunks))
+            ret.emplace_back(id);
+        return ret;
+    };
+
+    irr::UnrolledListID a, b;
+    std::vector<irr::ID> expected;
+
+    for (irr::ID i = 1; i != 101; ++i) {
+        a.push_back(chunks, i);
+        expected.emplace_back(i);
+    }
+
+    REQUIRE(a.size() == 100);
+    REQUIRE(chunks.size() == (100 + 13) / 14);
+    REQUIRE(to_vector(a) == expected);
+    REQUIRE(a.front(chunks) == 1u);
+    REQUIRE(a.back(chunks) == 100u);
+
+    SECTION("erase, push_front and clear with a predicate")
+    {
+        for (auto it = a.begin(chunks); it != a.end(chunks);) {
+            if (*it % 3 == 0)
+                it = a.erase(chunks, it);
+            else
+                ++it;
+        }
+
+        expected.erase(std::remove_if(expected.begin(),
+                                      expected.end(),
+                                      [](auto id) { return id % 3 == 0; }),
+                       expected.end());
+        REQUIRE(a.size() == static_cast<int>(expected.size()));
+        REQUIRE(to_vector(a) == expected);
+
+        a.push_front(chunks, 1000u);
+        expected.insert(expected.begin(), 1000u);
+        REQUIRE(to_vector(a) == expected);
+
+        a.clear(chunks, [](auto id) { return id % 2 == 0; });
+        expected.erase(std::remove_if(expected.begin(),
+                                      expected.end(),
+                                      [](auto id) { return id % 2 == 0; }),
+                       expected.end());
+        REQUIRE(a.size() == static_cast<int>(expected.size()));
+        REQUIRE(to_vector(a) == expected);
+        REQUIRE(chunks.size() == (a.size() + 13) / 14);
+
+        a.push_back(chunks, 2000u);
+        expected.emplace_back(2000u);
+        REQUIRE(to_vector(a) == expected);
+
+        a.clear(chunks, [](auto) { return true; });
+        REQUIRE(a.empty());
+        REQUIRE(chunks.size() == 0);
+    }
+
+    SECTION("erase all the identifiers of the chunks")
+    {
+        while (!a.empty())
+            a.pop_front(chunks);
+
+        REQUIRE(a.size() == 0);
+        REQUIRE(chunks.size() == 0);
+
+        a.push_back(chunks, 7u);
+        REQUIRE(to_vector(a) == std::vector<irr::ID>{ 7u });
+    }
+
+    SECTION("splice, assign, sort and remap")
+    {
+        const std::vector<irr::ID> values{ 300u, 200u, 100u };
+        b.assign(chunks, values.begin(), values.end());
+        a.splice(chunks, b);
+        REQUIRE(b.empty());
+        REQUIRE(a.size() == 103);
+
+        expected.insert(expected.end(), values.begin(), values.end());
+        REQUIRE(to_vector(a) == expected);
+
+        a.push_back(chunks, 400u);
+        expected.emplace_back(400u);
+        REQUIRE(to_vector(a) == expected);
+
+        a.sort(chunks, [](auto lhs, auto rhs) { return lhs > rhs; });
+        std::sort(expected.begin(), expected.end(), [](auto lhs, auto rhs) {
+            return lhs > rhs;
+        });
+        REQUIRE(to_vector(a) == expected);
+
+        a.remap(chunks, [](auto id) { return id + 1; });
+        for (auto& id : expected)
+            ++id;
+        REQUIRE(to_vector(a) == expected);
+
+        a.clear(chunks);
+        REQUIRE(chunks.size() == 0);
+    }
+}
+
+TEST_CASE("check irr::data_list growth and overflow", "[lib/container]")
+{
+    SECTION("data_list grows on demand")
+    {
+        irr::data_list<irr::ID> links;
+        irr::ListID a;
+
+        for (irr::ID i = 0; i != 1000; ++i)
+            REQUIRE(a.push_back(links, i));
+
+        REQUIRE(a.size() == 1000);
+        REQUIRE(a.front(links) == 0u);
+        REQUIRE(a.back(links) == 999u);
+
+        irr::ID expected = 0;
+        for (auto id : a(links))
+            REQUIRE(id == expected++);
+
+        auto stats = links.stats();
+        REQUIRE(stats.size == 1000);
+        REQUIRE(stats.high_water == 1000);
+        REQUIRE(stats.capacity >= 1000);
+        REQUIRE(stats.growths > 0);
+        REQUIRE(stats.overflows == 0);
+
+        a.clear(links);
+        stats = links.stats();
+        REQUIRE(stats.size == 0);
+        REQUIRE(stats.high_water == 1000);
+    }
+
+    SECTION("data_list stops at its max capacity")
+    {
+        irr::data_list<irr::ID> links;
+        REQUIRE(links.init(0, 300));
+        REQUIRE(!links.init(400, 300));
+        REQUIRE(links.init(0, 300));
+
+        irr::ListID a;
+        for (irr::ID i = 0; i != 300; ++i)
+            REQUIRE(a.push_back(links, i));
+
+        REQUIRE(links.full());
+        REQUIRE(!a.push_back(links, 300u));
+        REQUIRE(!a.push_front(links, 300u));
+        REQUIRE(a.size() == 300);
+        REQUIRE(a.back(links) == 299u);
+
+        auto stats = links.stats();
+        REQUIRE(stats.capacity == 300);
+        REQUIRE(stats.overflows == 2);
+
+        a.pop_front(links);
+        REQUIRE(!links.full());
+        REQUIRE(a.push_back(links, 300u));
+        REQUIRE(a.back(links) == 300u);
+    }
+
+    SECTION("chunk_list grows on demand and stops at its max capacity")
+    {
+        irr::chunk_list<irr::ID> chunks;
+        REQUIRE(chunks.init(0, 512));
+
+        irr::UnrolledListID a;
+        irr::ID i = 0;
+        for (; i != 512 * 14; ++i)
+            REQUIRE(a.push_back(chunks, i));
+
+        REQUIRE(chunks.full());
+        REQUIRE(!a.push_back(chunks, i));
+        REQUIRE(a.size() == 512 * 14);
+
+        irr::ID expected = 0;
+        for (auto id : a(chunks))
+            REQUIRE(id == expected++);
+
+        const auto stats = chunks.stats();
+        REQUIRE(stats.size == 512);
+        REQUIRE(stats.high_water == 512);
+        REQUIRE(stats.capacity == 512);
+        REQUIRE(stats.growths == 2);
+        REQUIRE(stats.overflows == 1);
+    }
+}
+
 TEST_CASE("check irr::linker api", "[lib/container]")
 {
     struct position
@@ -327,3 +1382,210 @@ TEST_CASE("check irr::linker api", "[lib/container]")
     REQUIRE(single[pos.get_id(pos.get(1))] == dirs.get_id(dirs.get(2)));
     REQUIRE(single[pos.get_id(pos.get(2))] == dirs.get_id(dirs.get(3)));
 }
+
+TEST_CASE("check irr::multi_linker compact and freeze", "[lib/container]")
+{
+    struct node
+    {
+        int value;
+    };
+
+    irr::data_array<node, irr::ID> nodes;
+    irr::multi_linker<irr::ID, irr::ID> children;
+    nodes.init(16);
+    children.init(16);
+
+    std::vector<irr::ID> ids;
+    for (int i = 0; i != 8; ++i) {
+        auto& n = nodes.alloc();
+        n.value = i;
+        ids.emplace_back(nodes.get_id(n));
+    }
+
+    auto values = [&](irr::ID parent) {
+        std::vector<int> ret;
+        for (auto& child : children.get_view(parent, nodes))
+            ret.emplace_back(child.value);
+        return ret;
+    };
+
+    // The links are pushed in front of the list of the parent.
+    for (int i = 1; i != 4; ++i)
+        children.emplace(ids[0], ids[i]);
+    for (int i = 4; i != 8; ++i)
+        children.emplace(ids[1], ids[i]);
+
+    REQUIRE(children.size() == 7);
+    REQUIRE(values(ids[0]) == std::vector<int>{ 3, 2, 1 });
+    REQUIRE(values(ids[1]) == std::vector<int>{ 7, 6, 5, 4 });
+    REQUIRE(values(ids[2]).empty());
+
+    SECTION("erase and destroy reuse the nodes")
+    {
+        REQUIRE(children.erase(ids[1], ids[6]));
+        REQUIRE(!children.erase(ids[1], ids[6]));
+        REQUIRE(values(ids[1]) == std::vector<int>{ 7, 5, 4 });
+
+        children.destroy(ids[0]);
+        REQUIRE(values(ids[0]).empty());
+        REQUIRE(children.size() == 3);
+
+        children.emplace(ids[2], ids[3]);
+        REQUIRE(children.size() == 4);
+        REQUIRE(values(ids[2]) == std::vector<int>{ 3 });
+        REQUIRE(values(ids[1]) == std::vector<int>{ 7, 5, 4 });
+    }
+
+    SECTION("compact removes the links to freed items")
+    {
+        nodes.free(ids[2]);
+        nodes.free(ids[5]);
+
+        REQUIRE(values(ids[0]) == std::vector<int>{ 3, 1 });
+        REQUIRE(values(ids[1]) == std::vector<int>{ 7, 6, 4 });
+        REQUIRE(children.size() == 7);
+
+        children.destroy(ids[0]);
+        children.compact(nodes);
+        REQUIRE(children.size() == 3);
+        REQUIRE(values(ids[1]) == std::vector<int>{ 7, 6, 4 });
+
+        children.emplace(ids[3], ids[4]);
+        REQUIRE(values(ids[3]) == std::vector<int>{ 4 });
+    }
+
+    SECTION("freeze and thaw")
+    {
+        children.compact();
+        children.freeze();
+        REQUIRE(children.frozen());
+        REQUIRE(children.size() == 7);
+
+        const auto range = children.get_range(ids[1]);
+        REQUIRE(range.size() == 4);
+        REQUIRE(std::vector<irr::ID>(range.begin(), range.end()) ==
+                std::vector<irr::ID>{ ids[7], ids[6], ids[5], ids[4] });
+        REQUIRE(children.get_range(ids[2]).empty());
+
+        nodes.free(ids[1]);
+        REQUIRE(values(ids[0]) == std::vector<int>{ 3, 2 });
+        REQUIRE(values(ids[1]) == std::vector<int>{ 7, 6, 5, 4 });
+        REQUIRE(values(ids[2]).empty());
+
+        children.thaw();
+        REQUIRE(!children.frozen());
+        REQUIRE(values(ids[0]) == std::vector<int>{ 3, 2 });
+        REQUIRE(values(ids[1]) == std::vector<int>{ 7, 6, 5, 4 });
+
+        children.emplace(ids[0], ids[7]);
+        REQUIRE(values(ids[0]) == std::vector<int>{ 7, 3, 2 });
+        REQUIRE(children.size() == 8);
+    }
+}
+
+TEST_CASE("check irr::sparse_linker", "[lib/container]")
+{
+    struct observer
+    {
+        int value;
+    };
+
+    irr::data_array<observer, irr::ID> observers;
+    observers.init(4);
+    auto& obs = observers.alloc();
+    obs.value = 42;
+    const auto obs_id = observers.get_id(obs);
+
+    SECTION("a few entries in the WID space")
+    {
+        irr::sparse_linker<irr::WID, irr::ID> bindings;
+
+        const auto a = irr::default_id_split<irr::WID>::make_id(1u, 7);
+        const auto b =
+          irr::default_id_split<irr::WID>::make_id(1u, 0xfffffff0);
+
+        REQUIRE(bindings.size() == 0);
+        REQUIRE(bindings[a] == 0u);
+        REQUIRE(bindings.try_to_get(&observers, a) == nullptr);
+
+        bindings.emplace(a, obs_id);
+        bindings[b] = 123u;
+        REQUIRE(bindings.size() == 2);
+        REQUIRE(bindings.capacity() == 16);
+        REQUIRE(bindings[a] == obs_id);
+        REQUIRE(bindings[b] == 123u);
+        REQUIRE(bindings.try_to_get(&observers, a) == &obs);
+        REQUIRE(bindings.try_to_get(&observers, b) == nullptr);
+
+        bindings.destroy(a);
+        REQUIRE(bindings.size() == 1);
+        REQUIRE(bindings[a] == 0u);
+        REQUIRE(bindings[b] == 123u);
+    }
+
+    SECTION("grows and erases with a std::map as reference")
+    {
+        irr::sparse_linker<irr::WID, irr::ID> bindings;
+        std::map<irr::WID, irr::ID> expected;
+        std::uint64_t state = 12345u;
+
+        // A linear congruential generator: the sequence does not depend on
+        // the standard library.
+        auto next = [&state]() {
+            state = state * 6364136223846793005u + 1442695040888963407u;
+            return static_cast<std::uint32_t>(state >> 33);
+        };
+
+        for (int i = 0; i != 20000; ++i) {
+            const auto id = irr::default_id_split<irr::WID>::make_id(
+              1u, static_cast<int>(next() % 4096u));
+            const auto value = static_cast<irr::ID>(i + 1);
+
+            if (next() % 3u == 0u) {
+                bindings.destroy(id);
+                expected.erase(id);
+            } else {
+                bindings.emplace(id, value);
+                expected[id] = value;
+            }
+        }
+
+        REQUIRE(bindings.size() == static_cast<int>(expected.size()));
+        REQUIRE(bindings.capacity() * 7 >= bindings.size() * 8);
+
+        for (std::uint32_t index = 0; index != 4096u; ++index) {
+            const auto id = irr::default_id_split<irr::WID>::make_id(
+              1u, static_cast<int>(index));
+            const auto it = expected.find(id);
+            REQUIRE(bindings[id] == (it == expected.end() ? 0u : it->second));
+        }
+    }
+
+    SECTION("remap after a compaction")
+    {
+        irr::data_array<observer, irr::ID> models;
+        models.init(8);
+
+        std::vector<irr::ID> ids;
+        for (int i = 0; i != 4; ++i)
+            ids.emplace_back(models.get_id(models.alloc()));
+
+        irr::sparse_linker<irr::ID, irr::ID> bindings;
+        bindings.init(4);
+        REQUIRE(bindings.capacity() == 16);
+
+        bindings[ids[1]] = 10u;
+        bindings[ids[3]] = obs_id;
+
+        models.free(ids[0]);
+        models.free(ids[1]);
+        const auto remap = models.compact();
+        bindings.remap_identifiers(remap);
+
+        REQUIRE(bindings.size() == 1);
+        REQUIRE(bindings[remap(ids[3])] == obs_id);
+
+        bindings.remap_references([](irr::ID id) { return id + 1; });
+        REQUIRE(bindings[remap(ids[3])] == obs_id + 1);
+    }
+}
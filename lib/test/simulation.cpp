@@ -0,0 +1,1853 @@
+// Copyright (c) 2019 INRA Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include <irritator/conservative.hpp>
+#include <irritator/data-array.hpp>
+#include <irritator/scheduler.hpp>
+#include <irritator/simulation.hpp>
+#include <irritator/spsc-queue.hpp>
+#include <irritator/thread-pool.hpp>
+#include <irritator/timewarp.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "catch.hpp"
+
+TEST_CASE("check irr::heap api", "[lib/scheduler]")
+{
+    irr::data_array<irr::Simulator, irr::ID> simulators;
+    irr::heap<float> h;
+
+    REQUIRE(simulators.init(16));
+    REQUIRE(h.init(simulators.capacity));
+    REQUIRE(h.empty());
+    REQUIRE(h.tn() == std::numeric_limits<float>::infinity());
+
+    const float times[] = { 5.f, 3.f, 8.f, 1.f, 3.f, 9.f, 0.5f, 3.f };
+    std::vector<irr::ID> ids;
+
+    for (auto t : times) {
+        auto& sim = simulators.alloc();
+        sim.tn = t;
+        ids.push_back(simulators.get_id(sim));
+        h.insert(ids.back(), t);
+    }
+
+    REQUIRE(h.size() == 8);
+    REQUIRE(h.tn() == 0.5f);
+    REQUIRE(h.top() == ids[6]);
+
+    h.update(ids[6], 4.f);
+    REQUIRE(h.tn() == 1.f);
+    REQUIRE(h.top() == ids[3]);
+
+    h.update(ids[2], 0.f);
+    REQUIRE(h.top() == ids[2]);
+
+    h.erase(ids[2]);
+    REQUIRE(!h.is_in_tree(ids[2]));
+    REQUIRE(h.size() == 7);
+
+    REQUIRE(h.pop() == ids[3]);
+    REQUIRE(h.tn() == 3.f);
+
+    std::vector<irr::ID> imminent;
+    h.pop(imminent);
+    REQUIRE(imminent.size() == 3);
+    REQUIRE(h.tn() == 4.f);
+
+    float previous = h.tn();
+    while (!h.empty()) {
+        REQUIRE(previous <= h.tn());
+        previous = h.tn();
+        h.pop();
+    }
+
+    simulators.free(ids[0]);
+    auto& reused = simulators.alloc();
+    REQUIRE(irr::get_index(simulators.get_id(reused)) ==
+            irr::get_index(ids[0]));
+    REQUIRE(!h.is_in_tree(simulators.get_id(reused)));
+    h.insert(simulators.get_id(reused), 2.f);
+    REQUIRE(h.top() == simulators.get_id(reused));
+}
+
+TEST_CASE("check irr::calendar api", "[lib/scheduler]")
+{
+    irr::data_array<irr::Simulator, irr::ID> simulators;
+    irr::calendar<float> c;
+
+    REQUIRE(simulators.init(1024));
+    REQUIRE(c.init(simulators.capacity));
+    REQUIRE(c.empty());
+    REQUIRE(c.tn() == std::numeric_limits<float>::infinity());
+
+    std::vector<irr::ID> ids;
+    for (int i = 0; i != 1000; ++i) {
+        auto& sim = simulators.alloc();
+        sim.tn = static_cast<float>((i * 7919) % 1000) * 0.25f;
+        ids.push_back(simulators.get_id(sim));
+        c.insert(ids.back(), sim.tn);
+    }
+
+    REQUIRE(c.size() == 1000);
+    REQUIRE(c.buckets() > 2);
+    REQUIRE(c.tn() == 0.f);
+
+    c.update(ids[1], -1.f);
+    REQUIRE(c.top() == ids[1]);
+    c.erase(ids[1]);
+    REQUIRE(!c.is_in_tree(ids[1]));
+
+    c.insert(ids[1], std::numeric_limits<float>::infinity());
+    REQUIRE(c.size() == 1000);
+
+    float previous = c.tn();
+    int popped = 0;
+    while (c.tn() < std::numeric_limits<float>::infinity()) {
+        REQUIRE(previous <= c.tn());
+        previous = c.tn();
+
+        // Reschedule some entries in the future as a transition does.
+        const auto id = c.pop();
+        if (popped++ % 3 == 0 && previous < 200.f)
+            c.insert(id, previous + 50.f);
+    }
+
+    REQUIRE(c.size() == 1);
+    REQUIRE(c.top() == ids[1]);
+}
+
+TEST_CASE("check irr::scheduler backends", "[lib/scheduler]")
+{
+    irr::scheduler<float> heap, calendar;
+
+    REQUIRE(heap.init(256, irr::scheduler_type::heap));
+    REQUIRE(calendar.init(256, irr::scheduler_type::calendar));
+    REQUIRE(heap.type() == irr::scheduler_type::heap);
+    REQUIRE(calendar.type() == irr::scheduler_type::calendar);
+
+    for (int i = 0; i != 256; ++i) {
+        const auto id = irr::make_id<irr::ID>(1u, i);
+        const auto tn = static_cast<float>((i * 31) % 17);
+        heap.insert(id, tn);
+        calendar.insert(id, tn);
+    }
+
+    std::vector<irr::ID> imminent_heap, imminent_calendar;
+    while (!heap.empty()) {
+        REQUIRE(heap.tn() == calendar.tn());
+
+        const auto t = heap.tn();
+        imminent_heap.clear();
+        imminent_calendar.clear();
+        heap.pop(imminent_heap);
+        calendar.pop(imminent_calendar);
+
+        std::sort(imminent_heap.begin(), imminent_heap.end());
+        std::sort(imminent_calendar.begin(), imminent_calendar.end());
+        REQUIRE(imminent_heap == imminent_calendar);
+
+        for (auto id : imminent_heap) {
+            if (t < 40.f) {
+                heap.insert(id, t + 20.f);
+                calendar.insert(id, t + 20.f);
+            }
+        }
+    }
+
+    REQUIRE(calendar.empty());
+}
+
+static irr::ID
+make_node(irr::Model& model,
+          irr::ID parent,
+          irr::Node::model_type type,
+          int inputs,
+          int outputs)
+{
+    auto& node = model.nodes.alloc();
+    node.parent = parent;
+    node.type = type;
+    node.input_slots_number = inputs;
+    node.output_slots_number = outputs;
+
+    auto id = model.nodes.get_id(node);
+    if (parent)
+        model.nodes.get(parent).children.push_back(model.chunks, id);
+
+    return id;
+}
+
+static void
+make_connection(irr::Model& model,
+                irr::ID parent,
+                irr::ID output_model,
+                irr::ID output_slot,
+                irr::ID input_model,
+                irr::ID input_slot)
+{
+    auto& cnx = model.connections.alloc();
+    cnx.output_model = output_model;
+    cnx.output_slot = output_slot;
+    cnx.input_model = input_model;
+    cnx.input_slot = input_slot;
+
+    model.nodes.get(parent).connections.push_back(
+      model.chunks, model.connections.get_id(cnx));
+}
+
+TEST_CASE("check irr::FlatSimulation flattening", "[lib/simulation]")
+{
+    using type = irr::Node::model_type;
+
+    irr::Model model(64);
+
+    // top: a -> c.0, c.0 -> a
+    // c: c.0 -> b, c.0 -> d, b -> c.0
+    const auto top = make_node(model, 0, type::coupled, 0, 0);
+    const auto a = make_node(model, top, type::atomic, 1, 1);
+    const auto c = make_node(model, top, type::coupled, 1, 1);
+    const auto b = make_node(model, c, type::atomic, 1, 1);
+    const auto d = make_node(model, c, type::atomic, 1, 0);
+
+    make_connection(model, top, a, 0, c, 0);
+    make_connection(model, top, c, 0, a, 0);
+    make_connection(model, c, c, 0, b, 0);
+    make_connection(model, c, c, 0, d, 0);
+    make_connection(model, c, b, 0, c, 0);
+
+    irr::FlatSimulation flat;
+    REQUIRE(flat.init(model) == irr::status::simulation_flat_success);
+    REQUIRE(flat.model == top);
+    REQUIRE(flat.simulators.size() == 3);
+
+    irr::ID sim_a = 0, sim_b = 0, sim_d = 0;
+    irr::Simulator* sim = nullptr;
+    while (flat.simulators.next(sim)) {
+        if (sim->node == a)
+            sim_a = flat.simulators.get_id(*sim);
+        else if (sim->node == b)
+            sim_b = flat.simulators.get_id(*sim);
+        else if (sim->node == d)
+            sim_d = flat.simulators.get_id(*sim);
+    }
+
+    REQUIRE(irr::valid(sim_a));
+    REQUIRE(irr::valid(sim_b));
+    REQUIRE(irr::valid(sim_d));
+
+    auto from_a = flat.get_routes(sim_a, 0);
+    REQUIRE(from_a.size() == 2);
+    for (const auto& route : from_a) {
+        REQUIRE((route.simulator == sim_b || route.simulator == sim_d));
+        REQUIRE(route.slot == 0);
+    }
+
+    auto from_b = flat.get_routes(sim_b, 0);
+    REQUIRE(from_b.size() == 1);
+    REQUIRE(from_b.begin()->simulator == sim_a);
+
+    make_connection(model, c, d, 0, c, 0);
+    REQUIRE(flat.init(model) == irr::status::simulation_flat_bad_connection);
+}
+
+TEST_CASE("check irr::Model with more than 65535 nodes", "[lib/simulation]")
+{
+    using type = irr::Node::model_type;
+
+    // More nodes than the 16 bits of index of the default split of ID.
+    constexpr int size = 70000;
+
+    irr::Model model(size + 2);
+    const auto top = make_node(model, 0, type::coupled, 0, 0);
+    const auto cnt = make_node(model, top, type::atomic, 1, 0);
+
+    std::vector<irr::ID> sources;
+    for (int i = 0; i != size; ++i)
+        sources.emplace_back(make_node(model, top, type::atomic, 0, 1));
+
+    REQUIRE(model.nodes.size() == size + 2);
+    REQUIRE(irr::model_index(sources.back()) == size + 1);
+
+    int connected = 0;
+    for (int i = 0; i < size; i += 1000) {
+        make_connection(model, top, sources[i], 0, cnt, 0);
+        ++connected;
+    }
+    make_connection(model, top, sources.back(), 0, cnt, 0);
+    ++connected;
+
+    irr::FlatSimulation flat;
+    REQUIRE(flat.init(model) == irr::status::simulation_flat_success);
+    REQUIRE(flat.simulators.size() == size + 1);
+
+    irr::counter* received = nullptr;
+    irr::Simulator* sim = nullptr;
+    while (flat.simulators.next(sim)) {
+        if (sim->node == cnt)
+            received = flat.alloc_dynamics<irr::counter>(*sim);
+        else
+            flat.alloc_dynamics<irr::constant>(*sim)->offset = 1.0;
+    }
+
+    REQUIRE(received);
+    REQUIRE(flat.initialize(0.f, 10.f));
+    flat.run();
+
+    REQUIRE(received->number == connected);
+}
+
+TEST_CASE("check irr::Model compact", "[lib/simulation]")
+{
+    using type = irr::Node::model_type;
+
+    irr::Model model(64);
+    std::vector<irr::ID> garbage;
+
+    // The same model than the flattening test with freed nodes and
+    // connections between the nodes and the connections.
+    const auto top = make_node(model, 0, type::coupled, 0, 0);
+    garbage.emplace_back(make_node(model, 0, type::atomic, 0, 0));
+    const auto a = make_node(model, top, type::atomic, 1, 1);
+    garbage.emplace_back(make_node(model, 0, type::atomic, 0, 0));
+    garbage.emplace_back(make_node(model, 0, type::atomic, 0, 0));
+    const auto c = make_node(model, top, type::coupled, 1, 1);
+    const auto b = make_node(model, c, type::atomic, 1, 1);
+    garbage.emplace_back(make_node(model, 0, type::atomic, 0, 0));
+    const auto d = make_node(model, c, type::atomic, 1, 0);
+
+    make_connection(model, top, a, 0, c, 0);
+    model.connections.alloc();
+    make_connection(model, top, c, 0, a, 0);
+    make_connection(model, c, c, 0, b, 0);
+    model.connections.alloc();
+    model.connections.alloc();
+    make_connection(model, c, c, 0, d, 0);
+    make_connection(model, c, b, 0, c, 0);
+
+    for (auto id : garbage)
+        model.nodes.free(id);
+
+    model.connections.free(irr::model_id_split::make_id(2u, 1));
+    model.connections.free(irr::model_id_split::make_id(5u, 4));
+    model.connections.free(irr::model_id_split::make_id(6u, 5));
+
+    auto& cnd = model.conditions.alloc("value");
+    cnd.type = irr::Condition::condition_type::real64;
+    model.real64s.free(model.real64s.alloc(1.0));
+    cnd.value = model.real64s.get_id(model.real64s.alloc(2.0));
+    model.nodes.get(b).conditions.push_back(model.chunks,
+                                            model.conditions.get_id(cnd));
+
+    REQUIRE(model.nodes.max_used == 9);
+    REQUIRE(model.connections.max_used == 8);
+
+    const auto remap = model.compact();
+
+    REQUIRE(model.nodes.max_used == 5);
+    REQUIRE(model.nodes.size() == 5);
+    REQUIRE(model.connections.max_used == 5);
+    REQUIRE(model.real64s.max_used == 1);
+
+    REQUIRE(irr::model_index(remap.nodes(a)) == 1);
+    REQUIRE(irr::model_index(remap.nodes(d)) == 4);
+    REQUIRE(remap.nodes(garbage[0]) == 0);
+    REQUIRE(model.nodes.try_to_get(remap.nodes(top)) ==
+            &model.nodes.get(remap.nodes(top)));
+    REQUIRE(model.nodes.get(remap.nodes(b)).parent == remap.nodes(c));
+
+    int children = 0;
+    for (auto child : model.nodes.get(remap.nodes(c)).children(model.chunks)) {
+        REQUIRE((child == remap.nodes(b) || child == remap.nodes(d)));
+        ++children;
+    }
+    REQUIRE(children == 2);
+
+    for (auto cnd_id :
+         model.nodes.get(remap.nodes(b)).conditions(model.chunks)) {
+        const auto& condition = model.conditions.get(cnd_id);
+        REQUIRE(model.real64s.get(condition.value) == 2.0);
+    }
+
+    irr::FlatSimulation flat;
+    REQUIRE(flat.init(model) == irr::status::simulation_flat_success);
+    REQUIRE(flat.model == remap.nodes(top));
+    REQUIRE(flat.simulators.size() == 3);
+
+    irr::Simulator* sim = nullptr;
+    while (flat.simulators.next(sim)) {
+        const auto id = flat.simulators.get_id(*sim);
+        if (sim->node == remap.nodes(a))
+            REQUIRE(flat.get_routes(id, 0).size() == 2);
+        else if (sim->node == remap.nodes(b))
+            REQUIRE(flat.get_routes(id, 0).size() == 1);
+        else
+            REQUIRE(sim->node == remap.nodes(d));
+    }
+}
+
+TEST_CASE("check irr::Model freeze", "[lib/simulation]")
+{
+    using type = irr::Node::model_type;
+
+    irr::Model model(64);
+
+    const auto top = make_node(model, 0, type::coupled, 0, 0);
+    const auto a = make_node(model, top, type::atomic, 1, 1);
+    const auto c = make_node(model, top, type::coupled, 1, 1);
+    const auto b = make_node(model, c, type::atomic, 1, 1);
+    const auto d = make_node(model, c, type::atomic, 1, 0);
+
+    make_connection(model, top, a, 0, c, 0);
+    make_connection(model, top, c, 0, a, 0);
+    make_connection(model, c, c, 0, b, 0);
+    make_connection(model, c, c, 0, d, 0);
+    make_connection(model, c, b, 0, c, 0);
+
+    auto& cnd = model.conditions.alloc("value");
+    const auto cnd_id = model.conditions.get_id(cnd);
+    model.nodes.get(b).conditions.push_back(model.chunks, cnd_id);
+    auto& view = model.views.alloc();
+    view.conditions.push_back(model.chunks, cnd_id);
+
+    model.freeze();
+    REQUIRE(model.frozen());
+    REQUIRE(model.nodes.get(c).children.empty());
+    REQUIRE(model.chunks.size() == 0);
+
+    const auto children = model.children_of(model.nodes.get(c));
+    REQUIRE(children.size() == 2);
+    REQUIRE(children[0] == b);
+    REQUIRE(children[1] == d);
+    REQUIRE(model.connections_of(model.nodes.get(top)).size() == 2);
+    REQUIRE(model.connections_of(model.nodes.get(c)).size() == 3);
+    REQUIRE(model.connections_of(model.nodes.get(a)).empty());
+    REQUIRE(model.conditions_of(model.nodes.get(b)).size() == 1);
+    REQUIRE(model.conditions_of(view).size() == 1);
+    REQUIRE(*model.conditions_of(view).begin() == cnd_id);
+
+    irr::FlatSimulation flat;
+    REQUIRE(flat.init(model) == irr::status::simulation_flat_success);
+    REQUIRE(flat.simulators.size() == 3);
+
+    irr::Simulator* sim = nullptr;
+    while (flat.simulators.next(sim)) {
+        const auto id = flat.simulators.get_id(*sim);
+        if (sim->node == a)
+            REQUIRE(flat.get_routes(id, 0).size() == 2);
+        else if (sim->node == b)
+            REQUIRE(flat.get_routes(id, 0).size() == 1);
+    }
+
+    const auto file = std::filesystem::temp_directory_path() /
+                      "irritator-check-freeze.snapshot";
+    REQUIRE(model.write_snapshot(file) == irr::status::snapshot_model_frozen);
+
+    model.thaw();
+    REQUIRE(!model.frozen());
+
+    std::vector<irr::ID> thawed;
+    for (auto id : model.nodes.get(c).children(model.chunks))
+        thawed.emplace_back(id);
+    REQUIRE(thawed == std::vector<irr::ID>{ b, d });
+    REQUIRE(model.nodes.get(c).connections.size() == 3);
+    REQUIRE(model.nodes.get(b).conditions.size() == 1);
+    REQUIRE(view.conditions.size() == 1);
+
+    model.freeze();
+    model.nodes.free(a);
+    const auto remap = model.compact();
+    REQUIRE(model.frozen());
+    REQUIRE(model.children_of(model.nodes.get(remap.nodes(c))).size() == 2);
+    REQUIRE(model.children_of(model.nodes.get(remap.nodes(c)))[0] ==
+            remap.nodes(b));
+}
+
+TEST_CASE("check irr::Model snapshot", "[lib/simulation]")
+{
+    using type = irr::Node::model_type;
+
+    const auto file_name =
+      std::filesystem::temp_directory_path() / "irritator-snapshot.bin";
+
+    irr::Model model(64);
+    model.name = "snapshot";
+    model.author = "irritator";
+    model.version_major = 1;
+    model.version_minor = 2;
+    model.version_patch = 3;
+
+    const auto top = make_node(model, 0, type::coupled, 0, 0);
+    const auto garbage = make_node(model, 0, type::atomic, 0, 0);
+    const auto a = make_node(model, top, type::atomic, 1, 1);
+    const auto b = make_node(model, top, type::atomic, 1, 1);
+    make_connection(model, top, a, 0, b, 0);
+    make_connection(model, top, b, 0, a, 0);
+    model.nodes.free(garbage);
+
+    auto& cnd = model.conditions.alloc("text");
+    cnd.type = irr::Condition::condition_type::string;
+    cnd.value = model.strings.get_id(
+      model.strings.alloc("a string longer than the small buffer"));
+    model.strings.free(model.strings.alloc("a freed string"));
+    model.nodes.get(a).conditions.push_back(model.chunks,
+                                            model.conditions.get_id(cnd));
+    model.real64s.alloc(3.5);
+
+    REQUIRE(model.write_snapshot(file_name) ==
+            irr::status::snapshot_write_success);
+
+    irr::Model copy(16);
+    REQUIRE(copy.read_snapshot(file_name) ==
+            irr::status::snapshot_read_success);
+
+    REQUIRE(copy.name == model.name);
+    REQUIRE(copy.author == model.author);
+    REQUIRE(copy.version_minor == 2);
+    REQUIRE(copy.nodes.capacity == model.nodes.capacity);
+    REQUIRE(copy.nodes.size() == 3);
+    REQUIRE(copy.nodes.try_to_get(garbage) == nullptr);
+    REQUIRE(copy.nodes.get(b).parent == top);
+    REQUIRE(copy.connections.size() == 2);
+    REQUIRE(copy.strings.size() == 1);
+    REQUIRE(copy.real64s.get(irr::model_id_split::make_id(1u, 0)) == 3.5);
+
+    int conditions = 0;
+    for (auto id : copy.nodes.get(a).conditions(copy.chunks)) {
+        const auto& condition = copy.conditions.get(id);
+        REQUIRE(copy.strings.get(condition.value) ==
+                "a string longer than the small buffer");
+        ++conditions;
+    }
+    REQUIRE(conditions == 1);
+
+    int children = 0;
+    for (auto child : copy.nodes.get(top).children(copy.chunks)) {
+        REQUIRE((child == a || child == b));
+        ++children;
+    }
+    REQUIRE(children == 2);
+
+    // The free lists are restored: the next alloc reuses the freed entry.
+    REQUIRE(irr::model_index(copy.nodes.get_id(copy.nodes.alloc())) ==
+            irr::model_index(garbage));
+    REQUIRE(irr::model_index(copy.strings.get_id(copy.strings.alloc())) == 1);
+
+    irr::FlatSimulation flat;
+    REQUIRE(flat.init(copy) == irr::status::simulation_flat_success);
+    REQUIRE(flat.simulators.size() == 3);
+
+    {
+        // A truncated snapshot empties the Model instead of mixing its
+        // items with the items of the snapshot.
+        const auto truncated =
+          std::filesystem::temp_directory_path() / "irritator-truncated.bin";
+        REQUIRE(model.write_snapshot(truncated) ==
+                irr::status::snapshot_write_success);
+        std::filesystem::resize_file(
+          truncated, std::filesystem::file_size(truncated) / 2);
+
+        irr::Model target(16);
+        const auto root = make_node(target, 0, type::coupled, 0, 0);
+        make_node(target, root, type::atomic, 0, 0);
+        make_node(target, root, type::atomic, 0, 0);
+        REQUIRE(target.nodes.size() == 3);
+
+        REQUIRE(target.read_snapshot(truncated) ==
+                irr::status::snapshot_read_error);
+        REQUIRE(target.nodes.size() == 0);
+        REQUIRE(target.conditions.size() == 0);
+        REQUIRE(target.connections.size() == 0);
+        REQUIRE(target.strings.size() == 0);
+        REQUIRE(target.chunks.size() == 0);
+        REQUIRE(target.nodes.capacity == 16);
+        REQUIRE(target.name.empty());
+
+        irr::Node* node = nullptr;
+        REQUIRE(!target.nodes.next(node));
+        REQUIRE(target.nodes.try_alloc() != nullptr);
+
+        std::filesystem::remove(truncated);
+    }
+
+    {
+        // An offset beyond the offsets of the file system is a read error,
+        // not a seek to a truncated offset. The offset of the first section
+        // follows the header (104 bytes) and 32 bytes of the section.
+        const auto far =
+          std::filesystem::temp_directory_path() / "irritator-far.bin";
+        REQUIRE(model.write_snapshot(far) ==
+                irr::status::snapshot_write_success);
+
+        auto* file = std::fopen(far.string().c_str(), "r+b");
+        REQUIRE(file);
+        const std::uint64_t offset = UINT64_MAX - 63;
+        std::fseek(file, 104 + 32, SEEK_SET);
+        std::fwrite(&offset, sizeof(offset), 1, file);
+        std::fclose(file);
+
+        irr::Model target(16);
+        REQUIRE(target.read_snapshot(far) ==
+                irr::status::snapshot_read_error);
+        REQUIRE(target.nodes.size() == 0);
+
+        std::filesystem::remove(far);
+    }
+
+    {
+        auto* file = std::fopen(file_name.string().c_str(), "r+b");
+        REQUIRE(file);
+        const std::uint32_t version = 99;
+        std::fseek(file, 8, SEEK_SET);
+        std::fwrite(&version, sizeof(version), 1, file);
+        std::fclose(file);
+    }
+
+    REQUIRE(copy.read_snapshot(file_name) ==
+            irr::status::snapshot_bad_version);
+    REQUIRE(copy.nodes.size() == 4);
+
+    {
+        auto* file = std::fopen(file_name.string().c_str(), "wb");
+        REQUIRE(file);
+        std::fputs("{ \"name\": \"a json file\" }", file);
+        std::fclose(file);
+    }
+
+    REQUIRE(copy.read_snapshot(file_name) ==
+            irr::status::snapshot_bad_format);
+
+    std::filesystem::remove(file_name);
+}
+
+TEST_CASE("check irr::thread_pool api", "[lib/simulation]")
+{
+    irr::thread_pool pool(4);
+    REQUIRE(pool.size() == 4);
+
+    std::vector<int> x(10000, 0);
+    for (int loop = 0; loop != 100; ++loop)
+        pool.parallel_for(0, 10000, [&x](int i) { x[i] += i % 7; });
+
+    long long sum = 0;
+    for (int i = 0; i != 10000; ++i) {
+        REQUIRE(x[i] == 100 * (i % 7));
+        sum += x[i];
+    }
+
+    std::atomic<long long> parallel_sum{ 0 };
+    pool.parallel_for_range(0, 10000, 3, [&](int begin, int end) {
+        long long local = 0;
+        for (int i = begin; i != end; ++i)
+            local += x[i];
+        parallel_sum += local;
+    });
+
+    REQUIRE(parallel_sum == sum);
+}
+
+namespace {
+
+struct generator : irr::AtomicDynamics
+{
+    double period;
+    double value = 0.0;
+
+    explicit generator(double period_)
+      : period(period_)
+    {}
+
+    double initialize(double /*t*/) noexcept override
+    {
+        return 0.0;
+    }
+
+    void lambda(irr::Outputs& outputs) noexcept override
+    {
+        outputs.emit(0, value);
+    }
+
+    double internal(double /*t*/) noexcept override
+    {
+        value += 1.0;
+        return period;
+    }
+
+    double external(double /*t*/,
+                    double e,
+                    const irr::Bag& /*bag*/) noexcept override
+    {
+        return period - e;
+    }
+
+    int state_size() const noexcept override
+    {
+        return sizeof(value);
+    }
+
+    void save(void* buffer) const noexcept override
+    {
+        std::memcpy(buffer, &value, sizeof(value));
+    }
+
+    void restore(const void* buffer) noexcept override
+    {
+        std::memcpy(&value, buffer, sizeof(value));
+    }
+
+    // Without input port, only the internal transition is called.
+    double lookahead() const noexcept override
+    {
+        return period;
+    }
+};
+
+struct counter : irr::AtomicDynamics
+{
+    int number = 0;
+    double sum = 0.0;
+    double last = 0.0;
+
+    double initialize(double /*t*/) noexcept override
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    void lambda(irr::Outputs& /*outputs*/) noexcept override
+    {}
+
+    double internal(double /*t*/) noexcept override
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    double external(double t,
+                    double /*e*/,
+                    const irr::Bag& bag) noexcept override
+    {
+        for (const auto& msg : bag) {
+            ++number;
+            sum += bag.real64(msg);
+        }
+
+        last = t;
+        return std::numeric_limits<double>::infinity();
+    }
+
+    struct state
+    {
+        int number;
+        double sum;
+        double last;
+    };
+
+    int state_size() const noexcept override
+    {
+        return sizeof(state);
+    }
+
+    void save(void* buffer) const noexcept override
+    {
+        const state s{ number, sum, last };
+        std::memcpy(buffer, &s, sizeof(s));
+    }
+
+    void restore(const void* buffer) noexcept override
+    {
+        state s;
+        std::memcpy(&s, buffer, sizeof(s));
+        number = s.number;
+        sum = s.sum;
+        last = s.last;
+    }
+};
+
+struct counter_model
+{
+    irr::Model model{ 256 };
+    irr::FlatSimulation flat;
+    std::vector<std::unique_ptr<generator>> generators;
+    std::vector<std::unique_ptr<counter>> counters;
+
+    // Builds a coupled model of @c width generators each connected to
+    // @c width counters through a coupled model.
+    explicit counter_model(int width)
+    {
+        using type = irr::Node::model_type;
+
+        const auto top = make_node(model, 0, type::coupled, 0, 0);
+        const auto sink = make_node(model, top, type::coupled, 1, 0);
+
+        for (int i = 0; i != width; ++i) {
+            const auto gen = make_node(model, top, type::atomic, 0, 1);
+            make_connection(model, top, gen, 0, sink, 0);
+
+            const auto cnt = make_node(model, sink, type::atomic, 1, 0);
+            make_connection(model, sink, sink, 0, cnt, 0);
+        }
+
+        REQUIRE(flat.init(model) == irr::status::simulation_flat_success);
+
+        irr::Simulator* sim = nullptr;
+        int i = 0;
+        while (flat.simulators.next(sim)) {
+            if (sim->output_slots_number == 1) {
+                generators.emplace_back(
+                  std::make_unique<generator>(1.0 + (i++ % 3)));
+                sim->atomic = generators.back().get();
+            } else {
+                counters.emplace_back(std::make_unique<counter>());
+                sim->atomic = counters.back().get();
+            }
+        }
+    }
+};
+
+} // anonymous namespace
+
+TEST_CASE("check irr::FlatSimulation parallel bag", "[lib/simulation]")
+{
+    counter_model sequential(8), parallel(8);
+    irr::thread_pool pool(4);
+
+    REQUIRE(sequential.flat.initialize(0.f, 10.f));
+    REQUIRE(parallel.flat.initialize(0.f, 10.f));
+
+    sequential.flat.run();
+    parallel.flat.run(pool);
+
+    REQUIRE(sequential.counters.size() == 8);
+    REQUIRE(parallel.counters.size() == 8);
+
+    // Generators of period 1, 2, 3 sends at t = 0, 1, ..., 9.
+    const int expected = 3 * 10 + 3 * 5 + 2 * 4;
+
+    for (int i = 0; i != 8; ++i) {
+        REQUIRE(sequential.counters[i]->number == expected);
+        REQUIRE(parallel.counters[i]->number == expected);
+        REQUIRE(sequential.counters[i]->sum == parallel.counters[i]->sum);
+        REQUIRE(sequential.counters[i]->last == 9.0);
+    }
+}
+
+TEST_CASE("check irr::spsc_queue api", "[lib/simulation]")
+{
+    irr::spsc_queue<int> queue;
+
+    REQUIRE(!queue.init(3));
+    REQUIRE(queue.init(4));
+    REQUIRE(queue.capacity() == 4);
+    REQUIRE(queue.empty());
+
+    for (int i = 0; i != 4; ++i)
+        REQUIRE(queue.push(i));
+    REQUIRE(!queue.push(4));
+
+    int value = -1;
+    REQUIRE(queue.pop(value));
+    REQUIRE(value == 0);
+    REQUIRE(queue.push(4));
+
+    for (int i = 1; i != 5; ++i) {
+        REQUIRE(queue.pop(value));
+        REQUIRE(value == i);
+    }
+
+    REQUIRE(!queue.pop(value));
+    REQUIRE(queue.empty());
+
+    constexpr int number = 100000;
+    long long sum = 0;
+
+    std::thread producer([&queue]() {
+        for (int i = 1; i <= number; ++i)
+            while (!queue.push(i))
+                std::this_thread::yield();
+    });
+
+    for (int i = 1; i <= number; ++i) {
+        while (!queue.pop(value))
+            std::this_thread::yield();
+        REQUIRE(value == i);
+        sum += value;
+    }
+
+    producer.join();
+    REQUIRE(sum == static_cast<long long>(number) * (number + 1) / 2);
+}
+
+TEST_CASE("check irr::TimeWarp", "[lib/simulation]")
+{
+    counter_model sequential(8);
+    REQUIRE(sequential.flat.initialize(0.f, 10.f));
+    sequential.flat.run();
+
+    for (int partitions : { 1, 2, 3, 4 }) {
+        counter_model optimistic(8);
+        irr::TimeWarp tw;
+
+        // Small queues to check the flow control between partitions.
+        REQUIRE(tw.initialize(optimistic.flat, partitions, 0.f, 10.f, 4));
+        tw.run();
+
+        const auto stats = tw.statistics();
+        REQUIRE(stats.rolled_back_steps <= stats.steps);
+        REQUIRE(stats.anti_messages <= stats.messages);
+        REQUIRE(stats.gvt_rounds > 0);
+        if (partitions == 1)
+            REQUIRE(stats.rollbacks == 0);
+
+        REQUIRE(tw.gvt.load() >= 10.f);
+        REQUIRE(optimistic.counters.size() == 8);
+
+        for (int i = 0; i != 8; ++i) {
+            REQUIRE(optimistic.counters[i]->number ==
+                    sequential.counters[i]->number);
+            REQUIRE(optimistic.counters[i]->sum ==
+                    sequential.counters[i]->sum);
+            REQUIRE(optimistic.counters[i]->last ==
+                    sequential.counters[i]->last);
+        }
+
+        for (std::size_t i = 0; i != optimistic.generators.size(); ++i)
+            REQUIRE(optimistic.generators[i]->value ==
+                    sequential.generators[i]->value);
+    }
+}
+
+TEST_CASE("check irr::spin_barrier", "[lib/simulation]")
+{
+    constexpr int workers = 4;
+    constexpr int rounds = 1000;
+
+    irr::spin_barrier barrier(workers);
+    std::vector<int> counters(workers, 0);
+    std::atomic<int> errors{ 0 };
+
+    auto work = [&](int id) {
+        for (int i = 0; i != rounds; ++i) {
+            counters[id] = i + 1;
+            barrier.wait();
+
+            for (int j = 0; j != workers; ++j)
+                if (counters[j] != i + 1)
+                    ++errors;
+
+            barrier.wait();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i != workers; ++i)
+        threads.emplace_back(work, i);
+
+    work(0);
+
+    for (auto& thread : threads)
+        thread.join();
+
+    REQUIRE(errors.load() == 0);
+}
+
+TEST_CASE("check irr::Conservative", "[lib/simulation]")
+{
+    counter_model sequential(8);
+    REQUIRE(sequential.flat.initialize(0.f, 10.f));
+    sequential.flat.run();
+
+    auto check = [&sequential](const counter_model& parallel) {
+        REQUIRE(parallel.counters.size() == 8);
+
+        for (int i = 0; i != 8; ++i) {
+            REQUIRE(parallel.counters[i]->number ==
+                    sequential.counters[i]->number);
+            REQUIRE(parallel.counters[i]->sum == sequential.counters[i]->sum);
+            REQUIRE(parallel.counters[i]->last ==
+                    sequential.counters[i]->last);
+        }
+
+        for (std::size_t i = 0; i != parallel.generators.size(); ++i)
+            REQUIRE(parallel.generators[i]->value ==
+                    sequential.generators[i]->value);
+    };
+
+    for (int partitions : { 1, 2, 3, 4 }) {
+        counter_model conservative(8);
+        irr::Conservative engine;
+
+        // Small queues to check the flow control between partitions.
+        REQUIRE(
+          engine.initialize(conservative.flat, partitions, 0.f, 10.f, 4));
+        engine.run();
+
+        const auto stats = engine.statistics();
+        REQUIRE(stats.epochs > 0);
+        REQUIRE(stats.lockstep_bags > 0);
+        if (partitions == 1)
+            REQUIRE(stats.messages == 0);
+
+        check(conservative);
+    }
+
+    SECTION("lookahead windows")
+    {
+        // Generators in the first partition, counters in the second: the
+        // first partition never waits for the second one.
+        counter_model conservative(8);
+        std::vector<int> owner(conservative.flat.simulators.capacity, 0);
+
+        irr::Simulator* sim = nullptr;
+        while (conservative.flat.simulators.next(sim))
+            if (sim->output_slots_number == 0)
+                owner[irr::model_index(
+                  conservative.flat.simulators.get_id(*sim))] = 1;
+
+        irr::Conservative engine;
+        REQUIRE(engine.initialize(conservative.flat, owner, 2, 0.f, 10.f));
+        engine.run();
+
+        const auto stats = engine.statistics();
+        REQUIRE(stats.window_bags > 0);
+        REQUIRE(stats.epochs < 10);
+
+        check(conservative);
+    }
+}
+
+namespace {
+
+struct builtin_model
+{
+    irr::Model model{ 64 };
+    irr::FlatSimulation flat;
+
+    irr::counter* delayed = nullptr;
+    irr::counter* crossed = nullptr;
+    irr::counter* products = nullptr;
+    irr::counter* quantized = nullptr;
+    int integrated = -1;
+
+    // time_generator -> queue -> counter
+    // step_generator, constant -> adder -> cross_detector -> counter
+    // step_generator, constant -> multiplier -> counter
+    // constant -> integrator -> counter
+    builtin_model()
+    {
+        using type = irr::Node::model_type;
+
+        const auto top = make_node(model, 0, type::coupled, 0, 0);
+        const auto gen = make_node(model, top, type::atomic, 0, 1);
+        const auto queue = make_node(model, top, type::atomic, 1, 1);
+        const auto cnt1 = make_node(model, top, type::atomic, 1, 0);
+        const auto step = make_node(model, top, type::atomic, 0, 1);
+        const auto two = make_node(model, top, type::atomic, 0, 1);
+        const auto add = make_node(model, top, type::atomic, 2, 1);
+        const auto cross = make_node(model, top, type::atomic, 1, 1);
+        const auto cnt2 = make_node(model, top, type::atomic, 1, 0);
+        const auto mult = make_node(model, top, type::atomic, 2, 1);
+        const auto cnt3 = make_node(model, top, type::atomic, 1, 0);
+        const auto one = make_node(model, top, type::atomic, 0, 1);
+        const auto integ = make_node(model, top, type::atomic, 1, 1);
+        const auto cnt4 = make_node(model, top, type::atomic, 1, 0);
+
+        make_connection(model, top, gen, 0, queue, 0);
+        make_connection(model, top, queue, 0, cnt1, 0);
+        make_connection(model, top, step, 0, add, 0);
+        make_connection(model, top, two, 0, add, 1);
+        make_connection(model, top, add, 0, cross, 0);
+        make_connection(model, top, cross, 0, cnt2, 0);
+        make_connection(model, top, step, 0, mult, 0);
+        make_connection(model, top, two, 0, mult, 1);
+        make_connection(model, top, mult, 0, cnt3, 0);
+        make_connection(model, top, one, 0, integ, 0);
+        make_connection(model, top, integ, 0, cnt4, 0);
+
+        REQUIRE(flat.init(model) == irr::status::simulation_flat_success);
+
+        irr::Simulator* sim = nullptr;
+        while (flat.simulators.next(sim)) {
+            if (sim->node == gen) {
+                flat.alloc_dynamics<irr::time_generator>(*sim)->period = 1.0;
+            } else if (sim->node == queue) {
+                flat.alloc_dynamics<irr::queue>(*sim)->delay = 0.5f;
+            } else if (sim->node == step) {
+                auto* dyn = flat.alloc_dynamics<irr::step_generator>(*sim);
+                dyn->before = 1.0;
+                dyn->after = 3.0;
+                dyn->step_time = 5.0;
+            } else if (sim->node == two) {
+                flat.alloc_dynamics<irr::constant>(*sim)->value = 2.0;
+            } else if (sim->node == one) {
+                flat.alloc_dynamics<irr::constant>(*sim)->value = 1.0;
+            } else if (sim->node == add) {
+                flat.alloc_dynamics<irr::adder>(*sim);
+            } else if (sim->node == cross) {
+                flat.alloc_dynamics<irr::cross_detector>(*sim)->threshold =
+                  4.0;
+            } else if (sim->node == mult) {
+                flat.alloc_dynamics<irr::multiplier>(*sim);
+            } else if (sim->node == integ) {
+                integrated = flat.alloc_integrator(*sim);
+                flat.builtins.integrators.dq[integrated] = 0.5;
+            } else if (sim->node == cnt1) {
+                delayed = flat.alloc_dynamics<irr::counter>(*sim);
+            } else if (sim->node == cnt2) {
+                crossed = flat.alloc_dynamics<irr::counter>(*sim);
+            } else if (sim->node == cnt3) {
+                products = flat.alloc_dynamics<irr::counter>(*sim);
+            } else if (sim->node == cnt4) {
+                quantized = flat.alloc_dynamics<irr::counter>(*sim);
+            }
+        }
+    }
+
+    void check() const
+    {
+        // Sent at 0, 1, ..., 9 and received at 0.5, 1.5, ..., 9.5.
+        REQUIRE(delayed->number == 10);
+        // 1 + 2 then 3 + 2 at t = 5 crosses 4.
+        REQUIRE(crossed->number == 1);
+        // 1 * 2 at t = 0 then 3 * 2 at t = 5.
+        REQUIRE(products->number == 2);
+        // x = t, the state is sent every 0.5 from t = 0.5 to t = 9.5.
+        REQUIRE(quantized->number == 19);
+        REQUIRE(flat.builtins.integrators.x[integrated] == Approx(9.5));
+    }
+};
+
+} // anonymous namespace
+
+TEST_CASE("check built-in dynamics", "[lib/simulation]")
+{
+    SECTION("sequential")
+    {
+        builtin_model m;
+        REQUIRE(m.flat.initialize(0.f, 10.f));
+        m.flat.run();
+        m.check();
+    }
+
+    SECTION("thread pool")
+    {
+        builtin_model m;
+        irr::thread_pool pool(4);
+        REQUIRE(m.flat.initialize(0.f, 10.f));
+        m.flat.run(pool);
+        m.check();
+    }
+
+    SECTION("time warp")
+    {
+        builtin_model m;
+        irr::TimeWarp tw;
+        REQUIRE(tw.initialize(m.flat, 3, 0.f, 10.f));
+        tw.run();
+        m.check();
+    }
+
+    SECTION("conservative")
+    {
+        builtin_model m;
+        irr::Conservative engine;
+        REQUIRE(engine.initialize(m.flat, 3, 0.f, 10.f));
+        engine.run();
+        m.check();
+    }
+}
+
+namespace {
+
+struct recorder : irr::AtomicDynamics
+{
+    std::vector<double> values;
+    double min_elapsed = 0.0;
+
+    double initialize(double /*t*/) noexcept override
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    void lambda(irr::Outputs& /*outputs*/) noexcept override
+    {}
+
+    double internal(double /*t*/) noexcept override
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    double external(double /*t*/,
+                    double e,
+                    const irr::Bag& bag) noexcept override
+    {
+        for (const auto& msg : bag)
+            values.emplace_back(bag.real64(msg));
+
+        min_elapsed = std::min(min_elapsed, e);
+        return std::numeric_limits<double>::infinity();
+    }
+};
+
+// Sleeps during its internal transition at t = 1: the partition of the
+// sleeper lags behind the other partitions.
+struct sleeper : irr::AtomicDynamics
+{
+    double initialize(double /*t*/) noexcept override
+    {
+        return 1.0;
+    }
+
+    void lambda(irr::Outputs& /*outputs*/) noexcept override
+    {}
+
+    double internal(double /*t*/) noexcept override
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        return std::numeric_limits<double>::infinity();
+    }
+
+    double external(double /*t*/,
+                    double /*e*/,
+                    const irr::Bag& /*bag*/) noexcept override
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+};
+
+// constant (offset 5) -> recorder <- time_generator (period 1): the
+// constant and a sleeper in the first partition.
+struct late_constant_model
+{
+    irr::Model model{ 16 };
+    irr::FlatSimulation flat;
+    recorder rec;
+    sleeper slow;
+    std::vector<int> owner;
+
+    late_constant_model()
+    {
+        using type = irr::Node::model_type;
+
+        const auto top = make_node(model, 0, type::coupled, 0, 0);
+        const auto cst = make_node(model, top, type::atomic, 0, 1);
+        const auto gen = make_node(model, top, type::atomic, 0, 1);
+        const auto rcv = make_node(model, top, type::atomic, 1, 0);
+        const auto slp = make_node(model, top, type::atomic, 0, 0);
+
+        make_connection(model, top, cst, 0, rcv, 0);
+        make_connection(model, top, gen, 0, rcv, 0);
+
+        REQUIRE(flat.init(model) == irr::status::simulation_flat_success);
+
+        owner.assign(flat.simulators.capacity, 1);
+
+        irr::Simulator* sim = nullptr;
+        while (flat.simulators.next(sim)) {
+            if (sim->node == cst) {
+                auto* dyn = flat.alloc_dynamics<irr::constant>(*sim);
+                dyn->value = 5.0;
+                dyn->offset = 5.0;
+                owner[irr::model_index(flat.simulators.get_id(*sim))] = 0;
+            } else if (sim->node == gen) {
+                flat.alloc_dynamics<irr::time_generator>(*sim);
+            } else if (sim->node == slp) {
+                sim->atomic = &slow;
+                owner[irr::model_index(flat.simulators.get_id(*sim))] = 0;
+            } else {
+                sim->atomic = &rec;
+            }
+        }
+    }
+};
+
+} // anonymous namespace
+
+TEST_CASE("check irr::Conservative infinite lookahead", "[lib/simulation]")
+{
+    late_constant_model sequential;
+    REQUIRE(sequential.flat.initialize(0.f, 10.f));
+    sequential.flat.run();
+
+    const std::vector<double> expected{ 0, 1, 2, 3, 4, 5, 5, 6, 7, 8, 9 };
+    REQUIRE(sequential.rec.values == expected);
+
+    // The lookahead of the constant is infinite but the internal events of
+    // its partition bound the window of the other partition.
+    late_constant_model conservative;
+    irr::Conservative engine;
+    REQUIRE(engine.initialize(
+      conservative.flat, conservative.owner, 2, 0.f, 10.f));
+    engine.run();
+
+    REQUIRE(conservative.rec.values == sequential.rec.values);
+    REQUIRE(conservative.rec.min_elapsed == 0.0);
+}
+
+namespace {
+
+// A time_generator (period 0.3) sends to a time_generator, a constant
+// (offset 2.5) and a step_generator (step time 2.5), each recorded: the
+// received messages must not move nor cancel the outputs of the sources.
+struct pinged_sources_model
+{
+    irr::Model model{ 16 };
+    irr::FlatSimulation flat;
+    recorder ticks;
+    recorder constants;
+    recorder steps;
+    std::vector<int> owner;
+
+    pinged_sources_model()
+    {
+        using type = irr::Node::model_type;
+
+        const auto top = make_node(model, 0, type::coupled, 0, 0);
+        const auto png = make_node(model, top, type::atomic, 0, 1);
+        const auto gen = make_node(model, top, type::atomic, 1, 1);
+        const auto cst = make_node(model, top, type::atomic, 1, 1);
+        const auto stp = make_node(model, top, type::atomic, 1, 1);
+        const auto rg = make_node(model, top, type::atomic, 1, 0);
+        const auto rc = make_node(model, top, type::atomic, 1, 0);
+        const auto rs = make_node(model, top, type::atomic, 1, 0);
+
+        make_connection(model, top, png, 0, gen, 0);
+        make_connection(model, top, png, 0, cst, 0);
+        make_connection(model, top, png, 0, stp, 0);
+        make_connection(model, top, gen, 0, rg, 0);
+        make_connection(model, top, cst, 0, rc, 0);
+        make_connection(model, top, stp, 0, rs, 0);
+
+        REQUIRE(flat.init(model) == irr::status::simulation_flat_success);
+
+        // The sources in the second partition.
+        owner.assign(flat.simulators.capacity, 0);
+
+        irr::Simulator* sim = nullptr;
+        while (flat.simulators.next(sim)) {
+            const auto index = irr::model_index(flat.simulators.get_id(*sim));
+
+            if (sim->node == png) {
+                flat.alloc_dynamics<irr::time_generator>(*sim)->period = 0.3;
+            } else if (sim->node == gen) {
+                flat.alloc_dynamics<irr::time_generator>(*sim);
+                owner[index] = 1;
+            } else if (sim->node == cst) {
+                auto* dyn = flat.alloc_dynamics<irr::constant>(*sim);
+                dyn->value = 5.0;
+                dyn->offset = 2.5;
+                owner[index] = 1;
+            } else if (sim->node == stp) {
+                flat.alloc_dynamics<irr::step_generator>(*sim)->step_time =
+                  2.5;
+                owner[index] = 1;
+            } else if (sim->node == rg) {
+                sim->atomic = &ticks;
+            } else if (sim->node == rc) {
+                sim->atomic = &constants;
+            } else {
+                sim->atomic = &steps;
+            }
+        }
+    }
+
+    void check() const
+    {
+        const std::vector<double> expected_ticks{ 0, 1, 2, 3, 4,
+                                                  5, 6, 7, 8, 9 };
+        const std::vector<double> expected_constants{ 5 };
+        const std::vector<double> expected_steps{ 0, 1 };
+
+        REQUIRE(ticks.values == expected_ticks);
+        REQUIRE(constants.values == expected_constants);
+        REQUIRE(steps.values == expected_steps);
+    }
+};
+
+} // anonymous namespace
+
+TEST_CASE("check sources receiving messages", "[lib/simulation]")
+{
+    SECTION("sequential")
+    {
+        pinged_sources_model m;
+        REQUIRE(m.flat.initialize(0.f, 10.f));
+        m.flat.run();
+        m.check();
+    }
+
+    // The sources keep their next output when they receive a message: the
+    // lookahead of their partition holds.
+    SECTION("conservative")
+    {
+        pinged_sources_model m;
+        irr::Conservative engine;
+        REQUIRE(engine.initialize(m.flat, m.owner, 2, 0.f, 10.f));
+        engine.run();
+        m.check();
+    }
+}
+
+namespace {
+
+// Emits, in a same bag, a vector and many reals: more values than the
+// capacity of the Values of the FlatSimulation.
+struct burst : irr::AtomicDynamics
+{
+    static constexpr int length = 100;
+
+    double initialize(double /*t*/) noexcept override
+    {
+        return 1.0;
+    }
+
+    void lambda(irr::Outputs& outputs) noexcept override
+    {
+        double values[length];
+        for (int i = 0; i < length; ++i)
+            values[i] = i;
+
+        outputs.emit(0, values, length);
+        for (int i = 0; i < length; ++i)
+            outputs.emit(0, static_cast<double>(length + i));
+    }
+
+    double internal(double /*t*/) noexcept override
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    double external(double /*t*/,
+                    double /*e*/,
+                    const irr::Bag& /*bag*/) noexcept override
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+};
+
+struct burst_sink : irr::AtomicDynamics
+{
+    std::vector<double> values;
+
+    double initialize(double /*t*/) noexcept override
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    void lambda(irr::Outputs& /*outputs*/) noexcept override
+    {}
+
+    double internal(double /*t*/) noexcept override
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    double external(double /*t*/,
+                    double /*e*/,
+                    const irr::Bag& bag) noexcept override
+    {
+        for (const auto& msg : bag)
+            for (int i = 0; i < msg.value.size; ++i)
+                values.emplace_back(bag.real64(msg, i));
+
+        return std::numeric_limits<double>::infinity();
+    }
+};
+
+} // anonymous namespace
+
+TEST_CASE("check irr::Values growth", "[lib/simulation]")
+{
+    using type = irr::Node::model_type;
+
+    irr::Model model{ 16 };
+    const auto top = make_node(model, 0, type::coupled, 0, 0);
+    const auto src = make_node(model, top, type::atomic, 0, 1);
+    const auto dst = make_node(model, top, type::atomic, 1, 0);
+    make_connection(model, top, src, 0, dst, 0);
+
+    irr::FlatSimulation flat;
+    REQUIRE(flat.init(model) == irr::status::simulation_flat_success);
+
+    burst gen;
+    burst_sink sink;
+    irr::Simulator* sim = nullptr;
+    while (flat.simulators.next(sim))
+        sim->atomic = sim->node == src
+                        ? static_cast<irr::AtomicDynamics*>(&gen)
+                        : static_cast<irr::AtomicDynamics*>(&sink);
+
+    REQUIRE(flat.initialize(0.f, 10.f));
+    flat.run();
+
+    REQUIRE(sink.values.size() == 2u * burst::length);
+    for (int i = 0; i < 2 * burst::length; ++i)
+        REQUIRE(sink.values[i] == static_cast<double>(i));
+}
+
+TEST_CASE("check integrator_array", "[lib/simulation]")
+{
+    constexpr int size = 1000;
+
+    irr::integrator_array columns;
+    REQUIRE(columns.init(size));
+    std::vector<irr::integrator> objects(size);
+    std::vector<int> batch;
+
+    for (int i = 0; i != size; ++i) {
+        REQUIRE(columns.alloc() == i);
+
+        objects[i].x = i * 0.25;
+        objects[i].u = (i % 7) - 3.5;
+        objects[i].dq = 0.01 * (1 + i % 5);
+        objects[i].initialize(0.0);
+        columns.store(i, objects[i]);
+
+        if (i % 3 != 0)
+            batch.push_back(i);
+    }
+
+    REQUIRE(columns.full());
+    REQUIRE(columns.alloc() == -1);
+
+    for (int step = 0; step != 10; ++step) {
+        columns.internal(batch.data(), static_cast<int>(batch.size()));
+        for (auto i : batch)
+            objects[i].internal(0.0);
+    }
+
+    for (int i = 0; i != size; ++i) {
+        const auto integ = columns.load(i);
+        REQUIRE(integ.x == objects[i].x);
+        REQUIRE(integ.q == objects[i].q);
+        REQUIRE(integ.sigma == objects[i].sigma);
+    }
+}
+
+TEST_CASE("check min_positive_root", "[lib/simulation]")
+{
+    const auto inf = std::numeric_limits<double>::infinity();
+
+    // 2 s - 4, s^2 - 5 s + 6, s^2 + 1 and -s^2 - s + 2.
+    REQUIRE(irr::min_positive_root(0.0, 2.0, -4.0) == Approx(2.0));
+    REQUIRE(irr::min_positive_root(1.0, -5.0, 6.0) == Approx(2.0));
+    REQUIRE(irr::min_positive_root(1.0, 0.0, 1.0) == inf);
+    REQUIRE(irr::min_positive_root(-1.0, -1.0, 2.0) == Approx(1.0));
+
+    // (s - 1)(s - 2)(s - 3), (s + 1)(s^2 + 1) and s^3 - 8.
+    REQUIRE(irr::min_positive_root(1.0, -6.0, 11.0, -6.0) == Approx(1.0));
+    REQUIRE(irr::min_positive_root(1.0, 1.0, 1.0, 1.0) == inf);
+    REQUIRE(irr::min_positive_root(1.0, 0.0, 0.0, -8.0) == Approx(2.0));
+}
+
+TEST_CASE("check integrator kernels", "[lib/simulation]")
+{
+    // Not a multiple of the kernel width to run the scalar remainder too.
+    constexpr int size = 1003;
+
+    const auto width = irr::integrator_kernel_width();
+    REQUIRE((width == 1 || width == 4 || width == 8));
+
+    irr::qss2_integrator_array qss2;
+    irr::qss3_integrator_array qss3;
+    REQUIRE(qss2.init(size));
+    REQUIRE(qss3.init(size));
+
+    std::vector<irr::qss2_integrator> objects2(size);
+    std::vector<irr::qss3_integrator> objects3(size);
+    std::vector<int> batch;
+
+    for (int i = 0; i != size; ++i) {
+        REQUIRE(qss2.alloc() == i);
+        REQUIRE(qss3.alloc() == i);
+
+        objects2[i].x = objects3[i].x = i * 0.25;
+        objects2[i].u = objects3[i].u = (i % 7) - 3.5;
+        objects2[i].mu = objects3[i].mu = (i % 5) - 2.0;
+        objects3[i].pu = (i % 3) - 1.0;
+        objects2[i].dq = objects3[i].dq = 0.01 * (1 + i % 5);
+        objects2[i].initialize(0.0);
+        objects3[i].initialize(0.0);
+
+        if (objects2[i].sigma != irr::qss2_integrator::infinity &&
+            objects3[i].sigma != irr::qss3_integrator::infinity)
+            batch.push_back(i);
+    }
+
+    // The kernels gather and scatter any order of columns.
+    std::reverse(batch.begin(), batch.end());
+
+    for (int i = 0; i != size; ++i) {
+        qss2.store(i, objects2[i]);
+        qss3.store(i, objects3[i]);
+    }
+
+    for (int step = 0; step != 5; ++step) {
+        qss2.internal(batch.data(), static_cast<int>(batch.size()));
+        qss3.internal(batch.data(), static_cast<int>(batch.size()));
+
+        for (auto i : batch) {
+            objects2[i].internal(0.0);
+            objects3[i].internal(0.0);
+        }
+    }
+
+    for (int i = 0; i != size; ++i) {
+        const auto integ2 = qss2.load(i);
+        REQUIRE(integ2.x == Approx(objects2[i].x));
+        REQUIRE(integ2.u == Approx(objects2[i].u));
+        REQUIRE(integ2.q == Approx(objects2[i].q));
+        REQUIRE(integ2.mq == Approx(objects2[i].mq));
+        REQUIRE(integ2.sigma == Approx(objects2[i].sigma));
+
+        const auto integ3 = qss3.load(i);
+        REQUIRE(integ3.x == Approx(objects3[i].x));
+        REQUIRE(integ3.u == Approx(objects3[i].u));
+        REQUIRE(integ3.mu == Approx(objects3[i].mu));
+        REQUIRE(integ3.pq == Approx(objects3[i].pq));
+        REQUIRE(integ3.sigma == Approx(objects3[i].sigma));
+    }
+}
+
+namespace {
+
+// constant 1 -> integrator -> integrator -> integrator: the states are t,
+// t^2 / 2 and t^3 / 6.
+template<typename Integrator>
+struct qss_chain
+{
+    irr::Model model{ 64 };
+    irr::FlatSimulation flat;
+    irr::Simulator* last = nullptr;
+    int column = -1;
+
+    qss_chain()
+    {
+        using type = irr::Node::model_type;
+
+        const auto top = make_node(model, 0, type::coupled, 0, 0);
+        const auto one = make_node(model, top, type::atomic, 0, 1);
+        const auto i1 = make_node(model, top, type::atomic, 1, 1);
+        const auto i2 = make_node(model, top, type::atomic, 1, 1);
+        const auto i3 = make_node(model, top, type::atomic, 1, 1);
+
+        make_connection(model, top, one, 0, i1, 0);
+        make_connection(model, top, i1, 0, i2, 0);
+        make_connection(model, top, i2, 0, i3, 0);
+
+        REQUIRE(flat.init(model) == irr::status::simulation_flat_success);
+
+        irr::Simulator* sim = nullptr;
+        while (flat.simulators.next(sim)) {
+            if (sim->node == one) {
+                flat.alloc_dynamics<irr::constant>(*sim)->value = 1.0;
+            } else {
+                const auto i = flat.alloc_integrator<Integrator>(*sim);
+                REQUIRE(i >= 0);
+                flat.builtins.get_columns<Integrator>().dq[i] = 0.01;
+
+                if (sim->node == i3) {
+                    last = sim;
+                    column = i;
+                }
+            }
+        }
+    }
+
+    double value(float t)
+    {
+        const auto integ = flat.builtins.get_columns<Integrator>().load(column);
+        const double e = t - last->tl;
+
+        if constexpr (std::is_same_v<Integrator, irr::qss2_integrator>)
+            return integ.x + (integ.u + 0.5 * integ.mu * e) * e;
+        else
+            return integ.x +
+                   (integ.u + (0.5 * integ.mu + integ.pu / 3.0 * e) * e) * e;
+    }
+};
+
+template<typename Integrator>
+void
+check_qss_chain()
+{
+    const auto expected = 1000.0 / 6.0;
+
+    {
+        qss_chain<Integrator> chain;
+        REQUIRE(chain.flat.initialize(0.f, 10.f));
+        chain.flat.run();
+        REQUIRE(chain.value(10.f) == Approx(expected).epsilon(0.01));
+    }
+
+    {
+        qss_chain<Integrator> chain;
+        irr::thread_pool pool(4);
+        REQUIRE(chain.flat.initialize(0.f, 10.f));
+        chain.flat.run(pool);
+        REQUIRE(chain.value(10.f) == Approx(expected).epsilon(0.01));
+    }
+
+    {
+        qss_chain<Integrator> chain;
+        irr::TimeWarp tw;
+        REQUIRE(tw.initialize(chain.flat, 2, 0.f, 10.f));
+        tw.run();
+        REQUIRE(chain.value(10.f) == Approx(expected).epsilon(0.01));
+    }
+
+    {
+        qss_chain<Integrator> chain;
+        irr::Conservative engine;
+        REQUIRE(engine.initialize(chain.flat, 2, 0.f, 10.f));
+        engine.run();
+        REQUIRE(chain.value(10.f) == Approx(expected).epsilon(0.01));
+    }
+}
+
+} // anonymous namespace
+
+TEST_CASE("check QSS2 and QSS3 integrators", "[lib/simulation]")
+{
+    SECTION("qss2")
+    {
+        check_qss_chain<irr::qss2_integrator>();
+    }
+
+    SECTION("qss3")
+    {
+        check_qss_chain<irr::qss3_integrator>();
+    }
+}
+
+TEST_CASE("check fixed_time", "[lib/simulation]")
+{
+    using time = irr::fixed_time<1000>;
+    const auto inf = std::numeric_limits<time>::infinity();
+
+    REQUIRE(static_cast<time>(0.1) + static_cast<time>(0.2) ==
+            static_cast<time>(0.3));
+    REQUIRE(static_cast<time>(1.5).ticks == 1500);
+    REQUIRE(static_cast<double>(static_cast<time>(2.25)) == 2.25);
+    REQUIRE(static_cast<time>(std::numeric_limits<float>::infinity()) == inf);
+    REQUIRE(inf + static_cast<time>(1.0) == inf);
+    REQUIRE(std::isinf(static_cast<double>(inf)));
+    REQUIRE(static_cast<time>(1.0) < inf);
+    REQUIRE(static_cast<time>(3.0) - static_cast<time>(1.0) ==
+            static_cast<time>(2.0));
+}
+
+namespace {
+
+// Two time_generators with periods 0.1 and 0.3 send to a counter: every
+// third bag of the first generator is also a bag of the second one.
+template<typename Time>
+void
+check_time_type(bool exact)
+{
+    using type = irr::Node::model_type;
+
+    irr::Model model{ 16 };
+    irr::BasicFlatSimulation<Time> flat;
+
+    const auto top = make_node(model, 0, type::coupled, 0, 0);
+    const auto fast = make_node(model, top, type::atomic, 0, 1);
+    const auto slow = make_node(model, top, type::atomic, 0, 1);
+    const auto cnt = make_node(model, top, type::atomic, 1, 0);
+
+    make_connection(model, top, fast, 0, cnt, 0);
+    make_connection(model, top, slow, 0, cnt, 0);
+
+    REQUIRE(flat.init(model) == irr::status::simulation_flat_success);
+
+    irr::counter* received = nullptr;
+    typename irr::BasicFlatSimulation<Time>::simulator_type* sim = nullptr;
+    while (flat.simulators.next(sim)) {
+        if (sim->node == fast)
+            flat.template alloc_dynamics<irr::time_generator>(*sim)->period =
+              0.1;
+        else if (sim->node == slow)
+            flat.template alloc_dynamics<irr::time_generator>(*sim)->period =
+              0.3;
+        else
+            received = flat.template alloc_dynamics<irr::counter>(*sim);
+    }
+
+    REQUIRE(flat.initialize(static_cast<Time>(0.0), static_cast<Time>(2.95)));
+    flat.run();
+
+    // Sent at 0, 0.1, ..., 2.9 and at 0, 0.3, ..., 2.7.
+    REQUIRE(received->number == 40);
+
+    // A bag for each time of the fast generator, the counter is in the
+    // next one.
+    if (exact)
+        REQUIRE(flat.bag_number == 30);
+    else
+        REQUIRE(flat.bag_number >= 30);
+}
+
+} // anonymous namespace
+
+TEST_CASE("check time types", "[lib/simulation]")
+{
+    SECTION("float")
+    {
+        check_time_type<float>(false);
+    }
+
+    SECTION("double")
+    {
+        check_time_type<double>(false);
+    }
+
+    SECTION("fixed_time")
+    {
+        check_time_type<irr::fixed_time<1000000>>(true);
+    }
+}
+
+TEST_CASE("check double times far from the origin", "[lib/simulation]")
+{
+    using type = irr::Node::model_type;
+
+    irr::Model model{ 16 };
+    irr::BasicFlatSimulation<double> flat;
+
+    const auto top = make_node(model, 0, type::coupled, 0, 0);
+    const auto gen = make_node(model, top, type::atomic, 0, 1);
+    const auto rcv = make_node(model, top, type::atomic, 1, 0);
+    make_connection(model, top, gen, 0, rcv, 0);
+
+    REQUIRE(flat.init(model) == irr::status::simulation_flat_success);
+
+    recorder rec;
+    irr::BasicFlatSimulation<double>::simulator_type* sim = nullptr;
+    while (flat.simulators.next(sim)) {
+        if (sim->node == gen)
+            flat.alloc_dynamics<irr::time_generator>(*sim)->period = 0.25;
+        else
+            sim->atomic = &rec;
+    }
+
+    // A float has a precision of 1 at 1e7: the dynamics must keep the
+    // quarters sent by the generator.
+    const double start = 1e7;
+    REQUIRE(flat.initialize(start, start + 10.0));
+    flat.run();
+
+    REQUIRE(rec.values.size() == 40u);
+    for (int i = 0; i != 40; ++i)
+        REQUIRE(rec.values[i] == start + 0.25 * i);
+}